@@ -3,56 +3,93 @@
 in vec3 fPos;
 in vec3 fNormal;
 
-out vec4 oColor;
+#include "frame.glsl"
+#include "lighting.glsl"
 
+#ifdef MULTI_DRAW
+flat in vec3 fObjectColor;
+#define uObjectColor fObjectColor
+#else
 uniform vec3 uObjectColor;
-uniform vec3 uCameraPos;
+#endif
 
-uniform vec3 uLightColor1;
-uniform vec3 uLightPos1;
+// GBUFFER: writes the surface to the G-buffer of the deferred path instead of shading it.
+#ifdef GBUFFER
 
-uniform vec3 uLightColor2;
-uniform vec3 uLightPos2;
+layout (location = 0) out vec4 oPosition;
+layout (location = 1) out vec4 oNormal;
+layout (location = 2) out vec4 oAlbedo;
 
-uniform vec3 uLightColor3;
-uniform vec3 uLightPos3;
+void main() {
+    // The w of the position marks the pixel as covered for the lighting pass.
+    oPosition = vec4(fPos, 1.0);
+    oNormal = vec4(normalize(fNormal), 0.0);
+    oAlbedo = vec4(uObjectColor, 1.0);
+}
 
-uniform vec3 uLightColor4;
-uniform vec3 uLightPos4;
+#else
 
-uniform vec3 uLightColor5;
-uniform vec3 uLightPos5;
+out vec4 oColor;
 
-uniform vec3 uLightColor6;
-uniform vec3 uLightPos6;
+// Two texels per light: position in the first, color and radius in the second.
+uniform samplerBuffer uLights;
 
-vec3 phong(vec3 lightColor, vec3 lightPosition) {
-    float ambientStrenght = 0.1;
-    vec3 ambient = ambientStrenght * lightColor;
+// CLUSTERED_LIGHTS: only the lights of the fragment's cluster are evaluated,
+// see LightClusters in light_clusters.hpp. The grid has to match it.
+#ifdef CLUSTERED_LIGHTS
 
-    vec3 normal = normalize(fNormal);
-    vec3 lightDir = normalize(lightPosition - fPos);
-    
-    float diff = max(dot(normal, lightDir), 0.0);
-    vec3 diffuse = diff * lightColor;
-
-    float specularStrenght = 0.5;
-    vec3 viewDir = normalize(uCameraPos - fPos);
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
-    vec3 specular = specularStrenght * spec * lightColor;
-
-    return ambient + diffuse + specular;
+const int CLUSTER_GRID_X = 16;
+const int CLUSTER_GRID_Y = 9;
+const int CLUSTER_GRID_Z = 24;
+
+// (offset, count) of every cluster, and the light indices of all clusters back to back.
+uniform usamplerBuffer uLightClusters;
+uniform usamplerBuffer uLightIndices;
+
+// xy: clusters per pixel, z and w: scale and bias from the log of the view depth to a slice.
+uniform vec4 uClusterParams;
+
+int clusterIndex() {
+    float depth = -(uView * vec4(fPos, 1.0)).z;
+
+    ivec3 cluster = ivec3(gl_FragCoord.xy * uClusterParams.xy, log(depth) * uClusterParams.z + uClusterParams.w);
+    cluster = clamp(cluster, ivec3(0), ivec3(CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z) - 1);
+
+    return (cluster.z * CLUSTER_GRID_Y + cluster.y) * CLUSTER_GRID_X + cluster.x;
+}
+
+// LIGHT_COUNT fixes the number of lights at compile time so the loop can be unrolled.
+#elif defined(LIGHT_COUNT)
+const int lightCount = LIGHT_COUNT;
+#else
+uniform int uLightCount;
+#define lightCount uLightCount
+#endif
+
+vec3 shadeLight(int light, vec3 normal) {
+    vec3 lightPos = texelFetch(uLights, light * 2).xyz;
+    vec4 lightColor = texelFetch(uLights, light * 2 + 1);
+    return phong(fPos, normal, lightColor.rgb, lightPos, lightColor.a);
 }
 
 void main() {
-    vec3 light1 = phong(uLightColor1, uLightPos1);
-    vec3 light2 = phong(uLightColor2, uLightPos2);
-    vec3 light3 = phong(uLightColor3, uLightPos3);
-    vec3 light4 = phong(uLightColor4, uLightPos4);
-    vec3 light5 = phong(uLightColor5, uLightPos5);
-    vec3 light6 = phong(uLightColor6, uLightPos6);
-
-    vec3 result = clamp(light1 + light2 + light3 + light4 + light5 + light6, 0.0, 1.0) * uObjectColor;
+    vec3 normal = normalize(fNormal);
+    vec3 lighting = vec3(0.0);
+
+#ifdef CLUSTERED_LIGHTS
+    uvec2 cluster = texelFetch(uLightClusters, clusterIndex()).rg;
+
+    for (uint i = 0u; i < cluster.y; i++) {
+        lighting += shadeLight(int(texelFetch(uLightIndices, int(cluster.x + i)).r), normal);
+    }
+#else
+    for (int i = 0; i < lightCount; i++) {
+        lighting += shadeLight(i, normal);
+    }
+#endif
+
+    vec3 result = clamp(lighting, 0.0, 1.0) * uObjectColor;
     oColor = vec4(result, 1.0);
-}
\ No newline at end of file
+}
+
+#endif
@@ -1,18 +1,65 @@
 #version 330 core
 
+// MULTI_DRAW: the transform and color come from the draw data buffer that
+// RenderQueue fills, see DRAW_DATA_TEXELS in model.hpp. With draw parameters
+// a whole multi-draw shares one draw base and gl_DrawIDARB picks the entry.
+#ifdef MULTI_DRAW
+#extension GL_ARB_shader_draw_parameters : enable
+#endif
+
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 
 out vec3 fPos;
 out vec3 fNormal;
 
+#include "frame.glsl"
+
+#ifdef MULTI_DRAW
+uniform samplerBuffer uDrawData;
+uniform int uDrawBase;
+
+flat out vec3 fObjectColor;
+
+#ifdef GL_ARB_shader_draw_parameters
+#define drawIndex (uDrawBase + gl_DrawIDARB)
+#else
+#define drawIndex uDrawBase
+#endif
+#else
 uniform mat4 uModel;
-uniform mat4 uView;
-uniform mat4 uProjection;
 uniform mat3 uNormal;
+#endif
+
+// OCTAHEDRAL_NORMALS: aNormal holds two octahedral components instead of a vector.
+#ifdef OCTAHEDRAL_NORMALS
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+#endif
 
 void main() {
-    gl_Position = uProjection * uView * uModel * vec4(aPos, 1.0);
-    fPos = vec3(uModel * vec4(aPos, 1.0));
-    fNormal = uNormal * aNormal;
-}
\ No newline at end of file
+#ifdef OCTAHEDRAL_NORMALS
+    vec3 normal = decodeOctahedral(aNormal.xy);
+#else
+    vec3 normal = aNormal;
+#endif
+
+#ifdef MULTI_DRAW
+    int texel = drawIndex * 8;
+    mat4 model = mat4(texelFetch(uDrawData, texel), texelFetch(uDrawData, texel + 1), texelFetch(uDrawData, texel + 2), texelFetch(uDrawData, texel + 3));
+    mat3 normalMatrix = mat3(texelFetch(uDrawData, texel + 4).xyz, texelFetch(uDrawData, texel + 5).xyz, texelFetch(uDrawData, texel + 6).xyz);
+    fObjectColor = texelFetch(uDrawData, texel + 7).rgb;
+#else
+    mat4 model = uModel;
+    mat3 normalMatrix = uNormal;
+#endif
+
+    gl_Position = uProjection * uView * model * vec4(aPos, 1.0);
+    fPos = vec3(model * vec4(aPos, 1.0));
+    fNormal = normalMatrix * normal;
+}
@@ -0,0 +1,16 @@
+#version 330 core
+
+out vec4 oColor;
+
+uniform sampler2D uGAlbedo;
+uniform sampler2D uLighting;
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+
+    // Same as the end of cube.frag, the sum of all lights is clamped before the albedo is applied.
+    vec3 lighting = texelFetch(uLighting, pixel, 0).rgb;
+    vec3 albedo = texelFetch(uGAlbedo, pixel, 0).rgb;
+
+    oColor = vec4(clamp(lighting, 0.0, 1.0) * albedo, 1.0);
+}
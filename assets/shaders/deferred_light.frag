@@ -0,0 +1,28 @@
+#version 330 core
+
+flat in int fLight;
+
+out vec4 oLighting;
+
+#include "frame.glsl"
+#include "lighting.glsl"
+
+uniform samplerBuffer uLights;
+uniform sampler2D uGPosition;
+uniform sampler2D uGNormal;
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+
+    vec4 position = texelFetch(uGPosition, pixel, 0);
+    if (position.w == 0.0) {
+        discard;
+    }
+
+    vec3 normal = texelFetch(uGNormal, pixel, 0).xyz;
+    vec3 lightPosition = texelFetch(uLights, fLight * 2).xyz;
+    vec4 lightColor = texelFetch(uLights, fLight * 2 + 1);
+
+    // Added up over all lights by blending.
+    oLighting = vec4(phong(position.xyz, normal, lightColor.rgb, lightPosition, lightColor.a), 1.0);
+}
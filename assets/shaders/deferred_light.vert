@@ -0,0 +1,50 @@
+#version 330 core
+
+// Deferred lighting pass. One instance per light, drawn as a quad over the
+// screen space bounds of the light's sphere, so every light only shades the
+// pixels it can reach. There are no vertex attributes, the corner comes from
+// gl_VertexID of a four vertex triangle strip.
+
+#include "frame.glsl"
+
+uniform samplerBuffer uLights;
+
+flat out int fLight;
+
+void main() {
+    vec3 lightPosition = texelFetch(uLights, gl_InstanceID * 2).xyz;
+    float radius = texelFetch(uLights, gl_InstanceID * 2 + 1).a;
+
+    mat4 viewProjection = uProjection * uView;
+
+    // Bounds of the projected corners of the cube around the sphere. A corner
+    // behind the camera has no usable projection, the light then covers the screen.
+    vec2 minimum = vec2(1.0);
+    vec2 maximum = vec2(-1.0);
+    bool fullscreen = false;
+
+    for (int i = 0; i < 8; i++) {
+        vec3 corner = lightPosition + radius * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+        vec4 clip = viewProjection * vec4(corner, 1.0);
+
+        if (clip.w <= 0.0) {
+            fullscreen = true;
+            break;
+        }
+
+        minimum = min(minimum, clip.xy / clip.w);
+        maximum = max(maximum, clip.xy / clip.w);
+    }
+
+    if (fullscreen) {
+        minimum = vec2(-1.0);
+        maximum = vec2(1.0);
+    }
+
+    minimum = clamp(minimum, -1.0, 1.0);
+    maximum = clamp(maximum, minimum, vec2(1.0));
+
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    gl_Position = vec4(mix(minimum, maximum, corner), 0.0, 1.0);
+    fLight = gl_InstanceID;
+}
@@ -0,0 +1,6 @@
+// Per-frame camera data shared by every program, see FrameUniforms in uniform_buffer.hpp.
+layout (std140) uniform Frame {
+    mat4 uView;
+    mat4 uProjection;
+    vec4 uCameraPos;
+};
\ No newline at end of file
@@ -1,9 +1,9 @@
 #version 330 core
 
-out vec4 oFragColor;
+in vec3 fColor;
 
-uniform vec3 uColor;
+out vec4 oFragColor;
 
 void main() {
-    oFragColor = vec4(uColor, 1.0);
+    oFragColor = vec4(fColor, 1.0);
 }
\ No newline at end of file
@@ -2,10 +2,28 @@
 
 layout (location = 0) in vec3 aPos;
 
+// LIGHT_BUFFER_INSTANCES: positions and colors come from the light buffer,
+// indexed by instance, instead of from per-instance attributes.
+#ifdef LIGHT_BUFFER_INSTANCES
+uniform samplerBuffer uLights;
+#else
+layout (location = 4) in mat4 aInstanceTransform;
+layout (location = 8) in vec4 aInstanceColor;
+#endif
+
+out vec3 fColor;
+
+#include "frame.glsl"
+
 uniform mat4 uModel;
-uniform mat4 uView;
-uniform mat4 uProjection;
 
 void main() {
-    gl_Position = uProjection * uView * uModel * vec4(aPos, 1.0);
-}
\ No newline at end of file
+#ifdef LIGHT_BUFFER_INSTANCES
+    vec3 lightPosition = texelFetch(uLights, gl_InstanceID * 2).xyz;
+    gl_Position = uProjection * uView * (uModel * vec4(aPos, 1.0) + vec4(lightPosition, 0.0));
+    fColor = texelFetch(uLights, gl_InstanceID * 2 + 1).rgb;
+#else
+    gl_Position = uProjection * uView * aInstanceTransform * uModel * vec4(aPos, 1.0);
+    fColor = aInstanceColor.rgb;
+#endif
+}
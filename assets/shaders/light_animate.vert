@@ -0,0 +1,32 @@
+#version 330 core
+
+// Advances the light orbits on the GPU. Runs with rasterization disabled and
+// writes one Light per vertex through transform feedback, in the layout the
+// light buffer uses, so shaders can read the result with texelFetch.
+
+// Orbit around an axis through the origin, split as in LightAnimation. The w
+// component of the parallel part holds the rate in turns per second.
+layout (location = 0) in vec4 aParallel;
+layout (location = 1) in vec3 aPerpendicular;
+layout (location = 2) in vec3 aTangent;
+
+// The light from the previous pass. The w component of the position holds the current angle in turns.
+layout (location = 3) in vec4 aPosition;
+layout (location = 4) in vec4 aColor;
+
+out vec4 tfPosition;
+out vec4 tfColor;
+
+uniform float uDeltaTime;
+
+const float TWO_PI = 6.28318530718;
+
+void main() {
+    // Only the angle is carried over and it stays in [0, 1), the position is
+    // rebuilt from it every pass so the light cannot drift off its orbit.
+    float turns = fract(aPosition.w + aParallel.w * uDeltaTime);
+    float angle = turns * TWO_PI;
+
+    tfPosition = vec4(aParallel.xyz + aPerpendicular * cos(angle) + aTangent * sin(angle), turns);
+    tfColor = aColor;
+}
@@ -0,0 +1,28 @@
+// Lighting shared by the forward and the deferred path. Include after frame.glsl.
+
+// Smooth falloff that reaches zero at the light's radius, so a light has no
+// effect past it and can be limited to the pixels its sphere covers.
+float lightFalloff(float distance, float radius) {
+    float ratio = distance / radius;
+    float falloff = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+    return falloff * falloff;
+}
+
+// normal has to be normalized.
+vec3 phong(vec3 position, vec3 normal, vec3 lightColor, vec3 lightPosition, float lightRadius) {
+    float ambientStrenght = 0.1;
+    vec3 ambient = ambientStrenght * lightColor;
+
+    vec3 lightDir = normalize(lightPosition - position);
+
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 diffuse = diff * lightColor;
+
+    float specularStrenght = 0.5;
+    vec3 viewDir = normalize(uCameraPos.xyz - position);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+    vec3 specular = specularStrenght * spec * lightColor;
+
+    return (ambient + diffuse + specular) * lightFalloff(length(lightPosition - position), lightRadius);
+}
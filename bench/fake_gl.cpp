@@ -0,0 +1,197 @@
+#include "fake_gl.hpp"
+
+#include <cstring>
+
+struct FakeUniform {
+    const char* name;
+    GLenum type;
+};
+
+// Roughly what cube.vert and cube.frag expose, padded out with a few more so
+// lookups search a table of realistic size.
+static const FakeUniform fakeUniforms[] = {
+    { "uEnabled", GL_BOOL },
+    { "uExposure", GL_FLOAT },
+    { "uLightCount", GL_INT },
+    { "uLights", GL_SAMPLER_BUFFER },
+    { "uModel", GL_FLOAT_MAT4 },
+    { "uNormal", GL_FLOAT_MAT3 },
+    { "uObjectColor", GL_FLOAT_VEC3 },
+    { "uOffset", GL_FLOAT_VEC2 },
+    { "uRotation", GL_FLOAT_MAT2 },
+    { "uTexture", GL_SAMPLER_2D },
+    { "uTime", GL_FLOAT },
+    { "uTint", GL_FLOAT_VEC4 },
+};
+
+constexpr GLint FAKE_UNIFORM_COUNT = static_cast<GLint>(sizeof(fakeUniforms) / sizeof(fakeUniforms[0]));
+
+static GLuint nextName = 1;
+static size_t uniformCalls = 0;
+
+static GLuint APIENTRY fakeCreate() { return nextName++; }
+static GLuint APIENTRY fakeCreateShader(GLenum) { return nextName++; }
+static GLenum APIENTRY fakeGetError() { return GL_NO_ERROR; }
+
+static void APIENTRY fakeGen(GLsizei count, GLuint* names) {
+    for (GLsizei i = 0; i < count; i++) {
+        names[i] = nextName++;
+    }
+}
+
+static void APIENTRY fakeDeleteNames(GLsizei, const GLuint*) {}
+static void APIENTRY fakeName(GLuint) {}
+static void APIENTRY fakeNames(GLuint, GLuint) {}
+static void APIENTRY fakeEnum(GLenum) {}
+static void APIENTRY fakeEnumName(GLenum, GLuint) {}
+static void APIENTRY fakeEnumEnum(GLenum, GLenum) {}
+static void APIENTRY fakeTexBuffer(GLenum, GLenum, GLuint) {}
+static void APIENTRY fakeBoolean(GLboolean) {}
+static void APIENTRY fakeViewport(GLint, GLint, GLsizei, GLsizei) {}
+static void APIENTRY fakeBindBufferBase(GLenum, GLuint, GLuint) {}
+static void APIENTRY fakeUniformBlockBinding(GLuint, GLuint, GLuint) {}
+
+static void APIENTRY fakeGetIntegerv(GLenum pname, GLint* value) {
+    *value = pname == GL_MAX_TEXTURE_BUFFER_SIZE ? (1 << 27) : 0;
+}
+
+static void APIENTRY fakeShaderSource(GLuint, GLsizei, const GLchar* const*, const GLint*) {}
+
+static void APIENTRY fakeGetShaderiv(GLuint, GLenum pname, GLint* value) {
+    *value = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+static void APIENTRY fakeGetProgramiv(GLuint, GLenum pname, GLint* value) {
+    switch (pname) {
+        case GL_LINK_STATUS:                 *value = GL_TRUE; break;
+        case GL_ACTIVE_UNIFORMS:             *value = FAKE_UNIFORM_COUNT; break;
+        case GL_ACTIVE_UNIFORM_MAX_LENGTH:   *value = 32; break;
+        default:                             *value = 0; break;
+    }
+}
+
+static void APIENTRY fakeGetInfoLog(GLuint, GLsizei, GLsizei* length, GLchar* log) {
+    if (length) {
+        *length = 0;
+    }
+
+    if (log) {
+        log[0] = '\0';
+    }
+}
+
+static void APIENTRY fakeGetActiveUniform(GLuint, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name) {
+    const FakeUniform& uniform = fakeUniforms[index];
+    GLsizei nameLength = static_cast<GLsizei>(std::strlen(uniform.name));
+    nameLength = nameLength < bufSize ? nameLength : bufSize - 1;
+
+    std::memcpy(name, uniform.name, static_cast<size_t>(nameLength));
+    name[nameLength] = '\0';
+
+    *length = nameLength;
+    *size = 1;
+    *type = uniform.type;
+}
+
+static GLint APIENTRY fakeGetUniformLocation(GLuint, const GLchar* name) {
+    for (GLint i = 0; i < FAKE_UNIFORM_COUNT; i++) {
+        if (std::strcmp(fakeUniforms[i].name, name) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void APIENTRY fakeGetActiveUniformBlockName(GLuint, GLuint, GLsizei, GLsizei*, GLchar* name) {
+    name[0] = '\0';
+}
+
+static void APIENTRY fakeUniform1i(GLint, GLint) { uniformCalls++; }
+static void APIENTRY fakeUniform1f(GLint, GLfloat) { uniformCalls++; }
+static void APIENTRY fakeUniform2f(GLint, GLfloat, GLfloat) { uniformCalls++; }
+static void APIENTRY fakeUniform3f(GLint, GLfloat, GLfloat, GLfloat) { uniformCalls++; }
+static void APIENTRY fakeUniform4f(GLint, GLfloat, GLfloat, GLfloat, GLfloat) { uniformCalls++; }
+static void APIENTRY fakeUniformfv(GLint, GLsizei, const GLfloat*) { uniformCalls++; }
+static void APIENTRY fakeUniformMatrixfv(GLint, GLsizei, GLboolean, const GLfloat*) { uniformCalls++; }
+
+static void APIENTRY fakeBufferData(GLenum, GLsizeiptr, const void*, GLenum) {}
+static void APIENTRY fakeBufferSubData(GLenum, GLintptr, GLsizeiptr, const void*) {}
+static void APIENTRY fakeVertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) {}
+static void APIENTRY fakeDrawElements(GLenum, GLsizei, GLenum, const void*) {}
+static void APIENTRY fakeDrawElementsInstanced(GLenum, GLsizei, GLenum, const void*, GLsizei) {}
+static void APIENTRY fakeDrawElementsBaseVertex(GLenum, GLsizei, GLenum, const void*, GLint) {}
+static void APIENTRY fakeDrawElementsInstancedBaseVertex(GLenum, GLsizei, GLenum, const void*, GLsizei, GLint) {}
+static void APIENTRY fakeMultiDrawElementsBaseVertex(GLenum, const GLsizei*, GLenum, const void* const*, GLsizei, const GLint*) {}
+
+void LoadFakeGL() {
+    glad_glGetError = fakeGetError;
+
+    glad_glCreateShader = fakeCreateShader;
+    glad_glShaderSource = fakeShaderSource;
+    glad_glCompileShader = fakeName;
+    glad_glGetShaderiv = fakeGetShaderiv;
+    glad_glGetShaderInfoLog = fakeGetInfoLog;
+    glad_glDeleteShader = fakeName;
+
+    glad_glCreateProgram = fakeCreate;
+    glad_glAttachShader = fakeNames;
+    glad_glLinkProgram = fakeName;
+    glad_glGetProgramiv = fakeGetProgramiv;
+    glad_glGetProgramInfoLog = fakeGetInfoLog;
+    glad_glDeleteProgram = fakeName;
+    glad_glUseProgram = fakeName;
+
+    glad_glGetActiveUniform = fakeGetActiveUniform;
+    glad_glGetUniformLocation = fakeGetUniformLocation;
+    glad_glGetActiveUniformBlockName = fakeGetActiveUniformBlockName;
+    glad_glUniformBlockBinding = fakeUniformBlockBinding;
+
+    glad_glUniform1i = fakeUniform1i;
+    glad_glUniform1f = fakeUniform1f;
+    glad_glUniform2f = fakeUniform2f;
+    glad_glUniform3f = fakeUniform3f;
+    glad_glUniform4f = fakeUniform4f;
+    glad_glUniform2fv = fakeUniformfv;
+    glad_glUniform3fv = fakeUniformfv;
+    glad_glUniform4fv = fakeUniformfv;
+    glad_glUniformMatrix2fv = fakeUniformMatrixfv;
+    glad_glUniformMatrix3fv = fakeUniformMatrixfv;
+    glad_glUniformMatrix4fv = fakeUniformMatrixfv;
+
+    glad_glGenVertexArrays = fakeGen;
+    glad_glGenBuffers = fakeGen;
+    glad_glDeleteVertexArrays = fakeDeleteNames;
+    glad_glDeleteBuffers = fakeDeleteNames;
+    glad_glBindVertexArray = fakeName;
+    glad_glBindBuffer = fakeEnumName;
+    glad_glBindBufferBase = fakeBindBufferBase;
+    glad_glBufferData = fakeBufferData;
+    glad_glBufferSubData = fakeBufferSubData;
+    glad_glVertexAttribPointer = fakeVertexAttribPointer;
+    glad_glEnableVertexAttribArray = fakeName;
+    glad_glVertexAttribDivisor = fakeNames;
+    glad_glDrawElements = fakeDrawElements;
+    glad_glDrawElementsInstanced = fakeDrawElementsInstanced;
+    glad_glDrawElementsBaseVertex = fakeDrawElementsBaseVertex;
+    glad_glDrawElementsInstancedBaseVertex = fakeDrawElementsInstancedBaseVertex;
+    glad_glMultiDrawElementsBaseVertex = fakeMultiDrawElementsBaseVertex;
+
+    glad_glEnable = fakeEnum;
+    glad_glDisable = fakeEnum;
+    glad_glDepthMask = fakeBoolean;
+    glad_glDepthFunc = fakeEnum;
+    glad_glBlendFunc = fakeEnumEnum;
+    glad_glViewport = fakeViewport;
+
+    glad_glGetIntegerv = fakeGetIntegerv;
+    glad_glGenTextures = fakeGen;
+    glad_glDeleteTextures = fakeDeleteNames;
+    glad_glActiveTexture = fakeEnum;
+    glad_glBindTexture = fakeEnumName;
+    glad_glTexBuffer = fakeTexBuffer;
+}
+
+size_t GetFakeUniformCalls() {
+    return uniformCalls;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+// Points the glad function pointers used by Shader, Model, GLState, the light
+// clusters and GL_CHECK at stand-ins that do no GPU work, so their CPU side can
+// be measured without a context. Shaders always compile and link, and every
+// program reports the same table of active uniforms.
+void LoadFakeGL();
+
+// Number of glUniform* calls that reached the fake driver.
+size_t GetFakeUniformCalls();
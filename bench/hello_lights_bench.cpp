@@ -0,0 +1,513 @@
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "model.hpp"
+#include "uniform_buffer.hpp"
+#include "light_buffer.hpp"
+#include "gl_extensions.hpp"
+#include "gl_state.hpp"
+#include "gl_debug.hpp"
+#include "shader_library.hpp"
+#include "render_queue.hpp"
+#include "transform_system.hpp"
+#include "culling.hpp"
+#include "occlusion_culling.hpp"
+#include "deferred_renderer.hpp"
+#include "light_clusters.hpp"
+#include "geometry_pool.hpp"
+#include "thread_pool.hpp"
+
+// Renders the lit cube scene offscreen for a fixed number of frames with a
+// scripted camera and light animation, and reports frame time percentiles.
+// Every frame ends with glFinish so the time includes the GPU work.
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+constexpr float NEAR_PLANE = 0.1f;
+constexpr float FAR_PLANE = 200.0f;
+
+// Simulated time between frames, so the animation does not depend on how fast frames render.
+constexpr float FRAME_TIME_STEP = 1.0f / 60.0f;
+
+constexpr float OBJECT_SPACING = 2.5f;
+
+struct BenchOptions {
+    int frames = 1000;
+    int warmup = 60;
+    int lights = 6;
+    int objects = 1;
+    int occluders = 16;
+    int deferred = 0;
+    int clustered = 0;
+    int multiDraw = 0;
+    int width = 1280;
+    int height = 720;
+};
+
+struct EGLState {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+};
+
+static bool parseInt(const std::string& option, const char* name, int& value) {
+    std::string prefix = std::string(name) + "=";
+    if (option.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+
+    value = std::max(0, std::atoi(option.c_str() + prefix.size()));
+    return true;
+}
+
+static EGLDisplay getDisplay() {
+    // Prefer the surfaceless platform, which needs neither a display server nor a GPU.
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (getPlatformDisplay) {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) {
+            return display;
+        }
+    }
+
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) {
+        return display;
+    }
+
+    return EGL_NO_DISPLAY;
+}
+
+static bool createContext(EGLState& egl) {
+    egl.display = getDisplay();
+    if (egl.display == EGL_NO_DISPLAY) {
+        std::cerr << "ERROR: Failed to initialize an EGL display\n";
+        return false;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "ERROR: EGL does not support desktop OpenGL\n";
+        return false;
+    }
+
+    const EGLint configAttributes[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_NONE,
+    };
+
+    // The surfaceless platform has no pbuffer configs, any config with desktop GL will do there.
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(egl.display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+        const EGLint anyAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+        if (!eglChooseConfig(egl.display, anyAttributes, &config, 1, &configCount) || configCount == 0) {
+            std::cerr << "ERROR: No EGL config supports desktop OpenGL\n";
+            return false;
+        }
+    }
+
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE,
+    };
+
+    egl.context = eglCreateContext(egl.display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (egl.context == EGL_NO_CONTEXT) {
+        std::cerr << "ERROR: Failed to create an OpenGL 3.3 core context\n";
+        return false;
+    }
+
+    // All rendering goes to a framebuffer object, the surface only exists to make the context current.
+    const EGLint surfaceAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+    egl.surface = eglCreatePbufferSurface(egl.display, config, surfaceAttributes);
+
+    if (!eglMakeCurrent(egl.display, egl.surface, egl.surface, egl.context)) {
+        std::cerr << "ERROR: Failed to make the EGL context current\n";
+        return false;
+    }
+
+    return true;
+}
+
+static void destroyContext(EGLState& egl) {
+    if (egl.display == EGL_NO_DISPLAY) {
+        return;
+    }
+
+    eglMakeCurrent(egl.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+    if (egl.surface != EGL_NO_SURFACE) {
+        eglDestroySurface(egl.display, egl.surface);
+    }
+
+    if (egl.context != EGL_NO_CONTEXT) {
+        eglDestroyContext(egl.display, egl.context);
+    }
+
+    eglTerminate(egl.display);
+}
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    size_t index = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+    index = std::min(std::max<size_t>(index, 1), sorted.size()) - 1;
+    return sorted[index];
+}
+
+static void animateLights(std::vector<Light>& lights, std::vector<ModelInstance>& instances, float time) {
+    const float twoPi = 6.28318530718f;
+
+    for (size_t i = 0; i < lights.size(); i++) {
+        float phase = twoPi * static_cast<float>(i) / static_cast<float>(lights.size());
+        float radius = 3.0f + static_cast<float>(i % 4);
+        float angle = phase + time * (0.5f + 0.1f * static_cast<float>(i % 3));
+
+        lights[i].position = glm::vec3(std::cos(angle) * radius, std::sin(time + phase) * 2.0f, std::sin(angle) * radius);
+
+        instances[i].transform = glm::translate(glm::mat4(1.0f), lights[i].position);
+        instances[i].color = glm::vec4(lights[i].color, 1.0f);
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+
+        if (!parseInt(option, "--frames", options.frames) &&
+            !parseInt(option, "--warmup", options.warmup) &&
+            !parseInt(option, "--lights", options.lights) &&
+            !parseInt(option, "--objects", options.objects) &&
+            !parseInt(option, "--occluders", options.occluders) &&
+            !parseInt(option, "--deferred", options.deferred) &&
+            !parseInt(option, "--clustered", options.clustered) &&
+            !parseInt(option, "--multi-draw", options.multiDraw) &&
+            !parseInt(option, "--width", options.width) &&
+            !parseInt(option, "--height", options.height)) {
+            std::cerr << "Usage: HelloLights_bench [--frames=N] [--warmup=N] [--lights=N] [--objects=N] [--occluders=N] [--deferred=0|1] [--clustered=0|1] [--multi-draw=0|1] [--width=N] [--height=N]\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    options.frames = std::max(options.frames, 1);
+    options.lights = std::max(options.lights, 1);
+    options.width = std::max(options.width, 1);
+    options.height = std::max(options.height, 1);
+
+    EGLState egl;
+    if (!createContext(egl)) {
+        destroyContext(egl);
+        return EXIT_FAILURE;
+    }
+
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+        std::cerr << "ERROR: Failed to initialize GLAD\n";
+        destroyContext(egl);
+        return EXIT_FAILURE;
+    }
+
+    LoadGLExtensions((GLADloadproc)eglGetProcAddress);
+    glDebug.Init();
+
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << "\n";
+
+    int exitCode = EXIT_SUCCESS;
+
+    // Scoped so every GL object is released before the context goes away.
+    {
+        GLuint framebuffer = 0;
+        GLuint renderbuffers[2] = { 0, 0 };
+
+        GL_CHECK(glGenFramebuffers(1, &framebuffer));
+        GL_CHECK(glGenRenderbuffers(2, renderbuffers));
+
+        GL_CHECK(glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]));
+        GL_CHECK(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, options.width, options.height));
+        GL_CHECK(glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]));
+        GL_CHECK(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, options.width, options.height));
+        GL_CHECK(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+
+        GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+        GL_CHECK(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]));
+        GL_CHECK(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]));
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "ERROR: The offscreen framebuffer is incomplete\n";
+            exitCode = EXIT_FAILURE;
+        }
+
+        ShaderLibrary shaders;
+        ShaderDefines cubeDefines;
+        if (options.clustered) {
+            cubeDefines = ShaderPermutation<SHADER_FEATURE_CLUSTERED_LIGHTS>::Defines();
+        } else {
+            cubeDefines.Define("LIGHT_COUNT", options.lights);
+        }
+
+        // --multi-draw puts every mesh in a shared geometry pool and has the
+        // cube shaders read their transforms from the render queue's draw data.
+        if (options.multiDraw) {
+            cubeDefines.Define("MULTI_DRAW");
+        }
+
+        auto cubeShader = shaders.Get("./assets/shaders/cube.vert", "./assets/shaders/cube.frag", cubeDefines);
+        auto lightShader = shaders.Get("./assets/shaders/light.vert", "./assets/shaders/light.frag");
+        auto cubeGBufferShader = options.multiDraw ? shaders.Get<ShaderPermutation<SHADER_FEATURE_GBUFFER | SHADER_FEATURE_MULTI_DRAW>>("./assets/shaders/cube.vert", "./assets/shaders/cube.frag")
+                                                   : shaders.Get<ShaderPermutation<SHADER_FEATURE_GBUFFER>>("./assets/shaders/cube.vert", "./assets/shaders/cube.frag");
+
+        cubeShader->Use();
+        cubeShader->Set(cubeShader->GetUniform<int>("uLights"), static_cast<int>(LIGHT_BUFFER_TEXTURE_UNIT));
+
+        Uniform<glm::vec4> clusterParamsUniform;
+        if (options.clustered) {
+            clusterParamsUniform = cubeShader->GetUniform<glm::vec4>("uClusterParams");
+            cubeShader->Set(cubeShader->GetUniform<int>("uLightClusters"), static_cast<int>(LIGHT_CLUSTER_TEXTURE_UNIT));
+            cubeShader->Set(cubeShader->GetUniform<int>("uLightIndices"), static_cast<int>(LIGHT_INDEX_TEXTURE_UNIT));
+        }
+
+        // Without the mesh every frame would time empty geometry, so give up instead.
+        MeshData cubeMesh;
+        if (!LoadMeshData("./assets/meshes/cube.mesh", cubeMesh)) {
+            std::cerr << "ERROR: The cube mesh is missing, run the benchmark from the directory that holds assets/\n";
+            exitCode = EXIT_FAILURE;
+        }
+
+        GeometryPool geometry;
+        GeometryPool* pool = options.multiDraw ? &geometry : nullptr;
+
+        Model cube(cubeMesh, cubeShader, pool);
+        Model light(cubeMesh, lightShader, pool);
+        Model cubeGBuffer(cubeMesh, cubeGBufferShader, pool);
+        light.SetScale(glm::vec3(0.2f));
+
+        std::vector<Light> lights(static_cast<size_t>(options.lights));
+        std::vector<ModelInstance> lightInstances(lights.size());
+
+        // Same palette as the interactive scene, repeated for larger light counts.
+        const glm::vec3 palette[] = {
+            glm::vec3(1.0f, 0.0f, 0.0f),
+            glm::vec3(0.0f, 1.0f, 0.0f),
+            glm::vec3(0.0f, 0.0f, 1.0f),
+            glm::vec3(0.96f, 1.0f, 0.0f),
+            glm::vec3(1.0f, 0.58f, 0.0f),
+            glm::vec3(1.0f, 0.0f, 0.9f),
+        };
+
+        for (size_t i = 0; i < lights.size(); i++) {
+            lights[i].color = palette[i % (sizeof(palette) / sizeof(palette[0]))];
+        }
+
+        // Objects sit on a square grid in the xz plane, centred on the origin.
+        int gridSize = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(options.objects))));
+        float gridExtent = static_cast<float>(gridSize - 1) * OBJECT_SPACING * 0.5f;
+
+        ThreadPool workers;
+        TransformSystem transforms;
+        transforms.Reserve(static_cast<size_t>(options.objects));
+
+        CullingSystem culling;
+
+        std::vector<TransformHandle> objectTransforms;
+        for (int i = 0; i < options.objects; i++) {
+            glm::vec3 position(static_cast<float>(i % gridSize) * OBJECT_SPACING - gridExtent, 0.0f, static_cast<float>(i / gridSize) * OBJECT_SPACING - gridExtent);
+            objectTransforms.push_back(transforms.Create(position));
+            culling.Add(objectTransforms.back(), cube.GetBounds());
+        }
+
+        std::vector<uint32_t> visibleObjects;
+
+        // The nearest visible objects of every frame occlude the ones behind them.
+        OcclusionCuller occlusion;
+        OccluderMesh cubeOccluder = MakeBoxOccluder(cube.GetBounds());
+        std::vector<std::pair<float, uint32_t>> occluderCandidates;
+
+        LightBuffer lightBuffer;
+        LightClusters lightClusters;
+        UniformBuffer frameBuffer(FRAME_BLOCK_BINDING, sizeof(FrameUniforms));
+        FrameUniforms frameUniforms;
+        RenderQueue renderQueue;
+
+        DeferredRenderer deferredRenderer(shaders.Get("./assets/shaders/deferred_light.vert", "./assets/shaders/deferred_light.frag"),
+                                          shaders.Get("./assets/shaders/deferred_composite.vert", "./assets/shaders/deferred_composite.frag"));
+
+        if (options.deferred) {
+            deferredRenderer.Resize(options.width, options.height);
+        }
+
+        glState.SetViewport(0, 0, options.width, options.height);
+        glState.SetDepthTest(true);
+        GL_CHECK(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
+
+        float cameraDistance = std::max(6.0f, gridExtent * 2.0f + 4.0f);
+        float aspect = static_cast<float>(options.width) / static_cast<float>(options.height);
+
+        std::vector<double> frameTimes;
+        frameTimes.reserve(static_cast<size_t>(options.frames));
+
+        size_t drawCalls = 0;
+        size_t multiDraws = 0;
+        size_t triangles = 0;
+        size_t visibleCount = 0;
+        size_t occludedCount = 0;
+
+        int totalFrames = exitCode == EXIT_SUCCESS ? options.warmup + options.frames : 0;
+
+        for (int frame = 0; frame < totalFrames; frame++) {
+            auto start = std::chrono::steady_clock::now();
+            float time = static_cast<float>(frame) * FRAME_TIME_STEP;
+
+            float cameraAngle = time * 0.3f;
+            glm::vec3 cameraPosition(std::cos(cameraAngle) * cameraDistance, 3.0f + std::sin(time * 0.5f) * 2.0f, std::sin(cameraAngle) * cameraDistance);
+
+            frameUniforms.view = glm::lookAt(cameraPosition, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            frameUniforms.projection = glm::perspective(glm::radians(45.0f), aspect, NEAR_PLANE, FAR_PLANE);
+            frameUniforms.cameraPos = glm::vec4(cameraPosition, 1.0f);
+            frameBuffer.Upload(frameUniforms);
+
+            animateLights(lights, lightInstances, time);
+
+            lightBuffer.Upload(lights);
+            lightBuffer.Bind();
+            light.SetInstances(lightInstances);
+
+            if (options.clustered) {
+                lightClusters.Build(lights.data(), lights.size(), frameUniforms.view, frameUniforms.projection, NEAR_PLANE, FAR_PLANE, &workers);
+                lightClusters.Upload();
+                lightClusters.Bind();
+
+                cubeShader->Use();
+                cubeShader->Set(clusterParamsUniform, lightClusters.GetShaderParams(static_cast<float>(options.width), static_cast<float>(options.height)));
+            }
+
+            GL_CHECK(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+
+            renderQueue.Begin(frameUniforms.view, FAR_PLANE);
+
+            // Every object moves every frame, the worst case for the transform system.
+            for (TransformHandle handle : objectTransforms) {
+                transforms.SetRotation(handle, time, glm::vec3(1.0f, 0.3f, 0.5f));
+            }
+
+            transforms.Update(&workers);
+            culling.Update(transforms, &workers);
+            culling.Cull(frameUniforms.projection * frameUniforms.view, visibleObjects, &workers);
+
+            // The culler keeps its stats from the last frame it ran, so they only count when it ran this frame.
+            size_t occluded = 0;
+
+            if (options.occluders > 0 && visibleObjects.size() > 1) {
+                occluderCandidates.clear();
+                for (uint32_t object : visibleObjects) {
+                    glm::vec3 offset = culling.GetWorldBounds(object).GetCenter() - cameraPosition;
+                    occluderCandidates.emplace_back(glm::dot(offset, offset), object);
+                }
+
+                size_t occluderCount = std::min(occluderCandidates.size(), static_cast<size_t>(options.occluders));
+                std::partial_sort(occluderCandidates.begin(), occluderCandidates.begin() + occluderCount, occluderCandidates.end());
+
+                occlusion.Begin(frameUniforms.projection * frameUniforms.view);
+                for (size_t i = 0; i < occluderCount; i++) {
+                    occlusion.AddOccluder(cubeOccluder, transforms.GetWorldMatrix(objectTransforms[occluderCandidates[i].second]));
+                }
+
+                occlusion.Rasterize(&workers);
+                occlusion.Cull(culling.GetWorldBoundsData(), visibleObjects, &workers);
+                occluded = occlusion.GetStats().occluded;
+            }
+
+            // The deferred path draws the objects to the G-buffer and shades
+            // them there, the light markers are drawn forward either way.
+            Model& objectModel = options.deferred ? cubeGBuffer : cube;
+
+            if (options.deferred) {
+                deferredRenderer.BeginGeometryPass();
+            }
+
+            for (uint32_t object : visibleObjects) {
+                TransformHandle handle = objectTransforms[object];
+                renderQueue.Submit(objectModel, transforms.GetWorldMatrix(handle), transforms.GetNormalMatrix(handle), glm::vec3(1.0f));
+            }
+
+            if (options.deferred) {
+                renderQueue.Flush();
+
+                deferredRenderer.LightingPass(lightBuffer.GetCount());
+                deferredRenderer.Composite(framebuffer);
+            }
+
+            renderQueue.SubmitInstanced(light);
+            renderQueue.Flush();
+
+            GL_CHECK(glFinish());
+
+            auto end = std::chrono::steady_clock::now();
+            glDebug.Drain();
+
+            if (frame >= options.warmup) {
+                frameTimes.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+            }
+
+            // The queue counts both flushes of the frame, the lighting pass and composite are one draw each.
+            drawCalls = renderQueue.GetStats().draws + (options.deferred ? 2 : 0);
+            multiDraws = renderQueue.GetStats().multiDraws;
+            visibleCount = visibleObjects.size();
+            occludedCount = occluded;
+            triangles = static_cast<size_t>(cube.GetIndexCount() / 3) * visibleCount +
+                static_cast<size_t>(light.GetIndexCount() / 3) * static_cast<size_t>(light.GetInstanceCount());
+        }
+
+        if (!frameTimes.empty()) {
+            std::vector<double> sorted(frameTimes);
+            std::sort(sorted.begin(), sorted.end());
+
+            double sum = 0.0;
+            for (double time : sorted) {
+                sum += time;
+            }
+
+            std::cout << std::fixed << std::setprecision(3);
+            std::cout << "Resolution: " << options.width << "x" << options.height << ", lights: " << options.lights << ", objects: " << options.objects << ", " << (options.deferred ? "deferred" : options.clustered ? "clustered forward" : "forward") << " shading\n";
+            std::cout << "Frames: " << sorted.size() << " (after " << options.warmup << " warm-up frames)\n";
+            std::cout << "Frame time (ms): mean " << sum / static_cast<double>(sorted.size())
+                      << ", p50 " << percentile(sorted, 0.50)
+                      << ", p95 " << percentile(sorted, 0.95)
+                      << ", p99 " << percentile(sorted, 0.99) << "\n";
+            std::cout << "Per frame: " << drawCalls << " draw calls, " << triangles << " triangles, " << visibleCount << " of " << objectTransforms.size() << " objects visible, " << occludedCount << " occluded\n";
+
+            if (options.multiDraw) {
+                const GeometryPoolStats& poolStats = geometry.GetStats();
+                std::cout << "Geometry pool: " << poolStats.pages << " pages (" << poolStats.pageBytes << " bytes), " << poolStats.meshes << " meshes for " << poolStats.references << " models, "
+                          << poolStats.uploadedBytes << " bytes uploaded, " << poolStats.sharedBytes << " shared, " << multiDraws << " multi-draws per frame"
+                          << (glExtensions.shaderDrawParameters ? "" : " (no ARB_shader_draw_parameters)") << "\n";
+            }
+        }
+
+        GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+        GL_CHECK(glDeleteRenderbuffers(2, renderbuffers));
+        GL_CHECK(glDeleteFramebuffers(1, &framebuffer));
+    }
+
+    destroyContext(egl);
+    return exitCode;
+}
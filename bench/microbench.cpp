@@ -0,0 +1,653 @@
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fake_gl.hpp"
+#include "camera.hpp"
+#include "model.hpp"
+#include "mesh_data.hpp"
+#include "vertex_format.hpp"
+#include "transform_system.hpp"
+#include "light_animation.hpp"
+#include "culling.hpp"
+#include "occlusion_culling.hpp"
+#include "light_clusters.hpp"
+#include "thread_pool.hpp"
+
+// CPU microbenchmarks for the per-vertex and per-frame hot paths. GL calls go
+// to the stand-ins from fake_gl.cpp, so only the work on our side is timed.
+// Pass --quick for the short run registered with CTest.
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    double batchSeconds = 0.2;
+    int batches = 5;
+    size_t maxVertices = 10000000;
+    size_t maxOptimizedVertices = 1000000;
+    size_t transforms = 100000;
+    size_t lights = 1000000;
+};
+
+template <typename T>
+static inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// Correctness checks run next to the timings. A failed one makes the run,
+// and with it the CTest, fail.
+static int checkFailures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "Error: Check failed: " << what << "!\n";
+        checkFailures++;
+    }
+}
+
+// Swallows everything written to std::cout while it is alive, so the timed
+// code can not end up measuring iostream.
+class SilenceOutput {
+public:
+    SilenceOutput() : m_Previous(std::cout.rdbuf(&m_Null)) {}
+    ~SilenceOutput() { std::cout.rdbuf(m_Previous); }
+
+    SilenceOutput(const SilenceOutput&) = delete;
+    SilenceOutput& operator=(const SilenceOutput&) = delete;
+
+private:
+    struct NullBuffer : std::streambuf {
+        int overflow(int c) override { return traits_type::not_eof(c); }
+    };
+
+    NullBuffer m_Null;
+    std::streambuf* m_Previous;
+};
+
+// Runs body in batches sized to take about config.batchSeconds each and reports
+// the median time per call, and per item when a call processes several.
+template <typename F>
+static void run(const BenchConfig& config, const std::string& name, size_t items, F&& body) {
+    size_t iterations = 1;
+    std::vector<double> nanoseconds;
+
+    {
+        SilenceOutput silence;
+
+        for (;;) {
+            auto start = Clock::now();
+            for (size_t i = 0; i < iterations; i++) {
+                body();
+            }
+
+            double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+            if (elapsed >= config.batchSeconds * 0.5 || iterations >= (size_t(1) << 30)) {
+                iterations = std::max<size_t>(1, static_cast<size_t>(static_cast<double>(iterations) * config.batchSeconds / std::max(elapsed, 1e-9)));
+                break;
+            }
+
+            iterations *= 2;
+        }
+
+        for (int batch = 0; batch < config.batches; batch++) {
+            auto start = Clock::now();
+            for (size_t i = 0; i < iterations; i++) {
+                body();
+            }
+
+            double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            nanoseconds.push_back(elapsed / static_cast<double>(iterations));
+        }
+    }
+
+    std::sort(nanoseconds.begin(), nanoseconds.end());
+    double median = nanoseconds[nanoseconds.size() / 2];
+
+    std::cout << std::left << std::setw(44) << name << std::right << std::fixed << std::setprecision(2);
+    std::cout << std::setw(16) << median << " ns/call";
+
+    if (items > 1) {
+        std::cout << std::setw(12) << median / static_cast<double>(items) << " ns/item";
+    }
+
+    std::cout << std::defaultfloat << std::endl;
+}
+
+struct VertexStreams {
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> colors;
+    std::vector<float> texCoords;
+};
+
+// A grid of quads, so welding finds shared vertices the way it would in a real mesh.
+static VertexStreams makeVertices(size_t count) {
+    VertexStreams streams;
+    streams.positions.resize(count * 3);
+    streams.normals.resize(count * 3);
+    streams.colors.resize(count * 3);
+    streams.texCoords.resize(count * 2);
+
+    size_t width = 1024;
+
+    for (size_t i = 0; i < count; i++) {
+        size_t quad = i / 6;
+        size_t corner = i % 6;
+        size_t dx = (corner == 1 || corner == 2 || corner == 4) ? 1 : 0;
+        size_t dy = (corner == 2 || corner == 4 || corner == 5) ? 1 : 0;
+
+        float x = static_cast<float>(quad % width + dx);
+        float y = static_cast<float>(quad / width + dy);
+
+        streams.positions[i * 3 + 0] = x;
+        streams.positions[i * 3 + 1] = y;
+        streams.positions[i * 3 + 2] = 0.0f;
+
+        streams.normals[i * 3 + 0] = 0.0f;
+        streams.normals[i * 3 + 1] = 0.0f;
+        streams.normals[i * 3 + 2] = 1.0f;
+
+        streams.colors[i * 3 + 0] = 1.0f;
+        streams.colors[i * 3 + 1] = 1.0f;
+        streams.colors[i * 3 + 2] = 1.0f;
+
+        streams.texCoords[i * 2 + 0] = x / static_cast<float>(width);
+        streams.texCoords[i * 2 + 1] = y / static_cast<float>(width);
+    }
+
+    return streams;
+}
+
+static std::shared_ptr<Shader> makeShader() {
+    ShaderSource source;
+    source.vertexPath = "fake.vert";
+    source.fragmentPath = "fake.frag";
+    source.vertexCode = "#version 330 core\nvoid main() {}\n";
+    source.fragmentCode = "#version 330 core\nvoid main() {}\n";
+
+    return std::make_shared<Shader>(source);
+}
+
+static void benchVertexPacking(const BenchConfig& config) {
+    VertexFormat packed;
+    packed.position = POSITION_HALF;
+    packed.normal = NORMAL_OCTAHEDRAL;
+    packed.color = COLOR_UNORM8;
+
+    for (size_t count = 1000; count <= config.maxVertices; count *= 10) {
+        VertexStreams streams = makeVertices(count);
+        std::string size = std::to_string(count);
+
+        run(config, "PackVertices float32/" + size, count, [&]() {
+            VertexLayout layout;
+            std::vector<unsigned char> vertices = PackVertices(VertexFormat(), streams.positions.data(), streams.normals.data(), streams.colors.data(), streams.texCoords.data(), count, layout);
+            doNotOptimize(vertices.data());
+        });
+
+        run(config, "PackVertices packed/" + size, count, [&]() {
+            VertexLayout layout;
+            std::vector<unsigned char> vertices = PackVertices(packed, streams.positions.data(), streams.normals.data(), streams.colors.data(), streams.texCoords.data(), count, layout);
+            doNotOptimize(vertices.data());
+        });
+
+        if (count <= config.maxOptimizedVertices) {
+            run(config, "BuildMeshData/" + size, count, [&]() {
+                MeshData mesh;
+                BuildMeshData(streams.positions, streams.normals, streams.colors, streams.texCoords, VertexFormat(), mesh);
+                doNotOptimize(mesh.indexCount);
+            });
+        }
+    }
+}
+
+static void benchModel(const BenchConfig& config, std::shared_ptr<Shader> shader) {
+    VertexStreams streams = makeVertices(36);
+
+    MeshData mesh;
+    BuildMeshData(streams.positions, streams.normals, streams.colors, streams.texCoords, VertexFormat(), mesh);
+
+    run(config, "Model setup (36 vertices)", 1, [&]() {
+        Model model(mesh, shader);
+        doNotOptimize(model.GetVertexArray());
+    });
+
+    // After the first model every one made from the same mesh only hashes it and adds a reference.
+    GeometryPool pool;
+    Model first(mesh, shader, &pool);
+
+    run(config, "Model setup, pooled (36 vertices)", 1, [&]() {
+        Model model(mesh, shader, &pool);
+        doNotOptimize(model.GetVertexArray());
+    });
+
+    // Model setup on prepared geometry, which reads the positions back for the
+    // bounds and uploads. The vertices are packed without welding, so the
+    // largest sizes do not wait on the optimizer.
+    for (size_t count = 1000; count <= config.maxVertices; count *= 10) {
+        VertexStreams large = makeVertices(count);
+        std::string size = std::to_string(count);
+
+        MeshData packed;
+        packed.vertexStorage = PackVertices(VertexFormat(), large.positions.data(), large.normals.data(), large.colors.data(), large.texCoords.data(), count, packed.layout);
+
+        std::vector<uint32_t> indices(count);
+        for (size_t i = 0; i < count; i++) {
+            indices[i] = static_cast<uint32_t>(i);
+        }
+
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(indices.data());
+        packed.indexStorage.assign(bytes, bytes + indices.size() * sizeof(uint32_t));
+        packed.indexType = GL_UNSIGNED_INT;
+        packed.vertexData = packed.vertexStorage.data();
+        packed.vertexBytes = packed.vertexStorage.size();
+        packed.indexData = packed.indexStorage.data();
+        packed.indexCount = indices.size();
+
+        run(config, "Model setup/" + size, count, [&]() {
+            Model model(packed, shader);
+            doNotOptimize(model.GetVertexArray());
+        });
+
+        // From separate streams, which adds interleaving, welding and cache optimisation.
+        if (count <= config.maxOptimizedVertices) {
+            run(config, "Model setup from streams/" + size, count, [&]() {
+                Model model(large.positions, large.normals, large.colors, large.texCoords, shader);
+                doNotOptimize(model.GetVertexArray());
+            });
+        }
+    }
+
+    Model model(mesh, shader);
+    model.SetPosition(1.0f, 2.0f, 3.0f);
+    model.SetRotationDeg(30.0f);
+    model.SetScale(0.5f, 0.5f, 0.5f);
+
+    run(config, "Model::GetMatrix", 1, [&]() {
+        glm::mat4 matrix = model.GetMatrix();
+        doNotOptimize(matrix);
+    });
+}
+
+static void benchCamera(const BenchConfig& config) {
+    Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+    run(config, "Camera::GetViewMatrix", 1, [&]() {
+        glm::mat4 view = camera.GetViewMatrix();
+        doNotOptimize(view);
+    });
+
+    // ProcessMouseMovement is the public way into updateCameraVectors.
+    float direction = 1.0f;
+    run(config, "Camera::ProcessMouseMovement", 1, [&]() {
+        camera.ProcessMouseMovement(direction, direction);
+        direction = -direction;
+    });
+}
+
+// Flat: every transform is a root. Hierarchy: each root has 15 children, so
+// the world pass runs over a second level.
+static void benchTransforms(const BenchConfig& config, ThreadPool& pool) {
+    std::string size = std::to_string(config.transforms);
+
+    for (bool hierarchy : { false, true }) {
+        TransformSystem transforms;
+        transforms.Reserve(config.transforms);
+
+        TransformHandle root = INVALID_TRANSFORM;
+        for (size_t i = 0; i < config.transforms; i++) {
+            TransformHandle parent = hierarchy && i % 16 != 0 ? root : INVALID_TRANSFORM;
+            TransformHandle handle = transforms.Create(glm::vec3(static_cast<float>(i), 0.0f, 0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f), parent);
+
+            if (i % 16 == 0) {
+                root = handle;
+            }
+        }
+
+        std::string name = std::string(hierarchy ? "TransformSystem hierarchy" : "TransformSystem flat");
+        float angle = 0.0f;
+
+        auto moveAll = [&]() {
+            angle += 0.01f;
+            for (TransformHandle handle = 0; handle < transforms.GetCount(); handle++) {
+                transforms.SetRotation(handle, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+            }
+        };
+
+        run(config, name + " all moved/" + size, config.transforms, [&]() {
+            moveAll();
+            transforms.Update();
+            doNotOptimize(transforms.GetWorldMatrices());
+        });
+
+        run(config, name + " all moved, pool/" + size, config.transforms, [&]() {
+            moveAll();
+            transforms.Update(&pool);
+            doNotOptimize(transforms.GetWorldMatrices());
+        });
+
+        run(config, name + " unchanged/" + size, config.transforms, [&]() {
+            transforms.Update(&pool);
+            doNotOptimize(transforms.GetWorldMatrices());
+        });
+    }
+}
+
+static void benchCulling(const BenchConfig& config, ThreadPool& pool) {
+    // Unit cubes on a 3D grid, looked at from one side so roughly a tenth is in view.
+    size_t side = static_cast<size_t>(std::ceil(std::cbrt(static_cast<double>(config.transforms))));
+    float extent = static_cast<float>(side) * 2.0f;
+
+    TransformSystem transforms;
+    transforms.Reserve(config.transforms);
+
+    CullingSystem culling;
+    AABB cubeBounds(glm::vec3(-0.5f), glm::vec3(0.5f));
+
+    for (size_t i = 0; i < config.transforms; i++) {
+        glm::vec3 position(static_cast<float>(i % side), static_cast<float>(i / side % side), static_cast<float>(i / (side * side)));
+        culling.Add(transforms.Create(position * 2.0f - glm::vec3(extent * 0.5f)), cubeBounds);
+    }
+
+    transforms.Update(&pool);
+    culling.Update(transforms, &pool);
+
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, extent), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(30.0f), 16.0f / 9.0f, 0.1f, extent * 2.0f);
+    glm::mat4 viewProjection = projection * view;
+
+    std::string size = std::to_string(config.transforms);
+    std::vector<uint32_t> visible;
+
+    run(config, "CullingSystem cull/" + size, config.transforms, [&]() {
+        culling.Cull(viewProjection, visible);
+        doNotOptimize(visible.data());
+    });
+
+    run(config, "CullingSystem cull, pool/" + size, config.transforms, [&]() {
+        culling.Cull(viewProjection, visible, &pool);
+        doNotOptimize(visible.data());
+    });
+
+    // A tenth of the objects move every frame and the tree is refitted around them.
+    float offset = 0.0f;
+    run(config, "CullingSystem refit, 10% moved/" + size, config.transforms, [&]() {
+        offset = offset > 0.0f ? -0.01f : 0.01f;
+        for (TransformHandle handle = 0; handle < transforms.GetCount(); handle += 10) {
+            transforms.SetPosition(handle, transforms.GetPosition(handle) + glm::vec3(offset, 0.0f, 0.0f));
+        }
+
+        transforms.Update(&pool);
+        culling.Update(transforms, &pool);
+        doNotOptimize(culling.GetWorldBounds(0));
+    });
+
+    std::cout << "CullingSystem: " << visible.size() << " of " << config.transforms << " objects visible, " << culling.GetStats().rebuilds << " builds" << std::endl;
+}
+
+// One wall facing the camera, with boxes behind it, in front of it, beside it
+// and reaching from behind the camera to past the wall. Only the box behind
+// the wall may be culled. The last one only has corners behind the wall in
+// front of the camera, so it is kept by the near plane test alone.
+static void checkOcclusion(ThreadPool& pool) {
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 500.0f);
+
+    OcclusionCuller occlusion;
+    occlusion.Begin(projection * view);
+    occlusion.AddOccluder(MakeBoxOccluder(AABB(glm::vec3(-2.0f, -2.0f, -0.1f), glm::vec3(2.0f, 2.0f, 0.1f))), glm::mat4(1.0f));
+    occlusion.Rasterize(&pool);
+
+    const AABB behind(glm::vec3(-0.5f, -0.5f, -5.5f), glm::vec3(0.5f, 0.5f, -4.5f));
+    const AABB inFront(glm::vec3(-0.5f, -0.5f, 4.5f), glm::vec3(0.5f, 0.5f, 5.5f));
+    const AABB beside(glm::vec3(6.0f, -0.5f, -5.5f), glm::vec3(7.0f, 0.5f, -4.5f));
+    const AABB nearPlane(glm::vec3(-0.05f, -0.05f, -10.0f), glm::vec3(0.05f, 0.05f, 11.0f));
+
+    check(!occlusion.IsVisible(behind), "OcclusionCuller keeps a box behind the occluder");
+    check(occlusion.IsVisible(inFront), "OcclusionCuller culls a box in front of the occluder");
+    check(occlusion.IsVisible(beside), "OcclusionCuller culls a box beside the occluder");
+    check(occlusion.IsVisible(nearPlane), "OcclusionCuller culls a box across the near plane");
+
+    const AABB bounds[] = { behind, inFront, beside, nearPlane };
+    std::vector<uint32_t> objects = { 0, 1, 2, 3 };
+    occlusion.Cull(bounds, objects, &pool);
+    check(objects == std::vector<uint32_t>({ 1, 2, 3 }), "OcclusionCuller::Cull disagrees with IsVisible");
+}
+
+static void benchOcclusion(const BenchConfig& config, ThreadPool& pool) {
+    checkOcclusion(pool);
+
+    // A row of walls close to the camera in front of a field of small boxes.
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 2.0f, 10.0f), glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 500.0f);
+    glm::mat4 viewProjection = projection * view;
+
+    OccluderMesh wall = MakeBoxOccluder(AABB(glm::vec3(-1.0f, 0.0f, -0.1f), glm::vec3(1.0f, 4.0f, 0.1f)));
+    std::vector<glm::mat4> wallTransforms;
+    for (int i = 0; i < 16; i++) {
+        wallTransforms.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(static_cast<float>(i) * 1.5f - 12.0f, 0.0f, 2.0f)));
+    }
+
+    std::vector<AABB> bounds;
+    std::vector<uint32_t> all;
+    size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(config.transforms))));
+    for (size_t i = 0; i < config.transforms; i++) {
+        glm::vec3 center(static_cast<float>(i % side) - static_cast<float>(side) * 0.5f, 0.5f, -static_cast<float>(i / side));
+        bounds.emplace_back(center - glm::vec3(0.4f), center + glm::vec3(0.4f));
+        all.push_back(static_cast<uint32_t>(i));
+    }
+
+    OcclusionCuller occlusion;
+
+    auto rasterize = [&](ThreadPool* workers) {
+        occlusion.Begin(viewProjection);
+        for (const glm::mat4& transform : wallTransforms) {
+            occlusion.AddOccluder(wall, transform);
+        }
+        occlusion.Rasterize(workers);
+    };
+
+    run(config, "OcclusionCuller rasterize 16 walls", 1, [&]() {
+        rasterize(nullptr);
+    });
+
+    run(config, "OcclusionCuller rasterize 16 walls, pool", 1, [&]() {
+        rasterize(&pool);
+    });
+
+    std::string size = std::to_string(config.transforms);
+    std::vector<uint32_t> objects;
+
+    run(config, "OcclusionCuller test/" + size, config.transforms, [&]() {
+        objects = all;
+        occlusion.Cull(bounds.data(), objects);
+        doNotOptimize(objects.data());
+    });
+
+    run(config, "OcclusionCuller test, pool/" + size, config.transforms, [&]() {
+        objects = all;
+        occlusion.Cull(bounds.data(), objects, &pool);
+        doNotOptimize(objects.data());
+    });
+
+    std::cout << "OcclusionCuller: " << config.transforms - objects.size() << " of " << config.transforms << " boxes occluded" << std::endl;
+}
+
+static void benchLightClusters(const BenchConfig& config, ThreadPool& pool) {
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 5.0f, 20.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+
+    // Small lights spread over a field in front of the camera. Capped at the
+    // thousands of lights a forward renderer would realistically shade.
+    std::vector<Light> lights(std::min<size_t>(config.lights, 16384));
+    for (size_t i = 0; i < lights.size(); i++) {
+        float f = static_cast<float>(i);
+        lights[i] = Light(glm::vec3(std::fmod(f * 7.3f, 40.0f) - 20.0f, std::fmod(f * 3.1f, 6.0f), -std::fmod(f * 1.7f, 60.0f)), glm::vec3(1.0f), 1.0f + std::fmod(f, 3.0f));
+    }
+
+    LightClusters clusters;
+    std::string size = std::to_string(lights.size());
+
+    run(config, "LightClusters build/" + size, lights.size(), [&]() {
+        clusters.Build(lights.data(), lights.size(), view, projection, 0.1f, 100.0f);
+        doNotOptimize(clusters.GetStats().references);
+    });
+
+    run(config, "LightClusters build, pool/" + size, lights.size(), [&]() {
+        clusters.Build(lights.data(), lights.size(), view, projection, 0.1f, 100.0f, &pool);
+        doNotOptimize(clusters.GetStats().references);
+    });
+
+    const LightClusterStats& stats = clusters.GetStats();
+    std::cout << "LightClusters: " << stats.references << " light references, at most " << stats.maxClusterLights << " of " << stats.lights << " lights per cluster" << std::endl;
+}
+
+static void benchLightAnimation(const BenchConfig& config) {
+    LightAnimation animation;
+    animation.Reserve(config.lights);
+
+    for (size_t i = 0; i < config.lights; i++) {
+        float f = static_cast<float>(i);
+        animation.Add(glm::vec3(3.0f + std::fmod(f, 7.0f), std::fmod(f, 5.0f) - 2.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 30.0f + std::fmod(f, 11.0f), f);
+    }
+
+    // The SIMD kernels have to agree with the scalar one, also at large times
+    // where the angle reduction matters. The sine and cosine approximations are
+    // good to a few ulps, a sign or quadrant mistake is off by the orbit radius.
+    const float tolerance = 1e-4f;
+
+    for (double time : { 0.0, 0.37, 12.5, 86400.123 }) {
+        animation.SetKernel(LIGHT_ANIMATION_KERNEL_SCALAR);
+        animation.Evaluate(time);
+
+        std::vector<float> expectedX(animation.GetPositionX(), animation.GetPositionX() + config.lights);
+        std::vector<float> expectedY(animation.GetPositionY(), animation.GetPositionY() + config.lights);
+        std::vector<float> expectedZ(animation.GetPositionZ(), animation.GetPositionZ() + config.lights);
+
+        for (LightAnimationKernel kernel : { LIGHT_ANIMATION_KERNEL_SSE2, LIGHT_ANIMATION_KERNEL_AVX }) {
+            if (!LightAnimation::IsKernelSupported(kernel)) {
+                continue;
+            }
+
+            animation.SetKernel(kernel);
+            animation.Evaluate(time);
+
+            float maxError = 0.0f;
+            for (size_t i = 0; i < config.lights; i++) {
+                maxError = std::max(maxError, std::abs(animation.GetPositionX()[i] - expectedX[i]));
+                maxError = std::max(maxError, std::abs(animation.GetPositionY()[i] - expectedY[i]));
+                maxError = std::max(maxError, std::abs(animation.GetPositionZ()[i] - expectedZ[i]));
+            }
+
+            check(maxError <= tolerance, std::string("LightAnimation ") + LightAnimation::GetKernelName(kernel) + " differs from scalar by " + std::to_string(maxError) + " at time " + std::to_string(time));
+        }
+    }
+
+    std::string size = std::to_string(config.lights);
+
+    for (LightAnimationKernel kernel : { LIGHT_ANIMATION_KERNEL_SCALAR, LIGHT_ANIMATION_KERNEL_SSE2, LIGHT_ANIMATION_KERNEL_AVX }) {
+        if (!LightAnimation::IsKernelSupported(kernel)) {
+            continue;
+        }
+
+        animation.SetKernel(kernel);
+        double time = 0.0;
+
+        run(config, std::string("LightAnimation ") + LightAnimation::GetKernelName(kernel) + "/" + size, config.lights, [&]() {
+            time += 1.0 / 60.0;
+            animation.Evaluate(time);
+            doNotOptimize(animation.GetPositionX());
+        });
+    }
+}
+
+static void benchShaderSet(const BenchConfig& config, std::shared_ptr<Shader> shader) {
+    Uniform<glm::mat4> model = shader->GetUniform<glm::mat4>("uModel");
+    Uniform<glm::vec3> color = shader->GetUniform<glm::vec3>("uObjectColor");
+    Uniform<int> count = shader->GetUniform<int>("uLightCount");
+
+    glm::mat4 matrix(1.0f);
+    glm::vec3 white(1.0f);
+
+    run(config, "Shader::Set(Uniform<mat4>)", 1, [&]() {
+        shader->Set(model, matrix);
+    });
+
+    run(config, "Shader::Set(Uniform<vec3>)", 1, [&]() {
+        shader->Set(color, white);
+    });
+
+    run(config, "Shader::Set(Uniform<int>)", 1, [&]() {
+        shader->Set(count, 6);
+    });
+
+    run(config, "Shader::Set(name, mat4)", 1, [&]() {
+        shader->Set("uModel", matrix);
+    });
+
+    run(config, "Shader::GetUniform<mat4>", 1, [&]() {
+        Uniform<glm::mat4> uniform = shader->GetUniform<glm::mat4>("uModel");
+        doNotOptimize(uniform.location);
+    });
+}
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+
+        if (option == "--quick") {
+            config.batchSeconds = 0.02;
+            config.batches = 3;
+            config.maxVertices = 100000;
+            config.maxOptimizedVertices = 10000;
+            config.transforms = 10000;
+            config.lights = 10000;
+        } else {
+            std::cerr << "Usage: HelloLights_microbench [--quick]\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    LoadFakeGL();
+
+    std::shared_ptr<Shader> shader = makeShader();
+
+    benchVertexPacking(config);
+    benchModel(config, shader);
+    benchCamera(config);
+
+    ThreadPool pool;
+    benchTransforms(config, pool);
+    benchCulling(config, pool);
+    benchOcclusion(config, pool);
+    benchLightClusters(config, pool);
+    benchLightAnimation(config);
+
+    benchShaderSet(config, shader);
+
+    std::cout << GetFakeUniformCalls() << " uniform calls reached the fake driver" << std::endl;
+
+    if (checkFailures > 0) {
+        std::cerr << "Error: " << checkFailures << " checks failed!\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+#include "asset_loader.hpp"
+
+#include <chrono>
+
+AssetLoader::AssetLoader(size_t threadCount) : m_Pending(0), m_GeometryPool(nullptr), m_Pool(threadCount) {}
+
+void AssetLoader::LoadShader(const char* vertexPath, const char* fragmentPath, std::function<void(std::shared_ptr<Shader>)> onLoaded, const ShaderDefines& defines) {
+    m_Pending++;
+
+    std::string vertex = vertexPath;
+    std::string fragment = fragmentPath ? fragmentPath : "";
+
+    m_Pool.Submit([this, vertex, fragment, onLoaded, defines]() {
+        auto source = std::make_shared<ShaderSource>(ReadShaderSource(vertex.c_str(), fragment.c_str(), defines));
+
+        complete([source, onLoaded]() {
+            onLoaded(std::make_shared<Shader>(*source));
+        });
+    });
+}
+
+void AssetLoader::LoadMesh(const char* meshPath, std::function<void(MeshData&)> onLoaded) {
+    m_Pending++;
+
+    std::string path = meshPath;
+
+    m_Pool.Submit([this, path, onLoaded]() {
+        auto mesh = std::make_shared<MeshData>();
+        LoadMeshData(path.c_str(), *mesh);
+
+        complete([mesh, onLoaded]() {
+            onLoaded(*mesh);
+        });
+    });
+}
+
+void AssetLoader::SetGeometryPool(GeometryPool* pool) {
+    m_GeometryPool = pool;
+}
+
+void AssetLoader::LoadModel(const char* meshPath, const char* vertexPath, const char* fragmentPath, std::function<void(std::unique_ptr<Model>)> onLoaded, const ShaderDefines& defines) {
+    m_Pending++;
+
+    std::string path = meshPath;
+    std::string vertex = vertexPath;
+    std::string fragment = fragmentPath ? fragmentPath : "";
+
+    // The pool is picked when the model is requested, so the worker never reads m_GeometryPool.
+    GeometryPool* pool = m_GeometryPool;
+
+    m_Pool.Submit([this, path, vertex, fragment, onLoaded, defines, pool]() {
+        auto mesh = std::make_shared<MeshData>();
+        LoadMeshData(path.c_str(), *mesh);
+
+        auto source = std::make_shared<ShaderSource>(ReadShaderSource(vertex.c_str(), fragment.c_str(), defines));
+
+        complete([mesh, source, onLoaded, pool]() {
+            onLoaded(std::make_unique<Model>(*mesh, std::make_shared<Shader>(*source), pool));
+        });
+    });
+}
+
+size_t AssetLoader::Update(double budgetSeconds) {
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point start = Clock::now();
+    size_t finished = 0;
+
+    while (true) {
+        std::function<void()> finish;
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Completed.empty()) {
+                break;
+            }
+
+            finish = std::move(m_Completed.front());
+            m_Completed.pop_front();
+        }
+
+        finish();
+        finished++;
+        m_Pending--;
+
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        if (elapsed.count() >= budgetSeconds) {
+            break;
+        }
+    }
+
+    return finished;
+}
+
+bool AssetLoader::IsIdle() const {
+    return m_Pending == 0;
+}
+
+void AssetLoader::complete(std::function<void()> finish) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Completed.push_back(std::move(finish));
+}
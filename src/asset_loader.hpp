@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "thread_pool.hpp"
+#include "shader.hpp"
+#include "model.hpp"
+#include "mesh_data.hpp"
+#include "geometry_pool.hpp"
+
+// Loads assets in two halves: file I/O, parsing and vertex preparation run on a
+// thread pool, and the GL work (compiling, uploading) runs on the GL thread
+// inside Update, which stops once its time budget is used up. The callbacks
+// are called from Update, on the GL thread.
+class AssetLoader {
+public:
+    explicit AssetLoader(size_t threadCount = 0);
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // A null fragmentPath loads a vertex-only shader, as for transform feedback.
+    void LoadShader(const char* vertexPath, const char* fragmentPath, std::function<void(std::shared_ptr<Shader>)> onLoaded, const ShaderDefines& defines = ShaderDefines());
+    void LoadMesh(const char* meshPath, std::function<void(MeshData&)> onLoaded);
+    // Models loaded afterwards upload their geometry into pool, which has to outlive them.
+    void SetGeometryPool(GeometryPool* pool);
+
+    void LoadModel(const char* meshPath, const char* vertexPath, const char* fragmentPath, std::function<void(std::unique_ptr<Model>)> onLoaded, const ShaderDefines& defines = ShaderDefines());
+
+    // Runs the GL half of finished jobs until budgetSeconds have passed. At least
+    // one job is run per call so loading always makes progress. Returns the
+    // number of jobs that were finished.
+    size_t Update(double budgetSeconds);
+
+    // True once every requested asset has been handed to its callback.
+    bool IsIdle() const;
+
+private:
+    std::mutex m_Mutex;
+    std::deque<std::function<void()>> m_Completed;
+    std::atomic<size_t> m_Pending;
+    GeometryPool* m_GeometryPool;
+
+    // Declared last so the workers are joined before the queue they write to is destroyed.
+    ThreadPool m_Pool;
+
+    void complete(std::function<void()> finish);
+};
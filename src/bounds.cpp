@@ -0,0 +1,154 @@
+#include "bounds.hpp"
+
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+AABB TransformAABB(const AABB& box, const glm::mat4& transform) {
+    if (box.IsEmpty()) {
+        return box;
+    }
+
+    glm::vec3 center = glm::vec3(transform * glm::vec4(box.GetCenter(), 1.0f));
+    glm::vec3 extent = box.GetExtent();
+
+    glm::vec3 worldExtent = glm::abs(glm::vec3(transform[0])) * extent.x + glm::abs(glm::vec3(transform[1])) * extent.y + glm::abs(glm::vec3(transform[2])) * extent.z;
+
+    return AABB(center - worldExtent, center + worldExtent);
+}
+
+Frustum ExtractFrustum(const glm::mat4& viewProjection) {
+    // glm is column major, so row i of the matrix is made of element i of every column.
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++) {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    }
+
+    Frustum frustum;
+    frustum.planes[FRUSTUM_PLANE_LEFT] = rows[3] + rows[0];
+    frustum.planes[FRUSTUM_PLANE_RIGHT] = rows[3] - rows[0];
+    frustum.planes[FRUSTUM_PLANE_BOTTOM] = rows[3] + rows[1];
+    frustum.planes[FRUSTUM_PLANE_TOP] = rows[3] - rows[1];
+    frustum.planes[FRUSTUM_PLANE_NEAR] = rows[3] + rows[2];
+    frustum.planes[FRUSTUM_PLANE_FAR] = rows[3] - rows[2];
+
+    for (glm::vec4& plane : frustum.planes) {
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f) {
+            plane /= length;
+        }
+    }
+
+    return frustum;
+}
+
+FrustumTest TestFrustum(const Frustum& frustum, const AABB& box, uint32_t& planeMask) {
+    glm::vec3 center = box.GetCenter();
+    glm::vec3 extent = box.GetExtent();
+
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++) {
+        if ((planeMask & (1u << i)) == 0) {
+            continue;
+        }
+
+        const glm::vec4& plane = frustum.planes[i];
+        float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+        float radius = glm::dot(glm::abs(glm::vec3(plane)), extent);
+
+        if (distance + radius < 0.0f) {
+            return FRUSTUM_OUTSIDE;
+        }
+
+        if (distance - radius >= 0.0f) {
+            planeMask &= ~(1u << i);
+        }
+    }
+
+    return planeMask == 0 ? FRUSTUM_INSIDE : FRUSTUM_INTERSECTS;
+}
+
+#ifdef __SSE2__
+
+size_t CullBoxes(const Frustum& frustum, uint32_t planeMask, const float* centerX, const float* centerY, const float* centerZ, const float* extentX, const float* extentY, const float* extentZ, const uint32_t* ids, size_t count, uint32_t* visible) {
+    const __m128 zero = _mm_setzero_ps();
+
+    // The planes are the same for every group of four, so splat them once.
+    __m128 normalX[FRUSTUM_PLANE_COUNT], normalY[FRUSTUM_PLANE_COUNT], normalZ[FRUSTUM_PLANE_COUNT], offset[FRUSTUM_PLANE_COUNT];
+    __m128 absX[FRUSTUM_PLANE_COUNT], absY[FRUSTUM_PLANE_COUNT], absZ[FRUSTUM_PLANE_COUNT];
+    int planeCount = 0;
+
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++) {
+        if (planeMask & (1u << i)) {
+            const glm::vec4& plane = frustum.planes[i];
+            normalX[planeCount] = _mm_set1_ps(plane.x);
+            normalY[planeCount] = _mm_set1_ps(plane.y);
+            normalZ[planeCount] = _mm_set1_ps(plane.z);
+            offset[planeCount] = _mm_set1_ps(plane.w);
+            absX[planeCount] = _mm_set1_ps(std::abs(plane.x));
+            absY[planeCount] = _mm_set1_ps(std::abs(plane.y));
+            absZ[planeCount] = _mm_set1_ps(std::abs(plane.z));
+            planeCount++;
+        }
+    }
+
+    size_t written = 0;
+
+    for (size_t i = 0; i < count; i += 4) {
+        __m128 cx = _mm_loadu_ps(centerX + i);
+        __m128 cy = _mm_loadu_ps(centerY + i);
+        __m128 cz = _mm_loadu_ps(centerZ + i);
+        __m128 ex = _mm_loadu_ps(extentX + i);
+        __m128 ey = _mm_loadu_ps(extentY + i);
+        __m128 ez = _mm_loadu_ps(extentZ + i);
+
+        int inside = 0xF;
+
+        for (int p = 0; p < planeCount && inside != 0; p++) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX[p], cx), _mm_mul_ps(normalY[p], cy)), _mm_add_ps(_mm_mul_ps(normalZ[p], cz), offset[p]));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)), _mm_mul_ps(absZ[p], ez));
+
+            inside &= _mm_movemask_ps(_mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+        }
+
+        size_t remaining = count - i;
+        for (int lane = 0; lane < 4 && static_cast<size_t>(lane) < remaining; lane++) {
+            if (inside & (1 << lane)) {
+                visible[written++] = ids[i + lane];
+            }
+        }
+    }
+
+    return written;
+}
+
+#else
+
+size_t CullBoxes(const Frustum& frustum, uint32_t planeMask, const float* centerX, const float* centerY, const float* centerZ, const float* extentX, const float* extentY, const float* extentZ, const uint32_t* ids, size_t count, uint32_t* visible) {
+    size_t written = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        bool inside = true;
+
+        for (int p = 0; p < FRUSTUM_PLANE_COUNT && inside; p++) {
+            if ((planeMask & (1u << p)) == 0) {
+                continue;
+            }
+
+            const glm::vec4& plane = frustum.planes[p];
+            float distance = plane.x * centerX[i] + plane.y * centerY[i] + plane.z * centerZ[i] + plane.w;
+            float radius = std::abs(plane.x) * extentX[i] + std::abs(plane.y) * extentY[i] + std::abs(plane.z) * extentZ[i];
+
+            inside = distance + radius >= 0.0f;
+        }
+
+        if (inside) {
+            visible[written++] = ids[i];
+        }
+    }
+
+    return written;
+}
+
+#endif
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+
+// Axis-aligned bounding box. A default constructed box is empty, so it can be
+// grown with Expand from nothing.
+struct AABB {
+    glm::vec3 minimum;
+    glm::vec3 maximum;
+
+    AABB() : minimum(FLT_MAX), maximum(-FLT_MAX) {}
+    AABB(const glm::vec3& minimum, const glm::vec3& maximum) : minimum(minimum), maximum(maximum) {}
+
+    void Expand(const glm::vec3& point) {
+        minimum = glm::min(minimum, point);
+        maximum = glm::max(maximum, point);
+    }
+
+    void Expand(const AABB& box) {
+        minimum = glm::min(minimum, box.minimum);
+        maximum = glm::max(maximum, box.maximum);
+    }
+
+    bool IsEmpty() const { return minimum.x > maximum.x || minimum.y > maximum.y || minimum.z > maximum.z; }
+
+    glm::vec3 GetCenter() const { return (minimum + maximum) * 0.5f; }
+    glm::vec3 GetExtent() const { return (maximum - minimum) * 0.5f; }
+
+    float GetSurfaceArea() const {
+        if (IsEmpty()) {
+            return 0.0f;
+        }
+
+        glm::vec3 size = maximum - minimum;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+};
+
+// Bounds of box after transform, from the transformed center and the extent
+// projected onto the world axes. Tight for rotations of the box itself.
+AABB TransformAABB(const AABB& box, const glm::mat4& transform);
+
+enum FrustumPlane {
+    FRUSTUM_PLANE_LEFT = 0,
+    FRUSTUM_PLANE_RIGHT = 1,
+    FRUSTUM_PLANE_BOTTOM = 2,
+    FRUSTUM_PLANE_TOP = 3,
+    FRUSTUM_PLANE_NEAR = 4,
+    FRUSTUM_PLANE_FAR = 5,
+    FRUSTUM_PLANE_COUNT = 6,
+};
+
+constexpr uint32_t FRUSTUM_ALL_PLANES = (1u << FRUSTUM_PLANE_COUNT) - 1;
+
+// Planes point inwards, a point p is inside a plane when dot(xyz, p) + w >= 0.
+struct Frustum {
+    glm::vec4 planes[FRUSTUM_PLANE_COUNT];
+};
+
+// Extracts the normalized planes of a view projection matrix (Gribb and Hartmann).
+Frustum ExtractFrustum(const glm::mat4& viewProjection);
+
+enum FrustumTest {
+    FRUSTUM_OUTSIDE,
+    FRUSTUM_INTERSECTS,
+    FRUSTUM_INSIDE,
+};
+
+// Tests box against the planes in planeMask. Planes the box is entirely in
+// front of are removed from planeMask, so the children of a box only have to
+// be tested against the remaining ones.
+FrustumTest TestFrustum(const Frustum& frustum, const AABB& box, uint32_t& planeMask);
+
+// Tests count boxes stored as center and extent streams against the planes in
+// planeMask and appends the ids of the ones that are not entirely outside to
+// visible, which needs room for count more ids. Four boxes are tested at once
+// with SSE2 where available, so the streams must stay readable for three
+// entries past count. Returns the number of ids appended.
+size_t CullBoxes(const Frustum& frustum, uint32_t planeMask, const float* centerX, const float* centerY, const float* centerZ, const float* extentX, const float* extentY, const float* extentZ, const uint32_t* ids, size_t count, uint32_t* visible);
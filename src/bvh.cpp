@@ -0,0 +1,365 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+// CullBoxes reads up to three boxes past the end of a leaf.
+constexpr size_t BVH_STREAM_PADDING = 3;
+
+BVH::BVH() : m_BuildCost(0.0f), m_Cost(0.0f) {}
+
+void BVH::Build(const AABB* bounds, size_t count) {
+    m_Nodes.clear();
+    m_Items.resize(count);
+    m_Slot.resize(count);
+    m_Leaf.resize(count);
+
+    for (std::vector<float>* stream : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_ExtentX, &m_ExtentY, &m_ExtentZ }) {
+        stream->assign(count + BVH_STREAM_PADDING, 0.0f);
+    }
+
+    if (count == 0) {
+        m_NodeDirty.clear();
+        m_BuildCost = m_Cost = 0.0f;
+        return;
+    }
+
+    std::vector<glm::vec3> centroids(count);
+    for (size_t i = 0; i < count; i++) {
+        m_Items[i] = static_cast<uint32_t>(i);
+        centroids[i] = bounds[i].GetCenter();
+    }
+
+    // A binary tree with at least one box per leaf never has more than 2n - 1 nodes.
+    m_Nodes.reserve(count * 2);
+    m_Nodes.push_back({ AABB(), 0, static_cast<uint32_t>(count), 0 });
+    buildNode(0, bounds, centroids.data(), 0);
+
+    for (uint32_t slot = 0; slot < count; slot++) {
+        m_Slot[m_Items[slot]] = slot;
+        storeBox(slot, bounds[m_Items[slot]]);
+    }
+
+    for (uint32_t node = 0; node < m_Nodes.size(); node++) {
+        if (m_Nodes[node].child == 0) {
+            for (uint32_t slot = m_Nodes[node].first; slot < m_Nodes[node].first + m_Nodes[node].count; slot++) {
+                m_Leaf[slot] = node;
+            }
+        }
+    }
+
+    m_NodeDirty.assign(m_Nodes.size(), 0);
+    m_BuildCost = m_Cost = computeCost();
+}
+
+bool BVH::Refit(const AABB* bounds, const uint8_t* changed) {
+    size_t count = m_Items.size();
+    bool anyChanged = false;
+
+    for (size_t i = 0; i < count; i++) {
+        if (changed == nullptr || changed[i]) {
+            uint32_t slot = m_Slot[i];
+            storeBox(slot, bounds[i]);
+            m_NodeDirty[m_Leaf[slot]] = 1;
+            anyChanged = true;
+        }
+    }
+
+    if (!anyChanged) {
+        return false;
+    }
+
+    // Children always follow their parent, so walking backwards visits them first.
+    for (size_t i = m_Nodes.size(); i-- > 0;) {
+        BVHNode& node = m_Nodes[i];
+
+        if (node.child == 0) {
+            if (!m_NodeDirty[i]) {
+                continue;
+            }
+
+            AABB box;
+            for (uint32_t slot = node.first; slot < node.first + node.count; slot++) {
+                glm::vec3 center(m_CenterX[slot], m_CenterY[slot], m_CenterZ[slot]);
+                glm::vec3 extent(m_ExtentX[slot], m_ExtentY[slot], m_ExtentZ[slot]);
+                box.Expand(AABB(center - extent, center + extent));
+            }
+
+            node.bounds = box;
+        } else {
+            m_NodeDirty[i] = m_NodeDirty[node.child] | m_NodeDirty[node.child + 1];
+            if (!m_NodeDirty[i]) {
+                continue;
+            }
+
+            node.bounds = m_Nodes[node.child].bounds;
+            node.bounds.Expand(m_Nodes[node.child + 1].bounds);
+        }
+    }
+
+    std::fill(m_NodeDirty.begin(), m_NodeDirty.end(), 0);
+
+    // Refitting keeps the topology, which gets worse the further boxes move from where they were built.
+    m_Cost = computeCost();
+    if (m_Cost > m_BuildCost * BVH_REBUILD_RATIO) {
+        Build(bounds, count);
+        return true;
+    }
+
+    return false;
+}
+
+void BVH::Cull(const Frustum& frustum, std::vector<uint32_t>& visible, ThreadPool* pool) const {
+    visible.clear();
+
+    if (m_Nodes.empty()) {
+        return;
+    }
+
+    CullTask root = { 0, FRUSTUM_ALL_PLANES };
+    if (TestFrustum(frustum, m_Nodes[0].bounds, root.planeMask) == FRUSTUM_OUTSIDE) {
+        return;
+    }
+
+    if (pool == nullptr || m_Items.size() < BVH_PARALLEL_CULL_MIN) {
+        visible.resize(m_Items.size());
+        visible.resize(cullSubtree(frustum, root, visible.data()));
+        return;
+    }
+
+    // Open the tree breadth first until there are a few subtrees per thread.
+    // Subtrees that are outside are dropped on the way.
+    size_t targetTasks = pool->GetThreadCount() * 4;
+
+    std::vector<CullTask> tasks = { root };
+    std::vector<CullTask> next;
+
+    while (tasks.size() < targetTasks) {
+        next.clear();
+        bool opened = false;
+
+        for (const CullTask& task : tasks) {
+            const BVHNode& node = m_Nodes[task.node];
+
+            if (node.child == 0 || task.planeMask == 0) {
+                next.push_back(task);
+                continue;
+            }
+
+            for (uint32_t child = node.child; child < node.child + 2; child++) {
+                CullTask childTask = { child, task.planeMask };
+                if (TestFrustum(frustum, m_Nodes[child].bounds, childTask.planeMask) != FRUSTUM_OUTSIDE) {
+                    next.push_back(childTask);
+                }
+            }
+
+            opened = true;
+        }
+
+        tasks.swap(next);
+
+        if (!opened) {
+            break;
+        }
+    }
+
+    // Every task writes into its own range, sized for the case that all of its boxes are visible.
+    std::vector<size_t> offsets(tasks.size() + 1, 0);
+    for (size_t i = 0; i < tasks.size(); i++) {
+        offsets[i + 1] = offsets[i] + m_Nodes[tasks[i].node].count;
+    }
+
+    std::vector<size_t> written(tasks.size(), 0);
+    visible.resize(offsets.back());
+
+    for (size_t i = 0; i < tasks.size(); i++) {
+        pool->Submit([this, &frustum, &tasks, &offsets, &written, &visible, i]() {
+            written[i] = cullSubtree(frustum, tasks[i], visible.data() + offsets[i]);
+        });
+    }
+
+    pool->Wait();
+
+    size_t total = 0;
+    for (size_t i = 0; i < tasks.size(); i++) {
+        if (total != offsets[i] && written[i] > 0) {
+            std::memmove(visible.data() + total, visible.data() + offsets[i], written[i] * sizeof(uint32_t));
+        }
+
+        total += written[i];
+    }
+
+    visible.resize(total);
+}
+
+size_t BVH::GetCount() const {
+    return m_Items.size();
+}
+
+size_t BVH::GetNodeCount() const {
+    return m_Nodes.size();
+}
+
+float BVH::GetCost() const {
+    return m_Cost;
+}
+
+void BVH::buildNode(uint32_t nodeIndex, const AABB* bounds, const glm::vec3* centroids, uint32_t depth) {
+    uint32_t first = m_Nodes[nodeIndex].first;
+    uint32_t count = m_Nodes[nodeIndex].count;
+
+    AABB box;
+    AABB centroidBox;
+    for (uint32_t i = first; i < first + count; i++) {
+        box.Expand(bounds[m_Items[i]]);
+        centroidBox.Expand(centroids[m_Items[i]]);
+    }
+
+    m_Nodes[nodeIndex].bounds = box;
+
+    if (count <= 2 || depth >= BVH_MAX_DEPTH) {
+        return;
+    }
+
+    glm::vec3 centroidSize = centroidBox.maximum - centroidBox.minimum;
+    int axis = 0;
+    if (centroidSize.y > centroidSize[axis]) {
+        axis = 1;
+    }
+    if (centroidSize.z > centroidSize[axis]) {
+        axis = 2;
+    }
+
+    // Every centroid in the same place, no split can separate them.
+    if (centroidSize[axis] <= 0.0f) {
+        return;
+    }
+
+    // Bin the centroids along the widest axis and take the cheapest split between two bins.
+    float binScale = static_cast<float>(BVH_BINS) / centroidSize[axis];
+    float binMinimum = centroidBox.minimum[axis];
+
+    auto binOf = [&](uint32_t item) {
+        size_t bin = static_cast<size_t>((centroids[item][axis] - binMinimum) * binScale);
+        return std::min(bin, BVH_BINS - 1);
+    };
+
+    AABB binBounds[BVH_BINS];
+    uint32_t binCounts[BVH_BINS] = {};
+
+    for (uint32_t i = first; i < first + count; i++) {
+        size_t bin = binOf(m_Items[i]);
+        binBounds[bin].Expand(bounds[m_Items[i]]);
+        binCounts[bin]++;
+    }
+
+    float rightCosts[BVH_BINS] = {};
+    AABB right;
+    uint32_t rightCount = 0;
+    for (size_t bin = BVH_BINS - 1; bin > 0; bin--) {
+        right.Expand(binBounds[bin]);
+        rightCount += binCounts[bin];
+        rightCosts[bin] = right.GetSurfaceArea() * static_cast<float>(rightCount);
+    }
+
+    float bestCost = 0.0f;
+    size_t bestSplit = 0;
+    AABB left;
+    uint32_t leftCount = 0;
+    for (size_t split = 1; split < BVH_BINS; split++) {
+        left.Expand(binBounds[split - 1]);
+        leftCount += binCounts[split - 1];
+
+        float cost = left.GetSurfaceArea() * static_cast<float>(leftCount) + rightCosts[split];
+        if (bestSplit == 0 || cost < bestCost) {
+            bestCost = cost;
+            bestSplit = split;
+        }
+    }
+
+    float leafCost = box.GetSurfaceArea() * static_cast<float>(count);
+    if (count <= BVH_MAX_LEAF_SIZE && bestCost >= leafCost) {
+        return;
+    }
+
+    uint32_t* items = m_Items.data();
+    uint32_t* middle = std::partition(items + first, items + first + count, [&](uint32_t item) { return binOf(item) < bestSplit; });
+    uint32_t leftSize = static_cast<uint32_t>(middle - (items + first));
+
+    // Binning can leave one side empty when the centroids cluster, fall back to a median split.
+    if (leftSize == 0 || leftSize == count) {
+        leftSize = count / 2;
+        std::nth_element(items + first, items + first + leftSize, items + first + count, [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+    }
+
+    uint32_t child = static_cast<uint32_t>(m_Nodes.size());
+    m_Nodes.push_back({ AABB(), first, leftSize, 0 });
+    m_Nodes.push_back({ AABB(), first + leftSize, count - leftSize, 0 });
+    m_Nodes[nodeIndex].child = child;
+
+    buildNode(child, bounds, centroids, depth + 1);
+    buildNode(child + 1, bounds, centroids, depth + 1);
+}
+
+void BVH::storeBox(uint32_t slot, const AABB& box) {
+    glm::vec3 center = box.GetCenter();
+    glm::vec3 extent = box.GetExtent();
+
+    m_CenterX[slot] = center.x;
+    m_CenterY[slot] = center.y;
+    m_CenterZ[slot] = center.z;
+    m_ExtentX[slot] = extent.x;
+    m_ExtentY[slot] = extent.y;
+    m_ExtentZ[slot] = extent.z;
+}
+
+float BVH::computeCost() const {
+    float rootArea = m_Nodes[0].bounds.GetSurfaceArea();
+    if (rootArea <= 0.0f) {
+        return 0.0f;
+    }
+
+    // Interior nodes cost one box test each, leaves one per box they hold.
+    float cost = 0.0f;
+    for (const BVHNode& node : m_Nodes) {
+        cost += node.bounds.GetSurfaceArea() * static_cast<float>(node.child == 0 ? node.count : 1);
+    }
+
+    return cost / rootArea;
+}
+
+size_t BVH::cullSubtree(const Frustum& frustum, CullTask task, uint32_t* visible) const {
+    // Each pop pushes at most two nodes one level down, so the depth limit bounds the stack.
+    CullTask stack[BVH_MAX_DEPTH + 2];
+    size_t top = 0;
+    size_t written = 0;
+
+    stack[top++] = task;
+
+    while (top > 0) {
+        CullTask current = stack[--top];
+        const BVHNode& node = m_Nodes[current.node];
+
+        // Entirely inside, every box below is visible without further tests.
+        if (current.planeMask == 0) {
+            std::memcpy(visible + written, m_Items.data() + node.first, node.count * sizeof(uint32_t));
+            written += node.count;
+            continue;
+        }
+
+        if (node.child == 0) {
+            uint32_t first = node.first;
+            written += CullBoxes(frustum, current.planeMask, &m_CenterX[first], &m_CenterY[first], &m_CenterZ[first], &m_ExtentX[first], &m_ExtentY[first], &m_ExtentZ[first], &m_Items[first], node.count, visible + written);
+            continue;
+        }
+
+        for (uint32_t child = node.child; child < node.child + 2; child++) {
+            CullTask childTask = { child, current.planeMask };
+            if (TestFrustum(frustum, m_Nodes[child].bounds, childTask.planeMask) != FRUSTUM_OUTSIDE) {
+                stack[top++] = childTask;
+            }
+        }
+    }
+
+    return written;
+}
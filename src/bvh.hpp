@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bounds.hpp"
+#include "thread_pool.hpp"
+
+// Leaves are split while they hold more boxes than this and splitting is
+// cheaper by the surface area heuristic.
+constexpr size_t BVH_MAX_LEAF_SIZE = 8;
+constexpr size_t BVH_BINS = 12;
+
+// Deeper nodes are not split any further. Keeps the traversal stack fixed size.
+constexpr uint32_t BVH_MAX_DEPTH = 48;
+
+// Refit rebuilds once the surface area cost has grown by this factor since the last build.
+constexpr float BVH_REBUILD_RATIO = 1.5f;
+
+// Trees with fewer boxes are culled on the calling thread even when a pool is given.
+constexpr size_t BVH_PARALLEL_CULL_MIN = 4096;
+
+// Every node covers a contiguous range of the item array. Interior nodes
+// store the index of their left child, the right one follows it directly.
+struct BVHNode {
+    AABB bounds;
+    uint32_t first;
+    uint32_t count;
+    uint32_t child;     // 0 for leaves, the root is never a child
+};
+
+// Bounding volume hierarchy over a set of boxes, identified by their index in
+// the array passed to Build. Built top down with binned SAH, then kept up to
+// date by refitting the nodes above moved boxes until the tree has degraded
+// enough to be worth rebuilding.
+//
+// The boxes are kept as center and extent streams in leaf order, so a leaf is
+// tested with CullBoxes four boxes at a time.
+class BVH {
+public:
+    BVH();
+
+    void Build(const AABB* bounds, size_t count);
+
+    // bounds must hold the same boxes as in Build, with changed set to 1 for
+    // the ones that moved. A null changed refits everything. Returns true if
+    // the tree was rebuilt instead.
+    bool Refit(const AABB* bounds, const uint8_t* changed = nullptr);
+
+    // Replaces the contents of visible with the indices of the boxes that are
+    // not entirely outside frustum. Subtrees are culled in parallel when a pool is given.
+    void Cull(const Frustum& frustum, std::vector<uint32_t>& visible, ThreadPool* pool = nullptr) const;
+
+    size_t GetCount() const;
+    size_t GetNodeCount() const;
+
+    // Surface area heuristic cost relative to the root, the lower the better.
+    float GetCost() const;
+
+private:
+    struct CullTask {
+        uint32_t node;
+        uint32_t planeMask;
+    };
+
+    std::vector<BVHNode> m_Nodes;
+    std::vector<uint32_t> m_Items;
+
+    // Indexed by position in m_Items. Padded so CullBoxes can read past the last leaf.
+    std::vector<float> m_CenterX, m_CenterY, m_CenterZ;
+    std::vector<float> m_ExtentX, m_ExtentY, m_ExtentZ;
+    std::vector<uint32_t> m_Leaf;
+
+    // Position of every box in m_Items.
+    std::vector<uint32_t> m_Slot;
+
+    std::vector<uint8_t> m_NodeDirty;
+
+    float m_BuildCost;
+    float m_Cost;
+
+    void buildNode(uint32_t nodeIndex, const AABB* bounds, const glm::vec3* centroids, uint32_t depth);
+    void storeBox(uint32_t slot, const AABB& box);
+    float computeCost() const;
+    size_t cullSubtree(const Frustum& frustum, CullTask task, uint32_t* visible) const;
+};
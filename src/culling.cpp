@@ -0,0 +1,93 @@
+#include "culling.hpp"
+
+#include <algorithm>
+
+CullingSystem::CullingSystem() : m_BVHDirty(false) {}
+
+uint32_t CullingSystem::Add(TransformHandle transform, const AABB& localBounds) {
+    uint32_t object = static_cast<uint32_t>(m_Transforms.size());
+
+    m_Transforms.push_back(transform);
+    m_LocalBounds.push_back(localBounds);
+    m_WorldBounds.push_back(localBounds);
+    m_Changed.push_back(1);
+    m_BVHDirty = true;
+
+    return object;
+}
+
+void CullingSystem::Clear() {
+    m_Transforms.clear();
+    m_LocalBounds.clear();
+    m_WorldBounds.clear();
+    m_Changed.clear();
+    m_BVH.Build(nullptr, 0);
+    m_BVHDirty = false;
+    m_Stats = CullingStats();
+}
+
+void CullingSystem::Update(const TransformSystem& transforms, ThreadPool* pool) {
+    size_t count = m_Transforms.size();
+    bool all = m_BVHDirty;
+
+    m_Stats.objects = count;
+    m_Stats.boundsUpdates = 0;
+
+    if (pool == nullptr || count <= TRANSFORM_BATCH_SIZE) {
+        updateBounds(transforms, 0, count, all);
+    } else {
+        for (size_t begin = 0; begin < count; begin += TRANSFORM_BATCH_SIZE) {
+            size_t end = std::min(count, begin + TRANSFORM_BATCH_SIZE);
+            pool->Submit([this, &transforms, begin, end, all]() { updateBounds(transforms, begin, end, all); });
+        }
+
+        pool->Wait();
+    }
+
+    for (uint8_t changed : m_Changed) {
+        m_Stats.boundsUpdates += changed;
+    }
+
+    if (m_BVHDirty) {
+        m_BVH.Build(m_WorldBounds.data(), count);
+        m_BVHDirty = false;
+        m_Stats.rebuilds++;
+    } else if (m_Stats.boundsUpdates > 0 && m_BVH.Refit(m_WorldBounds.data(), m_Changed.data())) {
+        m_Stats.rebuilds++;
+    }
+}
+
+void CullingSystem::Cull(const glm::mat4& viewProjection, std::vector<uint32_t>& visible, ThreadPool* pool) {
+    m_BVH.Cull(ExtractFrustum(viewProjection), visible, pool);
+    m_Stats.visible = visible.size();
+}
+
+const AABB& CullingSystem::GetWorldBounds(uint32_t object) const {
+    return m_WorldBounds[object];
+}
+
+const AABB* CullingSystem::GetWorldBoundsData() const {
+    return m_WorldBounds.data();
+}
+
+size_t CullingSystem::GetCount() const {
+    return m_Transforms.size();
+}
+
+const CullingStats& CullingSystem::GetStats() const {
+    return m_Stats;
+}
+
+void CullingSystem::updateBounds(const TransformSystem& transforms, size_t begin, size_t end, bool all) {
+    const uint8_t* changed = transforms.GetChanged();
+    const glm::mat4* world = transforms.GetWorldMatrices();
+
+    for (size_t i = begin; i < end; i++) {
+        TransformHandle transform = m_Transforms[i];
+
+        m_Changed[i] = all || changed[transform] ? 1 : 0;
+        if (m_Changed[i]) {
+            m_WorldBounds[i] = TransformAABB(m_LocalBounds[i], world[transform]);
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bounds.hpp"
+#include "bvh.hpp"
+#include "thread_pool.hpp"
+#include "transform_system.hpp"
+
+struct CullingStats {
+    size_t objects = 0;
+    size_t visible = 0;
+    size_t boundsUpdates = 0;
+    size_t rebuilds = 0;
+};
+
+// Keeps the world bounds of objects placed by a TransformSystem in a BVH and
+// finds the ones inside a view frustum. Objects are identified by the order
+// in which they were added.
+class CullingSystem {
+public:
+    CullingSystem();
+
+    // localBounds is usually Model::GetBounds of the model drawn at transform.
+    uint32_t Add(TransformHandle transform, const AABB& localBounds);
+    void Clear();
+
+    // Has to run after every TransformSystem::Update, it only looks at the
+    // transforms that the last update changed. The first update after Add
+    // rebuilds the tree, later ones refit it.
+    void Update(const TransformSystem& transforms, ThreadPool* pool = nullptr);
+
+    // Replaces the contents of visible with the objects that intersect the frustum of viewProjection.
+    void Cull(const glm::mat4& viewProjection, std::vector<uint32_t>& visible, ThreadPool* pool = nullptr);
+
+    const AABB& GetWorldBounds(uint32_t object) const;
+
+    // Indexed by object, for tests that take the ids returned by Cull.
+    const AABB* GetWorldBoundsData() const;
+    size_t GetCount() const;
+
+    // Counters of the last Update and Cull. rebuilds keeps counting up.
+    const CullingStats& GetStats() const;
+
+private:
+    std::vector<TransformHandle> m_Transforms;
+    std::vector<AABB> m_LocalBounds;
+    std::vector<AABB> m_WorldBounds;
+    std::vector<uint8_t> m_Changed;
+
+    BVH m_BVH;
+    bool m_BVHDirty;
+
+    CullingStats m_Stats;
+
+    void updateBounds(const TransformSystem& transforms, size_t begin, size_t end, bool all);
+};
@@ -0,0 +1,181 @@
+#include "deferred_renderer.hpp"
+#include "light_buffer.hpp"
+#include "gl_state.hpp"
+
+#include <iostream>
+
+DeferredRenderer::DeferredRenderer(std::shared_ptr<Shader> lightShader, std::shared_ptr<Shader> compositeShader)
+    : m_LightShader(lightShader), m_CompositeShader(compositeShader), m_GBuffer(0), m_PositionTexture(0), m_NormalTexture(0), m_AlbedoTexture(0), m_DepthRenderbuffer(0),
+      m_AccumulationBuffer(0), m_AccumulationTexture(0), m_EmptyVAO(0), m_Width(0), m_Height(0) {
+    GL_CHECK(glGenVertexArrays(1, &m_EmptyVAO));
+
+    // The samplers never move, so they are set once here.
+    m_LightShader->Use();
+    m_LightShader->Set(m_LightShader->GetUniform<int>("uLights"), static_cast<int>(LIGHT_BUFFER_TEXTURE_UNIT));
+    m_LightShader->Set(m_LightShader->GetUniform<int>("uGPosition"), static_cast<int>(GBUFFER_POSITION_TEXTURE_UNIT));
+    m_LightShader->Set(m_LightShader->GetUniform<int>("uGNormal"), static_cast<int>(GBUFFER_NORMAL_TEXTURE_UNIT));
+
+    m_CompositeShader->Use();
+    m_CompositeShader->Set(m_CompositeShader->GetUniform<int>("uGAlbedo"), static_cast<int>(GBUFFER_ALBEDO_TEXTURE_UNIT));
+    m_CompositeShader->Set(m_CompositeShader->GetUniform<int>("uLighting"), static_cast<int>(LIGHT_ACCUMULATION_TEXTURE_UNIT));
+}
+
+DeferredRenderer::~DeferredRenderer() {
+    destroyTargets();
+    glState.DeleteVertexArray(m_EmptyVAO);
+}
+
+void DeferredRenderer::Resize(GLsizei width, GLsizei height) {
+    if (width == m_Width && height == m_Height) {
+        return;
+    }
+
+    destroyTargets();
+
+    m_Width = width;
+    m_Height = height;
+
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    // Positions need the full float range, normals and light sums do fine with half floats.
+    m_PositionTexture = createTarget(GL_RGBA32F, GL_RGBA, GL_FLOAT);
+    m_NormalTexture = createTarget(GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT);
+    m_AlbedoTexture = createTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    m_AccumulationTexture = createTarget(GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT);
+
+    // Same format as the default framebuffer, so the depth can be blitted over.
+    GL_CHECK(glGenRenderbuffers(1, &m_DepthRenderbuffer));
+    GL_CHECK(glBindRenderbuffer(GL_RENDERBUFFER, m_DepthRenderbuffer));
+    GL_CHECK(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height));
+    GL_CHECK(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+
+    GL_CHECK(glGenFramebuffers(1, &m_GBuffer));
+    GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, m_GBuffer));
+    GL_CHECK(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_PositionTexture, 0));
+    GL_CHECK(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_NormalTexture, 0));
+    GL_CHECK(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, m_AlbedoTexture, 0));
+    GL_CHECK(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_DepthRenderbuffer));
+
+    const GLenum attachments[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+    GL_CHECK(glDrawBuffers(3, attachments));
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Error: G-buffer of " << width << "x" << height << " is incomplete!\n";
+    }
+
+    GL_CHECK(glGenFramebuffers(1, &m_AccumulationBuffer));
+    GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, m_AccumulationBuffer));
+    GL_CHECK(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_AccumulationTexture, 0));
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Error: light accumulation buffer of " << width << "x" << height << " is incomplete!\n";
+    }
+
+    GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+void DeferredRenderer::BeginGeometryPass() {
+    GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, m_GBuffer));
+    glState.SetViewport(0, 0, m_Width, m_Height);
+
+    // A zero position w marks pixels no surface was written to, the lighting pass skips them.
+    const GLfloat zero[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    glState.SetDepthWrite(true);
+    for (GLint i = 0; i < 3; i++) {
+        GL_CHECK(glClearBufferfv(GL_COLOR, i, zero));
+    }
+    GL_CHECK(glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0));
+}
+
+void DeferredRenderer::LightingPass(GLint lightCount) {
+    GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, m_AccumulationBuffer));
+
+    const GLfloat zero[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    GL_CHECK(glClearBufferfv(GL_COLOR, 0, zero));
+
+    if (lightCount <= 0) {
+        return;
+    }
+
+    GL_CHECK(glActiveTexture(GL_TEXTURE0 + GBUFFER_POSITION_TEXTURE_UNIT));
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, m_PositionTexture));
+    GL_CHECK(glActiveTexture(GL_TEXTURE0 + GBUFFER_NORMAL_TEXTURE_UNIT));
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, m_NormalTexture));
+
+    // Light quads overlap, every one adds to what the others wrote.
+    glState.SetDepthTest(false);
+    glState.SetDepthWrite(false);
+    glState.SetBlend(true);
+    glState.SetBlendFunc(GL_ONE, GL_ONE);
+
+    m_LightShader->Use();
+    glState.BindVertexArray(m_EmptyVAO);
+    GL_CHECK(glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, lightCount));
+
+    glState.SetBlend(false);
+    glState.SetDepthWrite(true);
+    glState.SetDepthTest(true);
+}
+
+void DeferredRenderer::Composite(GLuint framebuffer) {
+    GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+
+    GL_CHECK(glActiveTexture(GL_TEXTURE0 + GBUFFER_ALBEDO_TEXTURE_UNIT));
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, m_AlbedoTexture));
+    GL_CHECK(glActiveTexture(GL_TEXTURE0 + LIGHT_ACCUMULATION_TEXTURE_UNIT));
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, m_AccumulationTexture));
+
+    // Every pixel is overwritten, there is nothing to test against.
+    glState.SetDepthTest(false);
+
+    m_CompositeShader->Use();
+    glState.BindVertexArray(m_EmptyVAO);
+    GL_CHECK(glDrawArrays(GL_TRIANGLES, 0, 3));
+
+    glState.SetDepthTest(true);
+
+    GL_CHECK(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_GBuffer));
+    GL_CHECK(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer));
+    GL_CHECK(glBlitFramebuffer(0, 0, m_Width, m_Height, 0, 0, m_Width, m_Height, GL_DEPTH_BUFFER_BIT, GL_NEAREST));
+    GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+}
+
+GLsizei DeferredRenderer::GetWidth() const {
+    return m_Width;
+}
+
+GLsizei DeferredRenderer::GetHeight() const {
+    return m_Height;
+}
+
+void DeferredRenderer::destroyTargets() {
+    if (m_GBuffer == 0) {
+        return;
+    }
+
+    GL_CHECK(glDeleteFramebuffers(1, &m_GBuffer));
+    GL_CHECK(glDeleteFramebuffers(1, &m_AccumulationBuffer));
+    GL_CHECK(glDeleteRenderbuffers(1, &m_DepthRenderbuffer));
+
+    const GLuint textures[] = { m_PositionTexture, m_NormalTexture, m_AlbedoTexture, m_AccumulationTexture };
+    GL_CHECK(glDeleteTextures(4, textures));
+
+    m_GBuffer = m_AccumulationBuffer = m_DepthRenderbuffer = 0;
+    m_PositionTexture = m_NormalTexture = m_AlbedoTexture = m_AccumulationTexture = 0;
+}
+
+GLuint DeferredRenderer::createTarget(GLenum internalFormat, GLenum format, GLenum type) {
+    GLuint texture = 0;
+    GL_CHECK(glGenTextures(1, &texture));
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, texture));
+    GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, m_Width, m_Height, 0, format, type, nullptr));
+
+    // Only read with texelFetch, but a texture without mipmaps is incomplete with the default filter.
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
+
+    return texture;
+}
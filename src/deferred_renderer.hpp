@@ -0,0 +1,74 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <memory>
+
+#include "utility.hpp"
+#include "shader.hpp"
+
+// Texture units the G-buffer is read from during the lighting and composite
+// passes. Unit 0 stays with the light buffer.
+constexpr GLuint GBUFFER_POSITION_TEXTURE_UNIT = 1;
+constexpr GLuint GBUFFER_NORMAL_TEXTURE_UNIT = 2;
+constexpr GLuint GBUFFER_ALBEDO_TEXTURE_UNIT = 3;
+constexpr GLuint LIGHT_ACCUMULATION_TEXTURE_UNIT = 4;
+
+// Deferred shading. The geometry pass writes world position, normal and
+// albedo of the nearest surface to the G-buffer, built with the GBUFFER
+// variant of cube.frag. The lighting pass then draws one quad per light,
+// covering only the screen space extent of the light's radius, and adds its
+// contribution to an accumulation target. Composite multiplies the clamped sum
+// by the albedo into the target framebuffer and copies the depth along, so
+// forward drawn objects can be depth tested against the scene afterwards.
+//
+// The cost of a light depends on the pixels it covers instead of the number
+// of objects, which pays off with many small lights.
+class DeferredRenderer {
+public:
+    // lightShader is built from deferred_light.vert and .frag, compositeShader
+    // from deferred_composite.vert and .frag.
+    DeferredRenderer(std::shared_ptr<Shader> lightShader, std::shared_ptr<Shader> compositeShader);
+    ~DeferredRenderer();
+
+    DeferredRenderer(const DeferredRenderer&) = delete;
+    DeferredRenderer& operator=(const DeferredRenderer&) = delete;
+
+    // (Re)creates the render targets when the size changed.
+    void Resize(GLsizei width, GLsizei height);
+
+    // Binds and clears the G-buffer. Draw the scene with G-buffer shaders afterwards.
+    void BeginGeometryPass();
+
+    // Accumulates the first lightCount lights of the light buffer bound to
+    // LIGHT_BUFFER_TEXTURE_UNIT.
+    void LightingPass(GLint lightCount);
+
+    // Writes the shaded image and the depth to framebuffer, and leaves it bound.
+    void Composite(GLuint framebuffer = 0);
+
+    GLsizei GetWidth() const;
+    GLsizei GetHeight() const;
+
+private:
+    std::shared_ptr<Shader> m_LightShader;
+    std::shared_ptr<Shader> m_CompositeShader;
+
+    GLuint m_GBuffer;
+    GLuint m_PositionTexture;
+    GLuint m_NormalTexture;
+    GLuint m_AlbedoTexture;
+    GLuint m_DepthRenderbuffer;
+
+    GLuint m_AccumulationBuffer;
+    GLuint m_AccumulationTexture;
+
+    // Both passes generate their vertices from gl_VertexID, but core profile
+    // still needs a vertex array to be bound.
+    GLuint m_EmptyVAO;
+
+    GLsizei m_Width, m_Height;
+
+    void destroyTargets();
+    GLuint createTarget(GLenum internalFormat, GLenum format, GLenum type);
+};
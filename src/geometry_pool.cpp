@@ -0,0 +1,350 @@
+#include "geometry_pool.hpp"
+#include "gl_state.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+void SetVertexAttributes(const VertexLayout& layout) {
+    for (uint32_t i = 0; i < layout.attributeCount; i++) {
+        const VertexAttribute& attribute = layout.attributes[i];
+
+        GL_CHECK(glVertexAttribPointer(attribute.location, attribute.components, attribute.type, attribute.normalized ? GL_TRUE : GL_FALSE, layout.stride, reinterpret_cast<void*>(static_cast<size_t>(attribute.offset))));
+        GL_CHECK(glEnableVertexAttribArray(attribute.location));
+    }
+}
+
+void CreateGeometryBuffers(const VertexLayout& layout, size_t vertexBytes, const void* vertexData, size_t indexBytes, const void* indexData, GLuint& vertexArray, GLuint& vertexBuffer, GLuint& indexBuffer) {
+    GL_CHECK(glGenVertexArrays(1, &vertexArray));
+    glState.BindVertexArray(vertexArray);
+
+    GL_CHECK(glGenBuffers(1, &vertexBuffer));
+    glState.BindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertexData, GL_STATIC_DRAW));
+
+    GL_CHECK(glGenBuffers(1, &indexBuffer));
+    glState.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indexData, GL_STATIC_DRAW));
+
+    SetVertexAttributes(layout);
+
+    // The element buffer binding is part of the vertex array, so it is only unbound after it.
+    glState.BindVertexArray(0);
+    glState.BindBuffer(GL_ARRAY_BUFFER, 0);
+    glState.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+RangeAllocator::RangeAllocator(size_t size) : m_Size(size), m_FreeBytes(size) {
+    if (size > 0) {
+        m_Free[0] = size;
+    }
+}
+
+size_t RangeAllocator::Allocate(size_t size, size_t alignment) {
+    alignment = std::max<size_t>(alignment, 1);
+
+    for (auto it = m_Free.begin(); it != m_Free.end(); ++it) {
+        size_t blockOffset = it->first;
+        size_t blockEnd = it->first + it->second;
+
+        // Vertex strides are not always powers of two, so align by division.
+        size_t offset = (blockOffset + alignment - 1) / alignment * alignment;
+        if (offset + size > blockEnd) {
+            continue;
+        }
+
+        m_Free.erase(it);
+
+        if (offset > blockOffset) {
+            m_Free[blockOffset] = offset - blockOffset;
+        }
+
+        if (offset + size < blockEnd) {
+            m_Free[offset + size] = blockEnd - (offset + size);
+        }
+
+        m_FreeBytes -= size;
+        return offset;
+    }
+
+    return INVALID;
+}
+
+void RangeAllocator::Free(size_t offset, size_t size) {
+    auto it = m_Free.emplace(offset, size).first;
+    m_FreeBytes += size;
+
+    auto next = std::next(it);
+    if (next != m_Free.end() && it->first + it->second == next->first) {
+        it->second += next->second;
+        m_Free.erase(next);
+    }
+
+    if (it != m_Free.begin()) {
+        auto previous = std::prev(it);
+        if (previous->first + previous->second == it->first) {
+            previous->second += it->second;
+            m_Free.erase(it);
+        }
+    }
+}
+
+size_t RangeAllocator::GetSize() const {
+    return m_Size;
+}
+
+size_t RangeAllocator::GetFreeBytes() const {
+    return m_FreeBytes;
+}
+
+// Pages are shared by meshes whose vertices are read the same way. The
+// dequantization differs per mesh but is applied by the model matrix.
+static bool sameVertexFormat(const VertexLayout& a, const VertexLayout& b) {
+    if (a.stride != b.stride || a.attributeCount != b.attributeCount || a.flags != b.flags) {
+        return false;
+    }
+
+    return std::memcmp(a.attributes, b.attributes, a.attributeCount * sizeof(VertexAttribute)) == 0;
+}
+
+static void hashBytes(uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+    // FNV-1a
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+}
+
+GeometryPool::GeometryPool(size_t vertexPageSize, size_t indexPageSize) : m_VertexPageSize(vertexPageSize), m_IndexPageSize(indexPageSize), m_Entries(1) {}
+
+GeometryPool::~GeometryPool() {
+    for (const std::unique_ptr<Page>& page : m_Pages) {
+        glState.DeleteVertexArray(page->vertexArray);
+        glState.DeleteBuffer(page->vertexBuffer);
+        glState.DeleteBuffer(page->indexBuffer);
+    }
+}
+
+GeometryAllocation GeometryPool::Acquire(const MeshData& mesh) {
+    if (!mesh.IsValid()) {
+        std::cerr << "Error: Geometry pool given no mesh data!\n";
+        return GeometryAllocation();
+    }
+
+    size_t vertexBytes = mesh.vertexBytes;
+    size_t indexBytes = mesh.indexCount * GetIndexSize(mesh.indexType);
+
+    uint64_t hash = HashMesh(mesh);
+
+    // A matching hash is only trusted once the contents compare equal, so
+    // meshes that collide get an allocation each instead of sharing one.
+    auto range = m_Lookup.equal_range(hash);
+    for (auto found = range.first; found != range.second; ++found) {
+        Entry& entry = m_Entries[found->second];
+        if (!sameMesh(entry, mesh)) {
+            continue;
+        }
+
+        entry.references++;
+
+        m_Stats.references++;
+        m_Stats.sharedBytes += vertexBytes + indexBytes;
+        return entry.allocation;
+    }
+
+    const VertexLayout& layout = mesh.layout;
+    size_t indexAlignment = GetIndexSize(mesh.indexType);
+
+    uint32_t pageIndex = 0;
+    size_t vertexOffset = RangeAllocator::INVALID;
+    size_t indexOffset = RangeAllocator::INVALID;
+
+    for (; pageIndex < m_Pages.size(); pageIndex++) {
+        Page& page = *m_Pages[pageIndex];
+        if (!sameVertexFormat(page.layout, layout)) {
+            continue;
+        }
+
+        vertexOffset = page.vertices.Allocate(vertexBytes, layout.stride);
+        if (vertexOffset == RangeAllocator::INVALID) {
+            continue;
+        }
+
+        indexOffset = page.indices.Allocate(indexBytes, indexAlignment);
+        if (indexOffset != RangeAllocator::INVALID) {
+            break;
+        }
+
+        page.vertices.Free(vertexOffset, vertexBytes);
+        vertexOffset = RangeAllocator::INVALID;
+    }
+
+    if (vertexOffset == RangeAllocator::INVALID) {
+        pageIndex = createPage(layout, vertexBytes, indexBytes);
+        vertexOffset = m_Pages[pageIndex]->vertices.Allocate(vertexBytes, layout.stride);
+        indexOffset = m_Pages[pageIndex]->indices.Allocate(indexBytes, indexAlignment);
+    }
+
+    Page& page = *m_Pages[pageIndex];
+
+    // Uploaded through the copy target, the element buffer binding belongs to
+    // whatever vertex array happens to be bound.
+    GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, page.vertexBuffer));
+    GL_CHECK(glBufferSubData(GL_COPY_WRITE_BUFFER, vertexOffset, vertexBytes, mesh.vertexData));
+    GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, page.indexBuffer));
+    GL_CHECK(glBufferSubData(GL_COPY_WRITE_BUFFER, indexOffset, indexBytes, mesh.indexData));
+    GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+
+    uint32_t slot;
+    if (!m_FreeEntries.empty()) {
+        slot = m_FreeEntries.back();
+        m_FreeEntries.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(m_Entries.size());
+        m_Entries.emplace_back();
+    }
+
+    Entry& entry = m_Entries[slot];
+    entry.hash = hash;
+    entry.page = pageIndex;
+    entry.vertexOffset = vertexOffset;
+    entry.vertexBytes = vertexBytes;
+    entry.indexBytes = indexBytes;
+    entry.references = 1;
+
+    const unsigned char* vertexData = static_cast<const unsigned char*>(mesh.vertexData);
+    const unsigned char* indexData = static_cast<const unsigned char*>(mesh.indexData);
+    entry.vertices.assign(vertexData, vertexData + vertexBytes);
+    entry.indices.assign(indexData, indexData + indexBytes);
+
+    entry.allocation.vertexArray = page.vertexArray;
+    entry.allocation.vertexBuffer = page.vertexBuffer;
+    entry.allocation.indexBuffer = page.indexBuffer;
+    entry.allocation.baseVertex = static_cast<GLint>(vertexOffset / layout.stride);
+    entry.allocation.indexOffset = indexOffset;
+    entry.allocation.indexCount = static_cast<GLsizei>(mesh.indexCount);
+    entry.allocation.indexType = mesh.indexType;
+    entry.allocation.entry = slot;
+
+    m_Lookup.emplace(hash, slot);
+
+    m_Stats.meshes++;
+    m_Stats.references++;
+    m_Stats.uploadedBytes += vertexBytes + indexBytes;
+
+    return entry.allocation;
+}
+
+void GeometryPool::Release(const GeometryAllocation& allocation) {
+    if (allocation.entry == 0 || allocation.entry >= m_Entries.size()) {
+        return;
+    }
+
+    Entry& entry = m_Entries[allocation.entry];
+    if (entry.references == 0) {
+        return;
+    }
+
+    m_Stats.references--;
+
+    if (--entry.references > 0) {
+        return;
+    }
+
+    Page& page = *m_Pages[entry.page];
+    page.vertices.Free(entry.vertexOffset, entry.vertexBytes);
+    page.indices.Free(entry.allocation.indexOffset, entry.indexBytes);
+
+    auto range = m_Lookup.equal_range(entry.hash);
+    for (auto found = range.first; found != range.second; ++found) {
+        if (found->second == allocation.entry) {
+            m_Lookup.erase(found);
+            break;
+        }
+    }
+
+    std::vector<unsigned char>().swap(entry.vertices);
+    std::vector<unsigned char>().swap(entry.indices);
+
+    m_FreeEntries.push_back(allocation.entry);
+
+    m_Stats.meshes--;
+}
+
+GLuint GeometryPool::CreateVertexArray(const GeometryAllocation& allocation) const {
+    if (allocation.entry == 0) {
+        return 0;
+    }
+
+    const Page& page = *m_Pages[m_Entries[allocation.entry].page];
+
+    GLuint vertexArray = 0;
+    GL_CHECK(glGenVertexArrays(1, &vertexArray));
+    glState.BindVertexArray(vertexArray);
+
+    glState.BindBuffer(GL_ARRAY_BUFFER, page.vertexBuffer);
+    glState.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, page.indexBuffer);
+    SetVertexAttributes(page.layout);
+
+    glState.BindVertexArray(0);
+    glState.BindBuffer(GL_ARRAY_BUFFER, 0);
+    glState.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    return vertexArray;
+}
+
+const GeometryPoolStats& GeometryPool::GetStats() const {
+    return m_Stats;
+}
+
+uint64_t GeometryPool::HashMesh(const MeshData& mesh) {
+    const VertexLayout& layout = mesh.layout;
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    hashBytes(hash, &layout.stride, sizeof(layout.stride));
+    hashBytes(hash, &layout.attributeCount, sizeof(layout.attributeCount));
+    hashBytes(hash, layout.attributes, layout.attributeCount * sizeof(VertexAttribute));
+    hashBytes(hash, &layout.flags, sizeof(layout.flags));
+
+    uint64_t indexCount = mesh.indexCount;
+    hashBytes(hash, &mesh.indexType, sizeof(mesh.indexType));
+    hashBytes(hash, &indexCount, sizeof(indexCount));
+
+    hashBytes(hash, mesh.vertexData, mesh.vertexBytes);
+    hashBytes(hash, mesh.indexData, mesh.indexCount * GetIndexSize(mesh.indexType));
+
+    return hash;
+}
+
+uint32_t GeometryPool::createPage(const VertexLayout& layout, size_t vertexBytes, size_t indexBytes) {
+    auto page = std::make_unique<Page>();
+    page->layout = layout;
+
+    size_t vertexSize = std::max(m_VertexPageSize, vertexBytes);
+    size_t indexSize = std::max(m_IndexPageSize, indexBytes);
+    page->vertices = RangeAllocator(vertexSize);
+    page->indices = RangeAllocator(indexSize);
+
+    CreateGeometryBuffers(layout, vertexSize, nullptr, indexSize, nullptr, page->vertexArray, page->vertexBuffer, page->indexBuffer);
+
+    m_Pages.push_back(std::move(page));
+    m_Stats.pages = m_Pages.size();
+    m_Stats.pageBytes += vertexSize + indexSize;
+
+    return static_cast<uint32_t>(m_Pages.size() - 1);
+}
+
+bool GeometryPool::sameMesh(const Entry& entry, const MeshData& mesh) const {
+    size_t indexBytes = mesh.indexCount * GetIndexSize(mesh.indexType);
+    if (entry.vertices.size() != mesh.vertexBytes || entry.indices.size() != indexBytes || entry.allocation.indexType != mesh.indexType) {
+        return false;
+    }
+
+    if (!sameVertexFormat(m_Pages[entry.page]->layout, mesh.layout)) {
+        return false;
+    }
+
+    return std::memcmp(entry.vertices.data(), mesh.vertexData, mesh.vertexBytes) == 0 && std::memcmp(entry.indices.data(), mesh.indexData, indexBytes) == 0;
+}
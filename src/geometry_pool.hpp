@@ -0,0 +1,140 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "utility.hpp"
+#include "mesh_data.hpp"
+#include "vertex_layout.hpp"
+
+// Size of the buffers of a pool page. Meshes that do not fit get a page of their own.
+constexpr size_t GEOMETRY_POOL_VERTEX_PAGE_SIZE = 8u << 20;
+constexpr size_t GEOMETRY_POOL_INDEX_PAGE_SIZE = 2u << 20;
+
+// Where a mesh lives inside the pool. Draw it with the page's vertex array,
+// indexCount indices of indexType starting at indexOffset bytes into the
+// element buffer, and baseVertex added to every index.
+struct GeometryAllocation {
+    GLuint vertexArray = 0;
+    GLuint vertexBuffer = 0;
+    GLuint indexBuffer = 0;
+    GLint baseVertex = 0;
+    size_t indexOffset = 0;
+    GLsizei indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_SHORT;
+    uint32_t entry = 0;
+
+    bool IsValid() const { return vertexArray != 0; }
+};
+
+struct GeometryPoolStats {
+    size_t pages = 0;
+    size_t pageBytes = 0;       // vertex and index buffer storage of every page
+    size_t meshes = 0;
+    size_t references = 0;
+    size_t uploadedBytes = 0;
+    size_t sharedBytes = 0;     // bytes not uploaded because the mesh was already pooled
+};
+
+// Sets up the attributes of layout for the bound vertex array and array buffer.
+void SetVertexAttributes(const VertexLayout& layout);
+
+// Creates a vertex array for layout with a vertex and an index buffer of the
+// given sizes. Null data leaves the buffer contents undefined.
+void CreateGeometryBuffers(const VertexLayout& layout, size_t vertexBytes, const void* vertexData, size_t indexBytes, const void* indexData, GLuint& vertexArray, GLuint& vertexBuffer, GLuint& indexBuffer);
+
+// Offset ranges in a buffer, handed out first fit from a list of free blocks
+// that are merged with their neighbours when released.
+class RangeAllocator {
+public:
+    static constexpr size_t INVALID = ~size_t(0);
+
+    explicit RangeAllocator(size_t size = 0);
+
+    // Returns INVALID when there is no free block large enough.
+    size_t Allocate(size_t size, size_t alignment);
+    void Free(size_t offset, size_t size);
+
+    size_t GetSize() const;
+    size_t GetFreeBytes() const;
+
+private:
+    // Free blocks by offset.
+    std::map<size_t, size_t> m_Free;
+    size_t m_Size;
+    size_t m_FreeBytes;
+};
+
+// Keeps the geometry of many meshes in a few large buffers. Meshes with the
+// same vertex layout share pages, each one a vertex buffer, an element buffer
+// and a vertex array set up for that layout, so switching between them needs
+// no bind at all and consecutive draws can be merged into one multi-draw.
+//
+// Meshes are identified by a hash of their layout and contents, checked
+// against a copy of the mesh kept in memory. Acquiring a mesh that is already
+// in the pool only adds a reference, so the same mesh loaded for several
+// models is uploaded once. GL objects are created on first
+// use, so a pool can be made before the context exists.
+class GeometryPool {
+public:
+    GeometryPool(size_t vertexPageSize = GEOMETRY_POOL_VERTEX_PAGE_SIZE, size_t indexPageSize = GEOMETRY_POOL_INDEX_PAGE_SIZE);
+    ~GeometryPool();
+
+    GeometryPool(const GeometryPool&) = delete;
+    GeometryPool& operator=(const GeometryPool&) = delete;
+
+    GeometryAllocation Acquire(const MeshData& mesh);
+
+    // Frees the ranges of the mesh once its last reference is released.
+    void Release(const GeometryAllocation& allocation);
+
+    // A new vertex array over the page buffers of allocation with its layout
+    // set up, for users that need attributes of their own such as instancing.
+    // The caller owns it.
+    GLuint CreateVertexArray(const GeometryAllocation& allocation) const;
+
+    const GeometryPoolStats& GetStats() const;
+
+    // Covers the attribute layout and the vertex and index data, but not the
+    // dequantization, which is applied per model.
+    static uint64_t HashMesh(const MeshData& mesh);
+
+private:
+    struct Page {
+        VertexLayout layout;
+        GLuint vertexArray, vertexBuffer, indexBuffer;
+        RangeAllocator vertices, indices;
+    };
+
+    struct Entry {
+        uint64_t hash;
+        uint32_t page;
+        size_t vertexOffset, vertexBytes;
+        size_t indexBytes;
+        uint32_t references;
+        GeometryAllocation allocation;
+
+        // What was uploaded, to tell meshes with the same hash apart.
+        std::vector<unsigned char> vertices, indices;
+    };
+
+    size_t m_VertexPageSize, m_IndexPageSize;
+
+    std::vector<std::unique_ptr<Page>> m_Pages;
+
+    // Slot 0 is never used, so a zero entry marks an allocation from outside the pool.
+    std::vector<Entry> m_Entries;
+    std::vector<uint32_t> m_FreeEntries;
+    std::unordered_multimap<uint64_t, uint32_t> m_Lookup;
+
+    GeometryPoolStats m_Stats;
+
+    uint32_t createPage(const VertexLayout& layout, size_t vertexBytes, size_t indexBytes);
+    bool sameMesh(const Entry& entry, const MeshData& mesh) const;
+};
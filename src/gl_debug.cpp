@@ -0,0 +1,249 @@
+#include "gl_debug.hpp"
+#include "gl_extensions.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+GLDebug glDebug;
+
+constexpr size_t RING_MASK = GL_DEBUG_RING_SIZE - 1;
+
+static_assert((GL_DEBUG_RING_SIZE & RING_MASK) == 0, "GL_DEBUG_RING_SIZE must be a power of two");
+
+static DebugSeverity toSeverity(GLenum severity) {
+    switch (severity) {
+        case GL_DEBUG_SEVERITY_HIGH:   return DEBUG_SEVERITY_HIGH;
+        case GL_DEBUG_SEVERITY_MEDIUM: return DEBUG_SEVERITY_MEDIUM;
+        case GL_DEBUG_SEVERITY_LOW:    return DEBUG_SEVERITY_LOW;
+        default:                       return DEBUG_SEVERITY_NOTIFICATION;
+    }
+}
+
+static uint32_t toSource(GLenum source) {
+    switch (source) {
+        case GL_DEBUG_SOURCE_API:             return DEBUG_SOURCE_API;
+        case GL_DEBUG_SOURCE_WINDOW_SYSTEM:   return DEBUG_SOURCE_WINDOW_SYSTEM;
+        case GL_DEBUG_SOURCE_SHADER_COMPILER: return DEBUG_SOURCE_SHADER_COMPILER;
+        case GL_DEBUG_SOURCE_THIRD_PARTY:     return DEBUG_SOURCE_THIRD_PARTY;
+        case GL_DEBUG_SOURCE_APPLICATION:     return DEBUG_SOURCE_APPLICATION;
+        default:                              return DEBUG_SOURCE_OTHER;
+    }
+}
+
+static const char* severityName(GLenum severity) {
+    switch (severity) {
+        case GL_DEBUG_SEVERITY_HIGH:   return "high";
+        case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+        case GL_DEBUG_SEVERITY_LOW:    return "low";
+        default:                       return "notification";
+    }
+}
+
+static const char* sourceName(GLenum source) {
+    switch (source) {
+        case GL_DEBUG_SOURCE_API:             return "API";
+        case GL_DEBUG_SOURCE_WINDOW_SYSTEM:   return "window system";
+        case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+        case GL_DEBUG_SOURCE_THIRD_PARTY:     return "third party";
+        case GL_DEBUG_SOURCE_APPLICATION:     return "application";
+        default:                              return "other";
+    }
+}
+
+static const char* typeName(GLenum type) {
+    switch (type) {
+        case GL_DEBUG_TYPE_ERROR:               return "error";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  return "undefined behavior";
+        case GL_DEBUG_TYPE_PORTABILITY:         return "portability";
+        case GL_DEBUG_TYPE_PERFORMANCE:         return "performance";
+        case GL_DEBUG_TYPE_MARKER:              return "marker";
+        default:                                return "other";
+    }
+}
+
+// Drivers reuse ids for different messages, so the text is part of the key.
+static uint64_t messageKey(const GLDebugMessage& message) {
+    uint64_t hash = 14695981039346656037ull;
+
+    for (const char* c = message.text; *c; c++) {
+        hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ull;
+    }
+
+    return hash ^ (static_cast<uint64_t>(message.id) << 32) ^ (static_cast<uint64_t>(message.source) << 16) ^ message.type;
+}
+
+static bool isPowerOfTen(size_t value) {
+    while (value >= 10 && value % 10 == 0) {
+        value /= 10;
+    }
+
+    return value == 1;
+}
+
+GLDebug::GLDebug() : m_WriteIndex(0), m_ReadIndex(0), m_Dropped(0), m_MinSeverity(DEBUG_SEVERITY_LOW), m_Sources(DEBUG_SOURCE_ALL), m_Active(false) {
+    for (size_t i = 0; i < GL_DEBUG_RING_SIZE; i++) {
+        m_Ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool GLDebug::Init(DebugSeverity minSeverity, uint32_t sources) {
+#if GL_DEBUG_LEVEL > 0
+    if (!glExtensions.debugOutput) {
+        return false;
+    }
+
+    m_Active = true;
+    SetFilter(minSeverity, sources);
+
+    glExtensions.DebugMessageCallback(&GLDebug::callback, this);
+    glEnable(GL_DEBUG_OUTPUT);
+
+#if GL_DEBUG_LEVEL >= 2
+    // Keeps the callback on the thread and inside the call that caused it, so a breakpoint shows the culprit.
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+#endif
+
+    glErrorChecks = false;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void GLDebug::SetFilter(DebugSeverity minSeverity, uint32_t sources) {
+    m_MinSeverity.store(minSeverity, std::memory_order_relaxed);
+    m_Sources.store(sources, std::memory_order_relaxed);
+
+    if (!m_Active) {
+        return;
+    }
+
+    // Filter in the driver as well, so unwanted messages are never generated.
+    static const GLenum severities[] = { GL_DEBUG_SEVERITY_NOTIFICATION, GL_DEBUG_SEVERITY_LOW, GL_DEBUG_SEVERITY_MEDIUM, GL_DEBUG_SEVERITY_HIGH };
+    static const GLenum sourceEnums[] = { GL_DEBUG_SOURCE_API, GL_DEBUG_SOURCE_WINDOW_SYSTEM, GL_DEBUG_SOURCE_SHADER_COMPILER, GL_DEBUG_SOURCE_THIRD_PARTY, GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_SOURCE_OTHER };
+
+    glExtensions.DebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+
+    for (GLenum severity : severities) {
+        if (toSeverity(severity) < minSeverity) {
+            glExtensions.DebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, severity, 0, nullptr, GL_FALSE);
+        }
+    }
+
+    for (GLenum source : sourceEnums) {
+        if ((toSource(source) & sources) == 0) {
+            glExtensions.DebugMessageControl(source, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+        }
+    }
+}
+
+size_t GLDebug::Drain() {
+#if GL_DEBUG_LEVEL > 0
+    if (!m_Active) {
+        size_t errors = 0;
+
+        GLenum error;
+        while ((error = glGetError()) != GL_NO_ERROR) {
+            std::cerr << "[OpenGL Error] (" << error << ") during the last frame" << std::endl;
+            errors++;
+        }
+
+        return errors;
+    }
+
+    size_t count = 0;
+
+    for (;;) {
+        Slot& slot = m_Ring[m_ReadIndex & RING_MASK];
+        if (slot.sequence.load(std::memory_order_acquire) != m_ReadIndex + 1) {
+            break;
+        }
+
+        print(slot.message);
+
+        // Hand the slot back to the producers for the next lap of the ring.
+        slot.sequence.store(m_ReadIndex + GL_DEBUG_RING_SIZE, std::memory_order_release);
+        m_ReadIndex++;
+        count++;
+    }
+
+    size_t dropped = m_Dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        std::cerr << "[OpenGL Debug] " << dropped << " messages dropped, the ring buffer was full" << std::endl;
+    }
+
+    return count;
+#else
+    return 0;
+#endif
+}
+
+bool GLDebug::IsActive() const {
+    return m_Active;
+}
+
+size_t GLDebug::GetDroppedCount() const {
+    return m_Dropped.load(std::memory_order_relaxed);
+}
+
+bool GLDebug::accepts(GLenum source, GLenum severity) const {
+    return toSeverity(severity) >= m_MinSeverity.load(std::memory_order_relaxed) &&
+        (toSource(source) & m_Sources.load(std::memory_order_relaxed)) != 0;
+}
+
+void GLDebug::push(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* text) {
+    size_t position = m_WriteIndex.load(std::memory_order_relaxed);
+    Slot* slot;
+
+    // Bounded multi-producer queue: a slot is free for position when its
+    // sequence equals position, and the producers race for it with a CAS.
+    for (;;) {
+        slot = &m_Ring[position & RING_MASK];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+        if (difference == 0) {
+            if (m_WriteIndex.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            m_Dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            position = m_WriteIndex.load(std::memory_order_relaxed);
+        }
+    }
+
+    GLDebugMessage& message = slot->message;
+    message.source = source;
+    message.type = type;
+    message.id = id;
+    message.severity = severity;
+
+    size_t size = length < 0 ? std::strlen(text) : static_cast<size_t>(length);
+    size = std::min(size, GL_DEBUG_MESSAGE_LENGTH - 1);
+    std::memcpy(message.text, text, size);
+    message.text[size] = '\0';
+
+    slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+void GLDebug::print(const GLDebugMessage& message) {
+    size_t& seen = m_Seen[messageKey(message)];
+    seen++;
+
+    if (seen == 1) {
+        std::cerr << "[OpenGL Debug] (" << severityName(message.severity) << ", " << sourceName(message.source) << ", " << typeName(message.type) << " " << message.id << "): " << message.text << std::endl;
+    } else if (isPowerOfTen(seen)) {
+        std::cerr << "[OpenGL Debug] Message " << message.id << " repeated " << seen << " times" << std::endl;
+    }
+}
+
+void APIENTRY GLDebug::callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam) {
+    GLDebug* debug = static_cast<GLDebug*>(const_cast<void*>(userParam));
+
+    if (debug->accepts(source, severity)) {
+        debug->push(source, type, id, severity, length, message);
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "utility.hpp"
+
+// Must be a power of two.
+constexpr size_t GL_DEBUG_RING_SIZE = 256;
+constexpr size_t GL_DEBUG_MESSAGE_LENGTH = 256;
+
+enum DebugSeverity : uint8_t {
+    DEBUG_SEVERITY_NOTIFICATION = 0,
+    DEBUG_SEVERITY_LOW = 1,
+    DEBUG_SEVERITY_MEDIUM = 2,
+    DEBUG_SEVERITY_HIGH = 3,
+};
+
+enum DebugSource : uint32_t {
+    DEBUG_SOURCE_API = 1u << 0,
+    DEBUG_SOURCE_WINDOW_SYSTEM = 1u << 1,
+    DEBUG_SOURCE_SHADER_COMPILER = 1u << 2,
+    DEBUG_SOURCE_THIRD_PARTY = 1u << 3,
+    DEBUG_SOURCE_APPLICATION = 1u << 4,
+    DEBUG_SOURCE_OTHER = 1u << 5,
+    DEBUG_SOURCE_ALL = 0x3F,
+};
+
+struct GLDebugMessage {
+    GLenum source;
+    GLenum type;
+    GLuint id;
+    GLenum severity;
+    char text[GL_DEBUG_MESSAGE_LENGTH];
+};
+
+// Collects driver messages through KHR_debug. The callback may run on a driver
+// thread, so it only filters and pushes the message into a lock-free ring;
+// formatting, deduplication and printing happen in Drain on the GL thread.
+// Without KHR_debug, Drain polls glGetError once instead.
+class GLDebug {
+public:
+    GLDebug();
+
+    GLDebug(const GLDebug&) = delete;
+    GLDebug& operator=(const GLDebug&) = delete;
+
+    // Call once after LoadGLExtensions. Returns false when KHR_debug is not
+    // available or GL_DEBUG_LEVEL is 0.
+    bool Init(DebugSeverity minSeverity = DEBUG_SEVERITY_LOW, uint32_t sources = DEBUG_SOURCE_ALL);
+
+    void SetFilter(DebugSeverity minSeverity, uint32_t sources);
+
+    // Prints the queued messages and returns how many there were. Repeats of a
+    // message are only counted, with a reminder at every power of ten.
+    size_t Drain();
+
+    bool IsActive() const;
+    size_t GetDroppedCount() const;
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        GLDebugMessage message;
+    };
+
+    Slot m_Ring[GL_DEBUG_RING_SIZE];
+    std::atomic<size_t> m_WriteIndex;
+    size_t m_ReadIndex;
+    std::atomic<size_t> m_Dropped;
+
+    std::atomic<uint8_t> m_MinSeverity;
+    std::atomic<uint32_t> m_Sources;
+
+    std::unordered_map<uint64_t, size_t> m_Seen;
+    bool m_Active;
+
+    bool accepts(GLenum source, GLenum severity) const;
+    void push(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* text);
+    void print(const GLDebugMessage& message);
+
+    static void APIENTRY callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
+};
+
+extern GLDebug glDebug;
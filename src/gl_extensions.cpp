@@ -0,0 +1,64 @@
+#include "gl_extensions.hpp"
+
+#include <cstring>
+#include <iostream>
+
+GLExtensions glExtensions;
+
+bool HasGLExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (extension && std::strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool HasGLVersion(int major, int minor) {
+    return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+template <typename T>
+static bool loadFunction(GLADloadproc load, const char* name, T& function) {
+    function = reinterpret_cast<T>(load(name));
+    return function != nullptr;
+}
+
+void LoadGLExtensions(GLADloadproc load) {
+    glExtensions = GLExtensions();
+
+    if (HasGLVersion(4, 1) || HasGLExtension("GL_ARB_get_program_binary")) {
+        // A driver may expose the functions but support no binary formats at all.
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+        glExtensions.programBinary = formats > 0 &&
+            loadFunction(load, "glGetProgramBinary", glExtensions.GetProgramBinary) &&
+            loadFunction(load, "glProgramBinary", glExtensions.ProgramBinary) &&
+            loadFunction(load, "glProgramParameteri", glExtensions.ProgramParameteri);
+    }
+
+    // Core contexts expose KHR_debug without the KHR suffix on its functions.
+    if (HasGLVersion(4, 3) || HasGLExtension("GL_KHR_debug")) {
+        glExtensions.debugOutput =
+            loadFunction(load, "glDebugMessageCallback", glExtensions.DebugMessageCallback) &&
+            loadFunction(load, "glDebugMessageControl", glExtensions.DebugMessageControl);
+    }
+
+    if (HasGLVersion(4, 3) || (HasGLExtension("GL_ARB_draw_indirect") && HasGLExtension("GL_ARB_multi_draw_indirect"))) {
+        glExtensions.multiDrawIndirect = loadFunction(load, "glMultiDrawElementsIndirect", glExtensions.MultiDrawElementsIndirect);
+    }
+
+    // The shaders are #version 330 and can only use the extension, whatever the context version.
+    glExtensions.shaderDrawParameters = HasGLExtension("GL_ARB_shader_draw_parameters");
+
+    std::cout << "Program binaries: " << (glExtensions.programBinary ? "supported" : "unsupported") << std::endl;
+    std::cout << "Debug output: " << (glExtensions.debugOutput ? "supported" : "unsupported") << std::endl;
+    std::cout << "Multi-draw indirect: " << (glExtensions.multiDrawIndirect ? "supported" : "unsupported") << std::endl;
+    std::cout << "Shader draw parameters: " << (glExtensions.shaderDrawParameters ? "supported" : "unsupported") << std::endl;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// The bundled loader only covers core GL 3.3, so entry points from newer
+// versions and extensions are loaded here at runtime. Every feature has a flag
+// that is only set when the driver advertises it and all of its functions were
+// found, so callers must check the flag before using the functions.
+
+// ARB_get_program_binary (core in 4.1)
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+
+// KHR_debug (core in 4.3)
+#define GL_DEBUG_OUTPUT 0x92E0
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#define GL_CONTEXT_FLAG_DEBUG_BIT 0x00000002
+#define GL_DEBUG_SOURCE_API 0x8246
+#define GL_DEBUG_SOURCE_WINDOW_SYSTEM 0x8247
+#define GL_DEBUG_SOURCE_SHADER_COMPILER 0x8248
+#define GL_DEBUG_SOURCE_THIRD_PARTY 0x8249
+#define GL_DEBUG_SOURCE_APPLICATION 0x824A
+#define GL_DEBUG_SOURCE_OTHER 0x824B
+#define GL_DEBUG_TYPE_ERROR 0x824C
+#define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+#define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR 0x824E
+#define GL_DEBUG_TYPE_PORTABILITY 0x824F
+#define GL_DEBUG_TYPE_PERFORMANCE 0x8250
+#define GL_DEBUG_TYPE_OTHER 0x8251
+#define GL_DEBUG_TYPE_MARKER 0x8268
+#define GL_DEBUG_TYPE_PUSH_GROUP 0x8269
+#define GL_DEBUG_TYPE_POP_GROUP 0x826A
+#define GL_DEBUG_SEVERITY_HIGH 0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM 0x9147
+#define GL_DEBUG_SEVERITY_LOW 0x9148
+#define GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+
+typedef void (APIENTRYP PFNGLDEBUGMESSAGECALLBACKPROC)(GLDEBUGPROC callback, const void* userParam);
+typedef void (APIENTRYP PFNGLDEBUGMESSAGECONTROLPROC)(GLenum source, GLenum type, GLenum severity, GLsizei count, const GLuint* ids, GLboolean enabled);
+
+// ARB_draw_indirect (core in 4.0) and ARB_multi_draw_indirect (core in 4.3)
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+
+// Layout of the commands read by MultiDrawElementsIndirect.
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+
+struct GLExtensions {
+    bool programBinary = false;
+    PFNGLGETPROGRAMBINARYPROC GetProgramBinary = nullptr;
+    PFNGLPROGRAMBINARYPROC ProgramBinary = nullptr;
+    PFNGLPROGRAMPARAMETERIPROC ProgramParameteri = nullptr;
+
+    bool debugOutput = false;
+    PFNGLDEBUGMESSAGECALLBACKPROC DebugMessageCallback = nullptr;
+    PFNGLDEBUGMESSAGECONTROLPROC DebugMessageControl = nullptr;
+
+    bool multiDrawIndirect = false;
+    PFNGLMULTIDRAWELEMENTSINDIRECTPROC MultiDrawElementsIndirect = nullptr;
+
+    // ARB_shader_draw_parameters. Only adds gl_DrawIDARB and friends to GLSL,
+    // so there is nothing to load.
+    bool shaderDrawParameters = false;
+};
+
+extern GLExtensions glExtensions;
+
+// Must be called once after gladLoadGLLoader, with the same loader.
+void LoadGLExtensions(GLADloadproc load);
+
+bool HasGLExtension(const char* name);
+
+// True when the context version is at least major.minor.
+bool HasGLVersion(int major, int minor);
@@ -0,0 +1,214 @@
+#include "gl_state.hpp"
+
+GLState glState;
+
+GLState::GLState() {
+    Invalidate();
+}
+
+void GLState::Invalidate() {
+    m_Program = UNKNOWN;
+    m_VertexArray = UNKNOWN;
+    m_ArrayBuffer = UNKNOWN;
+    m_ElementBuffer = UNKNOWN;
+    m_UniformBuffer = UNKNOWN;
+
+    for (GLuint& binding : m_UniformBindings) {
+        binding = UNKNOWN;
+    }
+
+    m_DepthTest = TOGGLE_UNKNOWN;
+    m_DepthWrite = TOGGLE_UNKNOWN;
+    m_DepthFunc = UNKNOWN;
+
+    m_Blend = TOGGLE_UNKNOWN;
+    m_BlendSource = UNKNOWN;
+    m_BlendDestination = UNKNOWN;
+
+    // A negative size is never valid, so the first SetViewport always goes through.
+    m_Viewport[0] = m_Viewport[1] = 0;
+    m_Viewport[2] = m_Viewport[3] = -1;
+}
+
+void GLState::UseProgram(GLuint program) {
+    if (changed(m_Program, program)) {
+        GL_CHECK(glUseProgram(program));
+    }
+}
+
+void GLState::BindVertexArray(GLuint vertexArray) {
+    if (changed(m_VertexArray, vertexArray)) {
+        GL_CHECK(glBindVertexArray(vertexArray));
+
+        // The element buffer binding belongs to the vertex array.
+        m_ElementBuffer = UNKNOWN;
+    }
+}
+
+void GLState::BindBuffer(GLenum target, GLuint buffer) {
+    GLuint* cached = nullptr;
+
+    switch (target) {
+        case GL_ARRAY_BUFFER:         cached = &m_ArrayBuffer; break;
+        case GL_ELEMENT_ARRAY_BUFFER: cached = &m_ElementBuffer; break;
+        case GL_UNIFORM_BUFFER:       cached = &m_UniformBuffer; break;
+    }
+
+    if (!cached) {
+        m_Stats.issued++;
+        GL_CHECK(glBindBuffer(target, buffer));
+        return;
+    }
+
+    if (changed(*cached, buffer)) {
+        GL_CHECK(glBindBuffer(target, buffer));
+    }
+}
+
+void GLState::BindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    if (target != GL_UNIFORM_BUFFER || index >= GL_STATE_UNIFORM_BINDINGS) {
+        m_Stats.issued++;
+        GL_CHECK(glBindBufferBase(target, index, buffer));
+        return;
+    }
+
+    if (changed(m_UniformBindings[index], buffer)) {
+        GL_CHECK(glBindBufferBase(target, index, buffer));
+
+        // Binding an indexed point also replaces the generic binding.
+        m_UniformBuffer = buffer;
+    }
+}
+
+void GLState::SetDepthTest(bool enabled) {
+    setCapability(GL_DEPTH_TEST, m_DepthTest, enabled);
+}
+
+void GLState::SetDepthWrite(bool enabled) {
+    if (changed(m_DepthWrite, enabled)) {
+        GL_CHECK(glDepthMask(enabled ? GL_TRUE : GL_FALSE));
+    }
+}
+
+void GLState::SetDepthFunc(GLenum func) {
+    if (changed(m_DepthFunc, func)) {
+        GL_CHECK(glDepthFunc(func));
+    }
+}
+
+void GLState::SetBlend(bool enabled) {
+    setCapability(GL_BLEND, m_Blend, enabled);
+}
+
+void GLState::SetBlendFunc(GLenum source, GLenum destination) {
+    if (m_BlendSource == source && m_BlendDestination == destination) {
+        m_Stats.skipped++;
+        return;
+    }
+
+    m_BlendSource = source;
+    m_BlendDestination = destination;
+
+    m_Stats.issued++;
+    GL_CHECK(glBlendFunc(source, destination));
+}
+
+void GLState::SetViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    if (m_Viewport[0] == x && m_Viewport[1] == y && m_Viewport[2] == width && m_Viewport[3] == height) {
+        m_Stats.skipped++;
+        return;
+    }
+
+    m_Viewport[0] = x;
+    m_Viewport[1] = y;
+    m_Viewport[2] = width;
+    m_Viewport[3] = height;
+
+    m_Stats.issued++;
+    GL_CHECK(glViewport(x, y, width, height));
+}
+
+void GLState::DeleteProgram(GLuint program) {
+    GL_CHECK(glDeleteProgram(program));
+
+    // A deleted program stays current until another one is used, but its name
+    // may be handed out again, so the cached name can no longer be trusted.
+    if (m_Program == program) {
+        m_Program = UNKNOWN;
+    }
+}
+
+void GLState::DeleteVertexArray(GLuint vertexArray) {
+    GL_CHECK(glDeleteVertexArrays(1, &vertexArray));
+
+    if (m_VertexArray == vertexArray) {
+        m_VertexArray = 0;
+        m_ElementBuffer = UNKNOWN;
+    }
+}
+
+void GLState::DeleteBuffer(GLuint buffer) {
+    GL_CHECK(glDeleteBuffers(1, &buffer));
+
+    if (m_ArrayBuffer == buffer) {
+        m_ArrayBuffer = 0;
+    }
+
+    if (m_ElementBuffer == buffer) {
+        m_ElementBuffer = 0;
+    }
+
+    if (m_UniformBuffer == buffer) {
+        m_UniformBuffer = 0;
+    }
+
+    for (GLuint& binding : m_UniformBindings) {
+        if (binding == buffer) {
+            binding = 0;
+        }
+    }
+}
+
+const GLStateStats& GLState::GetStats() const {
+    return m_Stats;
+}
+
+void GLState::ResetStats() {
+    m_Stats = GLStateStats();
+}
+
+bool GLState::changed(GLuint& cached, GLuint value) {
+    if (cached == value) {
+        m_Stats.skipped++;
+        return false;
+    }
+
+    cached = value;
+    m_Stats.issued++;
+    return true;
+}
+
+bool GLState::changed(Toggle& cached, bool value) {
+    Toggle toggle = value ? TOGGLE_ON : TOGGLE_OFF;
+
+    if (cached == toggle) {
+        m_Stats.skipped++;
+        return false;
+    }
+
+    cached = toggle;
+    m_Stats.issued++;
+    return true;
+}
+
+void GLState::setCapability(GLenum capability, Toggle& cached, bool enabled) {
+    if (!changed(cached, enabled)) {
+        return;
+    }
+
+    if (enabled) {
+        GL_CHECK(glEnable(capability));
+    } else {
+        GL_CHECK(glDisable(capability));
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "utility.hpp"
+
+// Number of indexed uniform buffer binding points whose contents are cached.
+// Bindings past this are always issued.
+constexpr GLuint GL_STATE_UNIFORM_BINDINGS = 16;
+
+struct GLStateStats {
+    size_t issued = 0;
+    size_t skipped = 0;
+};
+
+// Shadow copy of the GL state the renderer changes. Every call compares
+// against the cached value and only reaches the driver when the state really
+// changes. Must only be used from the thread that owns the context, and all
+// changes to the tracked state have to go through it, otherwise Invalidate
+// has to be called before the next use.
+class GLState {
+public:
+    GLState();
+
+    // Forgets every cached value so the next call of each kind is issued.
+    void Invalidate();
+
+    void UseProgram(GLuint program);
+    void BindVertexArray(GLuint vertexArray);
+
+    // GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER and GL_UNIFORM_BUFFER are cached,
+    // other targets are passed through.
+    void BindBuffer(GLenum target, GLuint buffer);
+    void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+    void SetDepthTest(bool enabled);
+    void SetDepthWrite(bool enabled);
+    void SetDepthFunc(GLenum func);
+
+    void SetBlend(bool enabled);
+    void SetBlendFunc(GLenum source, GLenum destination);
+
+    void SetViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    // Deleting a bound object resets its bindings to 0, so deletes of tracked
+    // objects go through here to keep the cache in sync.
+    void DeleteProgram(GLuint program);
+    void DeleteVertexArray(GLuint vertexArray);
+    void DeleteBuffer(GLuint buffer);
+
+    const GLStateStats& GetStats() const;
+    void ResetStats();
+
+private:
+    static constexpr GLuint UNKNOWN = ~0u;
+
+    // -1 while unknown.
+    enum Toggle : int8_t {
+        TOGGLE_UNKNOWN = -1,
+        TOGGLE_OFF = 0,
+        TOGGLE_ON = 1,
+    };
+
+    GLuint m_Program;
+    GLuint m_VertexArray;
+    GLuint m_ArrayBuffer;
+    GLuint m_ElementBuffer;
+    GLuint m_UniformBuffer;
+    GLuint m_UniformBindings[GL_STATE_UNIFORM_BINDINGS];
+
+    Toggle m_DepthTest;
+    Toggle m_DepthWrite;
+    GLenum m_DepthFunc;
+
+    Toggle m_Blend;
+    GLenum m_BlendSource;
+    GLenum m_BlendDestination;
+
+    GLint m_Viewport[4];
+
+    GLStateStats m_Stats;
+
+    bool changed(GLuint& cached, GLuint value);
+    bool changed(Toggle& cached, bool value);
+    void setCapability(GLenum capability, Toggle& cached, bool enabled);
+};
+
+extern GLState glState;
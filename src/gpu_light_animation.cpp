@@ -0,0 +1,136 @@
+#include "gpu_light_animation.hpp"
+#include "gl_state.hpp"
+
+#include <cstddef>
+
+GPULightAnimation::GPULightAnimation(std::shared_ptr<Shader> shader) : m_Shader(shader), m_OrbitVBO(0), m_LightVBO{ 0, 0 }, m_VAO{ 0, 0 }, m_Texture{ 0, 0 }, m_Current(0), m_Count(0) {
+    m_DeltaTimeUniform = m_Shader->GetUniform<float>("uDeltaTime");
+}
+
+GPULightAnimation::~GPULightAnimation() {
+    destroy();
+}
+
+void GPULightAnimation::Add(const Light& light, const glm::vec3& axis, float degreesPerSecond, float phaseDegrees) {
+    LightOrbit orbit = MakeLightOrbit(light.position, axis, degreesPerSecond, phaseDegrees);
+
+    GPULightOrbit gpuOrbit;
+    gpuOrbit.parallel = glm::vec4(orbit.parallel, orbit.turnsPerSecond);
+    gpuOrbit.perpendicular = orbit.perpendicular;
+    gpuOrbit.tangent = orbit.tangent;
+    m_Orbits.push_back(gpuOrbit);
+
+    Light start = light;
+    start.padding0 = orbit.phaseTurns;
+    m_Lights.push_back(start);
+}
+
+void GPULightAnimation::Upload() {
+    destroy();
+
+    m_Count = static_cast<GLsizei>(m_Lights.size());
+    if (m_Count == 0) {
+        return;
+    }
+
+    GL_CHECK(glGenBuffers(1, &m_OrbitVBO));
+    glState.BindBuffer(GL_ARRAY_BUFFER, m_OrbitVBO);
+    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, m_Orbits.size() * sizeof(GPULightOrbit), m_Orbits.data(), GL_STATIC_DRAW));
+
+    GL_CHECK(glGenBuffers(2, m_LightVBO));
+    GL_CHECK(glGenVertexArrays(2, m_VAO));
+    GL_CHECK(glGenTextures(2, m_Texture));
+
+    GLsizei orbitStride = sizeof(GPULightOrbit);
+    GLsizei lightStride = sizeof(Light);
+
+    for (int i = 0; i < 2; i++) {
+        // Both get the start state, so either one can be read first.
+        glState.BindBuffer(GL_ARRAY_BUFFER, m_LightVBO[i]);
+        GL_CHECK(glBufferData(GL_ARRAY_BUFFER, m_Lights.size() * sizeof(Light), m_Lights.data(), GL_DYNAMIC_COPY));
+
+        glState.BindVertexArray(m_VAO[i]);
+
+        glState.BindBuffer(GL_ARRAY_BUFFER, m_OrbitVBO);
+        GL_CHECK(glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, orbitStride, reinterpret_cast<void*>(offsetof(GPULightOrbit, parallel))));
+        GL_CHECK(glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, orbitStride, reinterpret_cast<void*>(offsetof(GPULightOrbit, perpendicular))));
+        GL_CHECK(glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, orbitStride, reinterpret_cast<void*>(offsetof(GPULightOrbit, tangent))));
+
+        glState.BindBuffer(GL_ARRAY_BUFFER, m_LightVBO[i]);
+        GL_CHECK(glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, lightStride, reinterpret_cast<void*>(offsetof(Light, position))));
+        GL_CHECK(glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, lightStride, reinterpret_cast<void*>(offsetof(Light, color))));
+
+        for (GLuint location = 0; location < 5; location++) {
+            GL_CHECK(glEnableVertexAttribArray(location));
+        }
+
+        GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, m_Texture[i]));
+        GL_CHECK(glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_LightVBO[i]));
+    }
+
+    glState.BindVertexArray(0);
+    glState.BindBuffer(GL_ARRAY_BUFFER, 0);
+    GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, 0));
+
+    m_Current = 0;
+}
+
+void GPULightAnimation::Update(float deltaSeconds) {
+    if (m_Count == 0) {
+        return;
+    }
+
+    int next = 1 - m_Current;
+
+    m_Shader->Use();
+    m_Shader->Set(m_DeltaTimeUniform, deltaSeconds);
+
+    glState.BindVertexArray(m_VAO[m_Current]);
+    glState.BindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_LightVBO[next]);
+
+    // One point per light. Nothing is rasterized, the output goes to the feedback buffer only.
+    GL_CHECK(glEnable(GL_RASTERIZER_DISCARD));
+    GL_CHECK(glBeginTransformFeedback(GL_POINTS));
+    GL_CHECK(glDrawArrays(GL_POINTS, 0, m_Count));
+    GL_CHECK(glEndTransformFeedback());
+    GL_CHECK(glDisable(GL_RASTERIZER_DISCARD));
+
+    glState.BindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glState.BindVertexArray(0);
+
+    m_Current = next;
+}
+
+void GPULightAnimation::Bind(GLuint unit) const {
+    GL_CHECK(glActiveTexture(GL_TEXTURE0 + unit));
+    GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, m_Texture[m_Current]));
+}
+
+GLint GPULightAnimation::GetCount() const {
+    return static_cast<GLint>(m_Count);
+}
+
+ShaderSource GPULightAnimation::ReadSource(const char* vertexPath) {
+    ShaderSource source = ReadShaderSource(vertexPath, nullptr);
+
+    // Interleaved, these two vec4s are exactly one Light.
+    source.feedbackVaryings = { "tfPosition", "tfColor" };
+
+    return source;
+}
+
+void GPULightAnimation::destroy() {
+    if (m_OrbitVBO == 0) {
+        return;
+    }
+
+    GL_CHECK(glDeleteTextures(2, m_Texture));
+    glState.DeleteVertexArray(m_VAO[0]);
+    glState.DeleteVertexArray(m_VAO[1]);
+    glState.DeleteBuffer(m_LightVBO[0]);
+    glState.DeleteBuffer(m_LightVBO[1]);
+    glState.DeleteBuffer(m_OrbitVBO);
+
+    m_OrbitVBO = 0;
+    m_Count = 0;
+}
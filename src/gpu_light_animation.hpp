@@ -0,0 +1,72 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+#include "utility.hpp"
+#include "shader.hpp"
+#include "light_buffer.hpp"
+#include "light_animation.hpp"
+
+// A LightOrbit as the vertex attributes of light_animate.vert.
+struct GPULightOrbit {
+    glm::vec4 parallel;        // w: turns per second
+    glm::vec3 perpendicular;
+    glm::vec3 tangent;
+};
+
+// Animates orbiting lights entirely on the GPU. A vertex shader pass with
+// transform feedback reads the lights from one buffer and writes the advanced
+// lights to the other, in the Light layout. Each buffer also backs a texture
+// buffer, so the lit shader and the light markers read the result in place and
+// no light data is uploaded after Upload.
+//
+// The current angle of every light is carried in the w component of its
+// position, which the shaders ignore.
+class GPULightAnimation {
+public:
+    // shader has to be built from ReadSource.
+    explicit GPULightAnimation(std::shared_ptr<Shader> shader);
+    ~GPULightAnimation();
+
+    GPULightAnimation(const GPULightAnimation&) = delete;
+    GPULightAnimation& operator=(const GPULightAnimation&) = delete;
+
+    void Add(const Light& light, const glm::vec3& axis, float degreesPerSecond, float phaseDegrees = 0.0f);
+
+    // Creates the buffers from the added lights. This is the only upload.
+    void Upload();
+
+    // Advances every light by deltaSeconds.
+    void Update(float deltaSeconds);
+
+    // Binds the most recently written lights in place of a LightBuffer.
+    void Bind(GLuint unit = LIGHT_BUFFER_TEXTURE_UNIT) const;
+
+    GLint GetCount() const;
+
+    // Reads light_animate.vert and declares its outputs as feedback varyings.
+    static ShaderSource ReadSource(const char* vertexPath);
+
+private:
+    std::shared_ptr<Shader> m_Shader;
+    Uniform<float> m_DeltaTimeUniform;
+
+    std::vector<GPULightOrbit> m_Orbits;
+    std::vector<Light> m_Lights;
+
+    GLuint m_OrbitVBO;
+
+    // Ping-pong pair. Update reads m_Current and writes the other one.
+    GLuint m_LightVBO[2];
+    GLuint m_VAO[2];
+    GLuint m_Texture[2];
+    int m_Current;
+
+    GLsizei m_Count;
+
+    void destroy();
+};
@@ -0,0 +1,346 @@
+#include "light_animation.hpp"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIGHT_ANIMATION_SSE2
+#include <immintrin.h>
+
+#if defined(__AVX__)
+#define LIGHT_ANIMATION_AVX
+#define LIGHT_ANIMATION_AVX_TARGET
+#elif defined(__GNUC__) || defined(__clang__)
+// Without -mavx the AVX kernel is still compiled for AVX, and only used when the CPU has it.
+#define LIGHT_ANIMATION_AVX
+#define LIGHT_ANIMATION_AVX_TARGET __attribute__((target("avx")))
+#endif
+#endif
+
+constexpr float TWO_PI = 6.28318530717958647692f;
+
+// Minimax coefficients for sin and cos on [-pi/4, pi/4], from Cephes.
+constexpr float SIN_C1 = -1.6666654611e-1f;
+constexpr float SIN_C2 = 8.3321608736e-3f;
+constexpr float SIN_C3 = -1.9515295891e-4f;
+constexpr float COS_C1 = 4.166664568298827e-2f;
+constexpr float COS_C2 = -1.388731625493765e-3f;
+constexpr float COS_C3 = 2.443315711809948e-5f;
+
+struct OrbitStreams {
+    const float* parallelX;
+    const float* parallelY;
+    const float* parallelZ;
+    const float* perpendicularX;
+    const float* perpendicularY;
+    const float* perpendicularZ;
+    const float* tangentX;
+    const float* tangentY;
+    const float* tangentZ;
+    const float* turnsPerSecond;
+    const float* phaseTurns;
+    float* positionX;
+    float* positionY;
+    float* positionZ;
+};
+
+static void evaluateScalar(const OrbitStreams& s, size_t count, double time) {
+    for (size_t i = 0; i < count; i++) {
+        double turns = static_cast<double>(s.turnsPerSecond[i]) * time + static_cast<double>(s.phaseTurns[i]);
+        float angle = static_cast<float>(turns - std::round(turns)) * TWO_PI;
+
+        float c = std::cos(angle);
+        float sn = std::sin(angle);
+
+        s.positionX[i] = s.parallelX[i] + s.perpendicularX[i] * c + s.tangentX[i] * sn;
+        s.positionY[i] = s.parallelY[i] + s.perpendicularY[i] * c + s.tangentY[i] * sn;
+        s.positionZ[i] = s.parallelZ[i] + s.perpendicularZ[i] * c + s.tangentZ[i] * sn;
+    }
+}
+
+#if defined(LIGHT_ANIMATION_SSE2)
+
+// Rate * time + phase in double, minus the nearest whole number of turns.
+static inline __m128 reduceTurnsSSE2(const float* rate, const float* phase, __m128d time) {
+    // Adding and subtracting 1.5 * 2^52 rounds a double to the nearest integer.
+    const __m128d roundMagic = _mm_set1_pd(6755399441055744.0);
+
+    __m128 r = _mm_loadu_ps(rate);
+    __m128 p = _mm_loadu_ps(phase);
+
+    __m128d low = _mm_add_pd(_mm_mul_pd(_mm_cvtps_pd(r), time), _mm_cvtps_pd(p));
+    __m128d high = _mm_add_pd(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(r, r)), time), _mm_cvtps_pd(_mm_movehl_ps(p, p)));
+
+    low = _mm_sub_pd(low, _mm_sub_pd(_mm_add_pd(low, roundMagic), roundMagic));
+    high = _mm_sub_pd(high, _mm_sub_pd(_mm_add_pd(high, roundMagic), roundMagic));
+
+    return _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high));
+}
+
+// Sine and cosine of turns in [-0.5, 0.5]. The nearest quarter turn is split
+// off, the polynomials handle the rest, and the quadrant swaps and negates them.
+static inline void sinCosTurnsSSE2(__m128 turns, __m128& sine, __m128& cosine) {
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    __m128 quadrant = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(turns, _mm_set1_ps(4.0f))));
+    __m128 a = _mm_mul_ps(_mm_sub_ps(turns, _mm_mul_ps(quadrant, _mm_set1_ps(0.25f))), _mm_set1_ps(TWO_PI));
+    __m128 z = _mm_mul_ps(a, a);
+
+    __m128 sinPoly = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIN_C3), z), _mm_set1_ps(SIN_C2));
+    sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(SIN_C1));
+    __m128 sinA = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPoly, z), a), a);
+
+    __m128 cosPoly = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(COS_C3), z), _mm_set1_ps(COS_C2));
+    cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(COS_C1));
+    __m128 cosA = _mm_add_ps(_mm_sub_ps(one, _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_mul_ps(_mm_mul_ps(cosPoly, z), z));
+
+    __m128 swap = _mm_cmpeq_ps(_mm_andnot_ps(signMask, quadrant), one);
+    __m128 negateSin = _mm_or_ps(_mm_cmplt_ps(quadrant, _mm_set1_ps(-0.5f)), _mm_cmpgt_ps(quadrant, _mm_set1_ps(1.5f)));
+    __m128 negateCos = _mm_or_ps(_mm_cmpgt_ps(quadrant, _mm_set1_ps(0.5f)), _mm_cmplt_ps(quadrant, _mm_set1_ps(-1.5f)));
+
+    sine = _mm_or_ps(_mm_and_ps(swap, cosA), _mm_andnot_ps(swap, sinA));
+    cosine = _mm_or_ps(_mm_and_ps(swap, sinA), _mm_andnot_ps(swap, cosA));
+
+    sine = _mm_xor_ps(sine, _mm_and_ps(negateSin, signMask));
+    cosine = _mm_xor_ps(cosine, _mm_and_ps(negateCos, signMask));
+}
+
+static inline __m128 orbitSSE2(const float* parallel, const float* perpendicular, const float* tangent, size_t i, __m128 sine, __m128 cosine) {
+    __m128 result = _mm_add_ps(_mm_loadu_ps(parallel + i), _mm_mul_ps(_mm_loadu_ps(perpendicular + i), cosine));
+    return _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(tangent + i), sine));
+}
+
+static void evaluateSSE2(const OrbitStreams& s, size_t count, double time) {
+    __m128d time2 = _mm_set1_pd(time);
+
+    for (size_t i = 0; i < count; i += 4) {
+        __m128 sine, cosine;
+        sinCosTurnsSSE2(reduceTurnsSSE2(s.turnsPerSecond + i, s.phaseTurns + i, time2), sine, cosine);
+
+        _mm_storeu_ps(s.positionX + i, orbitSSE2(s.parallelX, s.perpendicularX, s.tangentX, i, sine, cosine));
+        _mm_storeu_ps(s.positionY + i, orbitSSE2(s.parallelY, s.perpendicularY, s.tangentY, i, sine, cosine));
+        _mm_storeu_ps(s.positionZ + i, orbitSSE2(s.parallelZ, s.perpendicularZ, s.tangentZ, i, sine, cosine));
+    }
+}
+
+#endif
+
+#if defined(LIGHT_ANIMATION_AVX)
+
+// Same steps as the SSE2 kernel, eight lights at a time.
+LIGHT_ANIMATION_AVX_TARGET static inline __m256 reduceTurnsAVX(const float* rate, const float* phase, __m256d time) {
+    __m256d low = _mm256_add_pd(_mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(rate)), time), _mm256_cvtps_pd(_mm_loadu_ps(phase)));
+    __m256d high = _mm256_add_pd(_mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(rate + 4)), time), _mm256_cvtps_pd(_mm_loadu_ps(phase + 4)));
+
+    low = _mm256_sub_pd(low, _mm256_round_pd(low, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+    high = _mm256_sub_pd(high, _mm256_round_pd(high, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(low)), _mm256_cvtpd_ps(high), 1);
+}
+
+LIGHT_ANIMATION_AVX_TARGET static inline void sinCosTurnsAVX(__m256 turns, __m256& sine, __m256& cosine) {
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    __m256 quadrant = _mm256_round_ps(_mm256_mul_ps(turns, _mm256_set1_ps(4.0f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 a = _mm256_mul_ps(_mm256_sub_ps(turns, _mm256_mul_ps(quadrant, _mm256_set1_ps(0.25f))), _mm256_set1_ps(TWO_PI));
+    __m256 z = _mm256_mul_ps(a, a);
+
+    __m256 sinPoly = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SIN_C3), z), _mm256_set1_ps(SIN_C2));
+    sinPoly = _mm256_add_ps(_mm256_mul_ps(sinPoly, z), _mm256_set1_ps(SIN_C1));
+    __m256 sinA = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(sinPoly, z), a), a);
+
+    __m256 cosPoly = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(COS_C3), z), _mm256_set1_ps(COS_C2));
+    cosPoly = _mm256_add_ps(_mm256_mul_ps(cosPoly, z), _mm256_set1_ps(COS_C1));
+    __m256 cosA = _mm256_add_ps(_mm256_sub_ps(one, _mm256_mul_ps(_mm256_set1_ps(0.5f), z)), _mm256_mul_ps(_mm256_mul_ps(cosPoly, z), z));
+
+    __m256 swap = _mm256_cmp_ps(_mm256_andnot_ps(signMask, quadrant), one, _CMP_EQ_OQ);
+    __m256 negateSin = _mm256_or_ps(_mm256_cmp_ps(quadrant, _mm256_set1_ps(-0.5f), _CMP_LT_OQ), _mm256_cmp_ps(quadrant, _mm256_set1_ps(1.5f), _CMP_GT_OQ));
+    __m256 negateCos = _mm256_or_ps(_mm256_cmp_ps(quadrant, _mm256_set1_ps(0.5f), _CMP_GT_OQ), _mm256_cmp_ps(quadrant, _mm256_set1_ps(-1.5f), _CMP_LT_OQ));
+
+    sine = _mm256_blendv_ps(sinA, cosA, swap);
+    cosine = _mm256_blendv_ps(cosA, sinA, swap);
+
+    sine = _mm256_xor_ps(sine, _mm256_and_ps(negateSin, signMask));
+    cosine = _mm256_xor_ps(cosine, _mm256_and_ps(negateCos, signMask));
+}
+
+LIGHT_ANIMATION_AVX_TARGET static inline __m256 orbitAVX(const float* parallel, const float* perpendicular, const float* tangent, size_t i, __m256 sine, __m256 cosine) {
+    __m256 result = _mm256_add_ps(_mm256_loadu_ps(parallel + i), _mm256_mul_ps(_mm256_loadu_ps(perpendicular + i), cosine));
+    return _mm256_add_ps(result, _mm256_mul_ps(_mm256_loadu_ps(tangent + i), sine));
+}
+
+LIGHT_ANIMATION_AVX_TARGET static void evaluateAVX(const OrbitStreams& s, size_t count, double time) {
+    __m256d time4 = _mm256_set1_pd(time);
+
+    for (size_t i = 0; i < count; i += 8) {
+        __m256 sine, cosine;
+        sinCosTurnsAVX(reduceTurnsAVX(s.turnsPerSecond + i, s.phaseTurns + i, time4), sine, cosine);
+
+        _mm256_storeu_ps(s.positionX + i, orbitAVX(s.parallelX, s.perpendicularX, s.tangentX, i, sine, cosine));
+        _mm256_storeu_ps(s.positionY + i, orbitAVX(s.parallelY, s.perpendicularY, s.tangentY, i, sine, cosine));
+        _mm256_storeu_ps(s.positionZ + i, orbitAVX(s.parallelZ, s.perpendicularZ, s.tangentZ, i, sine, cosine));
+    }
+
+    _mm256_zeroupper();
+}
+
+#endif
+
+LightOrbit MakeLightOrbit(const glm::vec3& position, const glm::vec3& axis, float degreesPerSecond, float phaseDegrees) {
+    glm::vec3 k = glm::normalize(axis);
+
+    LightOrbit orbit;
+    orbit.parallel = k * glm::dot(k, position);
+    orbit.perpendicular = position - orbit.parallel;
+    orbit.tangent = glm::cross(k, position);
+    orbit.turnsPerSecond = degreesPerSecond / 360.0f;
+    orbit.phaseTurns = phaseDegrees / 360.0f;
+
+    return orbit;
+}
+
+LightAnimation::LightAnimation() : m_Count(0), m_Kernel(GetBestKernel()) {}
+
+void LightAnimation::Add(const glm::vec3& position, const glm::vec3& axis, float degreesPerSecond, float phaseDegrees) {
+    if (m_Count == m_TurnsPerSecond.size()) {
+        resizeStreams(m_Count + LIGHT_ANIMATION_BLOCK);
+    }
+
+    LightOrbit orbit = MakeLightOrbit(position, axis, degreesPerSecond, phaseDegrees);
+
+    size_t i = m_Count++;
+
+    m_ParallelX[i] = orbit.parallel.x;
+    m_ParallelY[i] = orbit.parallel.y;
+    m_ParallelZ[i] = orbit.parallel.z;
+    m_PerpendicularX[i] = orbit.perpendicular.x;
+    m_PerpendicularY[i] = orbit.perpendicular.y;
+    m_PerpendicularZ[i] = orbit.perpendicular.z;
+    m_TangentX[i] = orbit.tangent.x;
+    m_TangentY[i] = orbit.tangent.y;
+    m_TangentZ[i] = orbit.tangent.z;
+    m_TurnsPerSecond[i] = orbit.turnsPerSecond;
+    m_PhaseTurns[i] = orbit.phaseTurns;
+
+    m_PositionX[i] = position.x;
+    m_PositionY[i] = position.y;
+    m_PositionZ[i] = position.z;
+}
+
+void LightAnimation::Reserve(size_t count) {
+    if (count > m_TurnsPerSecond.size()) {
+        resizeStreams((count + LIGHT_ANIMATION_BLOCK - 1) / LIGHT_ANIMATION_BLOCK * LIGHT_ANIMATION_BLOCK);
+    }
+}
+
+void LightAnimation::Clear() {
+    m_Count = 0;
+    resizeStreams(0);
+}
+
+void LightAnimation::Evaluate(double time) {
+    OrbitStreams streams = {
+        m_ParallelX.data(), m_ParallelY.data(), m_ParallelZ.data(),
+        m_PerpendicularX.data(), m_PerpendicularY.data(), m_PerpendicularZ.data(),
+        m_TangentX.data(), m_TangentY.data(), m_TangentZ.data(),
+        m_TurnsPerSecond.data(), m_PhaseTurns.data(),
+        m_PositionX.data(), m_PositionY.data(), m_PositionZ.data(),
+    };
+
+    // The SIMD kernels run over whole blocks. Padding lanes are zero and stay zero.
+    size_t blocks = (m_Count + LIGHT_ANIMATION_BLOCK - 1) / LIGHT_ANIMATION_BLOCK * LIGHT_ANIMATION_BLOCK;
+
+    switch (m_Kernel) {
+#if defined(LIGHT_ANIMATION_AVX)
+        case LIGHT_ANIMATION_KERNEL_AVX:
+            evaluateAVX(streams, blocks, time);
+            break;
+#endif
+#if defined(LIGHT_ANIMATION_SSE2)
+        case LIGHT_ANIMATION_KERNEL_SSE2:
+            evaluateSSE2(streams, blocks, time);
+            break;
+#endif
+        default:
+            evaluateScalar(streams, m_Count, time);
+            break;
+    }
+}
+
+void LightAnimation::WritePositions(Light* lights) const {
+    for (size_t i = 0; i < m_Count; i++) {
+        lights[i].position = glm::vec3(m_PositionX[i], m_PositionY[i], m_PositionZ[i]);
+    }
+}
+
+const float* LightAnimation::GetPositionX() const {
+    return m_PositionX.data();
+}
+
+const float* LightAnimation::GetPositionY() const {
+    return m_PositionY.data();
+}
+
+const float* LightAnimation::GetPositionZ() const {
+    return m_PositionZ.data();
+}
+
+size_t LightAnimation::GetCount() const {
+    return m_Count;
+}
+
+void LightAnimation::SetKernel(LightAnimationKernel kernel) {
+    m_Kernel = IsKernelSupported(kernel) ? kernel : LIGHT_ANIMATION_KERNEL_SCALAR;
+}
+
+LightAnimationKernel LightAnimation::GetKernel() const {
+    return m_Kernel;
+}
+
+bool LightAnimation::IsKernelSupported(LightAnimationKernel kernel) {
+    switch (kernel) {
+        case LIGHT_ANIMATION_KERNEL_SCALAR:
+            return true;
+#if defined(LIGHT_ANIMATION_SSE2)
+        case LIGHT_ANIMATION_KERNEL_SSE2:
+            return true;
+#endif
+#if defined(LIGHT_ANIMATION_AVX)
+        case LIGHT_ANIMATION_KERNEL_AVX:
+#if defined(__AVX__)
+            return true;
+#else
+            return __builtin_cpu_supports("avx");
+#endif
+#endif
+        default:
+            return false;
+    }
+}
+
+LightAnimationKernel LightAnimation::GetBestKernel() {
+    if (IsKernelSupported(LIGHT_ANIMATION_KERNEL_AVX)) {
+        return LIGHT_ANIMATION_KERNEL_AVX;
+    }
+
+    if (IsKernelSupported(LIGHT_ANIMATION_KERNEL_SSE2)) {
+        return LIGHT_ANIMATION_KERNEL_SSE2;
+    }
+
+    return LIGHT_ANIMATION_KERNEL_SCALAR;
+}
+
+const char* LightAnimation::GetKernelName(LightAnimationKernel kernel) {
+    switch (kernel) {
+        case LIGHT_ANIMATION_KERNEL_SSE2:   return "SSE2";
+        case LIGHT_ANIMATION_KERNEL_AVX:    return "AVX";
+        default:                            return "scalar";
+    }
+}
+
+void LightAnimation::resizeStreams(size_t size) {
+    for (std::vector<float>* stream : { &m_ParallelX, &m_ParallelY, &m_ParallelZ, &m_PerpendicularX, &m_PerpendicularY, &m_PerpendicularZ, &m_TangentX, &m_TangentY, &m_TangentZ, &m_TurnsPerSecond, &m_PhaseTurns, &m_PositionX, &m_PositionY, &m_PositionZ }) {
+        stream->resize(size, 0.0f);
+    }
+}
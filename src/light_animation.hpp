@@ -0,0 +1,81 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+#include "light_buffer.hpp"
+
+enum LightAnimationKernel {
+    LIGHT_ANIMATION_KERNEL_SCALAR = 0,
+    LIGHT_ANIMATION_KERNEL_SSE2 = 1,
+    LIGHT_ANIMATION_KERNEL_AVX = 2,
+};
+
+// Orbit of a light around an axis through the origin, split into the parts of
+// Rodrigues' rotation formula that do not depend on the angle:
+//
+//     position = parallel + perpendicular * cos(angle) + tangent * sin(angle)
+struct LightOrbit {
+    glm::vec3 parallel;
+    glm::vec3 perpendicular;
+    glm::vec3 tangent;
+    float turnsPerSecond;
+    float phaseTurns;
+};
+
+LightOrbit MakeLightOrbit(const glm::vec3& position, const glm::vec3& axis, float degreesPerSecond, float phaseDegrees = 0.0f);
+
+// Evaluate works on blocks of this many lights. The streams are padded to a
+// multiple of it so the SIMD kernels never need a scalar tail.
+constexpr size_t LIGHT_ANIMATION_BLOCK = 8;
+
+// Lights orbiting an axis through the origin at a constant rate. Positions are
+// computed from the time instead of being advanced step by step, so they do
+// not drift however long the animation runs. The orbits are kept in
+// structure-of-arrays form, one stream per LightOrbit component.
+//
+// The angle is tracked in turns and reduced to [-0.5, 0.5] in double precision
+// before the sine and cosine are evaluated in single precision.
+class LightAnimation {
+public:
+    LightAnimation();
+
+    void Add(const glm::vec3& position, const glm::vec3& axis, float degreesPerSecond, float phaseDegrees = 0.0f);
+    void Reserve(size_t count);
+    void Clear();
+
+    // Computes every position at time seconds.
+    void Evaluate(double time);
+
+    // Copies the last evaluated positions into lights, which must hold at least GetCount() entries.
+    void WritePositions(Light* lights) const;
+
+    const float* GetPositionX() const;
+    const float* GetPositionY() const;
+    const float* GetPositionZ() const;
+    size_t GetCount() const;
+
+    // Defaults to the fastest kernel the CPU supports. Picking an unsupported one falls back to scalar.
+    void SetKernel(LightAnimationKernel kernel);
+    LightAnimationKernel GetKernel() const;
+
+    static bool IsKernelSupported(LightAnimationKernel kernel);
+    static LightAnimationKernel GetBestKernel();
+    static const char* GetKernelName(LightAnimationKernel kernel);
+
+private:
+    size_t m_Count;
+    LightAnimationKernel m_Kernel;
+
+    std::vector<float> m_ParallelX, m_ParallelY, m_ParallelZ;
+    std::vector<float> m_PerpendicularX, m_PerpendicularY, m_PerpendicularZ;
+    std::vector<float> m_TangentX, m_TangentY, m_TangentZ;
+    std::vector<float> m_TurnsPerSecond;
+    std::vector<float> m_PhaseTurns;
+
+    std::vector<float> m_PositionX, m_PositionY, m_PositionZ;
+
+    void resizeStreams(size_t size);
+};
@@ -0,0 +1,69 @@
+#include "light_buffer.hpp"
+
+#include <algorithm>
+
+LightBuffer::LightBuffer() : m_TBO(0), m_Texture(0), m_Capacity(0), m_Count(0) {
+    GL_CHECK(glGenBuffers(1, &m_TBO));
+    GL_CHECK(glGenTextures(1, &m_Texture));
+
+    // A texture buffer needs a data store before it can be attached, so start with room for one light.
+    Light empty;
+    GL_CHECK(glBindBuffer(GL_TEXTURE_BUFFER, m_TBO));
+    GL_CHECK(glBufferData(GL_TEXTURE_BUFFER, sizeof(Light), &empty, GL_DYNAMIC_DRAW));
+    m_Capacity = 1;
+
+    GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, m_Texture));
+    GL_CHECK(glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_TBO));
+
+    GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, 0));
+    GL_CHECK(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+}
+
+LightBuffer::~LightBuffer() {
+    GL_CHECK(glDeleteTextures(1, &m_Texture));
+    GL_CHECK(glDeleteBuffers(1, &m_TBO));
+}
+
+void LightBuffer::Upload(const std::vector<Light>& lights) {
+    Upload(lights.data(), lights.size());
+}
+
+void LightBuffer::Upload(const Light* lights, size_t count) {
+    GL_CHECK(glBindBuffer(GL_TEXTURE_BUFFER, m_TBO));
+
+    if (count > m_Capacity) {
+        // Grow geometrically so a slowly increasing light count does not reallocate every frame.
+        while (m_Capacity < count) {
+            m_Capacity *= 2;
+        }
+
+        GLint maxTexels = 0;
+        GL_CHECK(glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels));
+        size_t maxLights = static_cast<size_t>(maxTexels) / 2;
+        if (count > maxLights) {
+            std::cerr << "Error: " << count << " lights exceed the texture buffer limit of " << maxLights << " lights!\n";
+            count = maxLights;
+        }
+
+        m_Capacity = std::min(m_Capacity, maxLights);
+    }
+
+    // Orphan the old store before writing so the upload never waits on the previous frame.
+    GL_CHECK(glBufferData(GL_TEXTURE_BUFFER, m_Capacity * sizeof(Light), nullptr, GL_DYNAMIC_DRAW));
+    if (count > 0) {
+        GL_CHECK(glBufferSubData(GL_TEXTURE_BUFFER, 0, count * sizeof(Light), lights));
+    }
+
+    GL_CHECK(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+
+    m_Count = count;
+}
+
+void LightBuffer::Bind(GLuint unit) const {
+    GL_CHECK(glActiveTexture(GL_TEXTURE0 + unit));
+    GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, m_Texture));
+}
+
+GLint LightBuffer::GetCount() const {
+    return static_cast<GLint>(m_Count);
+}
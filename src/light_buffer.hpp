@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "utility.hpp"
+
+// Texture unit the light buffer is bound to while shading.
+constexpr GLuint LIGHT_BUFFER_TEXTURE_UNIT = 0;
+
+// Distance at which a light has faded out completely, unless set otherwise.
+constexpr float LIGHT_DEFAULT_RADIUS = 8.0f;
+
+// A single light as it is stored in the light buffer. Every light occupies two
+// RGBA32F texels, the position in the first and the color and radius in the
+// second, so the struct is padded to match and a whole array can be uploaded as is.
+struct Light {
+    glm::vec3 position;
+    float padding0;
+    glm::vec3 color;
+    float radius;
+
+    Light() : position(0.0f), padding0(0.0f), color(1.0f), radius(LIGHT_DEFAULT_RADIUS) {}
+    Light(const glm::vec3& position, const glm::vec3& color, float radius = LIGHT_DEFAULT_RADIUS) : position(position), padding0(0.0f), color(color), radius(radius) {}
+};
+
+static_assert(sizeof(Light) == 2 * sizeof(glm::vec4), "Light must be two RGBA32F texels");
+
+// Holds an arbitrary number of lights in a texture buffer that shaders read
+// with texelFetch on a samplerBuffer.
+class LightBuffer {
+public:
+    LightBuffer();
+    ~LightBuffer();
+
+    LightBuffer(const LightBuffer&) = delete;
+    LightBuffer& operator=(const LightBuffer&) = delete;
+
+    void Upload(const std::vector<Light>& lights);
+    void Upload(const Light* lights, size_t count);
+
+    void Bind(GLuint unit = LIGHT_BUFFER_TEXTURE_UNIT) const;
+
+    GLint GetCount() const;
+
+private:
+    GLuint m_TBO;
+    GLuint m_Texture;
+    size_t m_Capacity;
+    size_t m_Count;
+};
@@ -0,0 +1,236 @@
+#include "light_clusters.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+LightClusters::LightClusters()
+    : m_SliceRects(LIGHT_CLUSTER_GRID_Z), m_SliceIndices(LIGHT_CLUSTER_GRID_Z), m_Clusters(2 * LIGHT_CLUSTER_COUNT, 0), m_Near(0.1f), m_Far(100.0f), m_ProjectionX(1.0f), m_ProjectionY(1.0f),
+      m_ClusterTBO(0), m_ClusterTexture(0), m_IndexTBO(0), m_IndexTexture(0), m_IndexCapacity(1) {
+    GL_CHECK(glGenBuffers(1, &m_ClusterTBO));
+    GL_CHECK(glGenBuffers(1, &m_IndexTBO));
+    GL_CHECK(glGenTextures(1, &m_ClusterTexture));
+    GL_CHECK(glGenTextures(1, &m_IndexTexture));
+
+    // The cluster table never changes size. The index list starts with room
+    // for one entry, a texture buffer needs a data store before it can be attached.
+    uint32_t empty = 0;
+
+    GL_CHECK(glBindBuffer(GL_TEXTURE_BUFFER, m_ClusterTBO));
+    GL_CHECK(glBufferData(GL_TEXTURE_BUFFER, m_Clusters.size() * sizeof(uint32_t), m_Clusters.data(), GL_DYNAMIC_DRAW));
+    GL_CHECK(glBindBuffer(GL_TEXTURE_BUFFER, m_IndexTBO));
+    GL_CHECK(glBufferData(GL_TEXTURE_BUFFER, sizeof(uint32_t), &empty, GL_DYNAMIC_DRAW));
+    GL_CHECK(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+
+    GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, m_ClusterTexture));
+    GL_CHECK(glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, m_ClusterTBO));
+    GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, m_IndexTexture));
+    GL_CHECK(glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, m_IndexTBO));
+    GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, 0));
+}
+
+LightClusters::~LightClusters() {
+    GL_CHECK(glDeleteTextures(1, &m_IndexTexture));
+    GL_CHECK(glDeleteTextures(1, &m_ClusterTexture));
+    GL_CHECK(glDeleteBuffers(1, &m_IndexTBO));
+    GL_CHECK(glDeleteBuffers(1, &m_ClusterTBO));
+}
+
+void LightClusters::Build(const Light* lights, size_t count, const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane, ThreadPool* pool) {
+    m_Near = nearPlane;
+    m_Far = farPlane;
+    m_ProjectionX = projection[0][0];
+    m_ProjectionY = projection[1][1];
+
+    m_ViewLights.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        m_ViewLights[i].position = glm::vec3(view * glm::vec4(lights[i].position, 1.0f));
+        m_ViewLights[i].radius = lights[i].radius;
+    }
+
+    // Every slice writes only its own clusters, so slices need no synchronisation.
+    if (pool && count > 0) {
+        for (int slice = 0; slice < LIGHT_CLUSTER_GRID_Z; slice++) {
+            pool->Submit([this, slice]() { buildSlice(slice); });
+        }
+
+        pool->Wait();
+    } else {
+        for (int slice = 0; slice < LIGHT_CLUSTER_GRID_Z; slice++) {
+            buildSlice(slice);
+        }
+    }
+
+    // The slices hold offsets relative to their own lists, which go back to back here.
+    const int sliceClusters = LIGHT_CLUSTER_GRID_X * LIGHT_CLUSTER_GRID_Y;
+    size_t total = 0;
+
+    m_Stats = LightClusterStats();
+    m_Stats.lights = count;
+
+    for (int slice = 0; slice < LIGHT_CLUSTER_GRID_Z; slice++) {
+        uint32_t* clusters = m_Clusters.data() + 2 * slice * sliceClusters;
+        for (int i = 0; i < sliceClusters; i++) {
+            clusters[2 * i] += static_cast<uint32_t>(total);
+            m_Stats.maxClusterLights = std::max<size_t>(m_Stats.maxClusterLights, clusters[2 * i + 1]);
+        }
+
+        total += m_SliceIndices[slice].size();
+    }
+
+    m_Indices.resize(total);
+
+    size_t offset = 0;
+    for (int slice = 0; slice < LIGHT_CLUSTER_GRID_Z; slice++) {
+        const std::vector<uint32_t>& indices = m_SliceIndices[slice];
+        if (!indices.empty()) {
+            std::memcpy(m_Indices.data() + offset, indices.data(), indices.size() * sizeof(uint32_t));
+        }
+        offset += indices.size();
+    }
+
+    m_Stats.references = total;
+}
+
+void LightClusters::Upload() {
+    size_t count = m_Indices.size();
+
+    if (count > m_IndexCapacity) {
+        while (m_IndexCapacity < count) {
+            m_IndexCapacity *= 2;
+        }
+
+        GLint maxTexels = 0;
+        GL_CHECK(glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels));
+        size_t maxIndices = static_cast<size_t>(maxTexels);
+        if (count > maxIndices) {
+            std::cerr << "Error: " << count << " clustered light indices exceed the texture buffer limit of " << maxIndices << "!\n";
+            count = maxIndices;
+
+            // The lists past the limit are not uploaded, so the clusters must not point at them.
+            for (size_t cluster = 0; cluster < LIGHT_CLUSTER_COUNT; cluster++) {
+                uint32_t offset = std::min(m_Clusters[2 * cluster], static_cast<uint32_t>(count));
+                m_Clusters[2 * cluster] = offset;
+                m_Clusters[2 * cluster + 1] = std::min(m_Clusters[2 * cluster + 1], static_cast<uint32_t>(count) - offset);
+            }
+        }
+
+        m_IndexCapacity = std::min(m_IndexCapacity, maxIndices);
+    }
+
+    GL_CHECK(glBindBuffer(GL_TEXTURE_BUFFER, m_ClusterTBO));
+    GL_CHECK(glBufferData(GL_TEXTURE_BUFFER, m_Clusters.size() * sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW));
+    GL_CHECK(glBufferSubData(GL_TEXTURE_BUFFER, 0, m_Clusters.size() * sizeof(uint32_t), m_Clusters.data()));
+
+    // Orphaned like the light buffer, so the upload never waits on the previous frame.
+    GL_CHECK(glBindBuffer(GL_TEXTURE_BUFFER, m_IndexTBO));
+    GL_CHECK(glBufferData(GL_TEXTURE_BUFFER, m_IndexCapacity * sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW));
+    if (count > 0) {
+        GL_CHECK(glBufferSubData(GL_TEXTURE_BUFFER, 0, count * sizeof(uint32_t), m_Indices.data()));
+    }
+
+    GL_CHECK(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+}
+
+void LightClusters::Bind() const {
+    GL_CHECK(glActiveTexture(GL_TEXTURE0 + LIGHT_CLUSTER_TEXTURE_UNIT));
+    GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, m_ClusterTexture));
+    GL_CHECK(glActiveTexture(GL_TEXTURE0 + LIGHT_INDEX_TEXTURE_UNIT));
+    GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, m_IndexTexture));
+}
+
+glm::vec4 LightClusters::GetShaderParams(float viewportWidth, float viewportHeight) const {
+    float sliceScale = static_cast<float>(LIGHT_CLUSTER_GRID_Z) / std::log(m_Far / m_Near);
+    float sliceBias = -std::log(m_Near) * sliceScale;
+
+    return glm::vec4(static_cast<float>(LIGHT_CLUSTER_GRID_X) / viewportWidth, static_cast<float>(LIGHT_CLUSTER_GRID_Y) / viewportHeight, sliceScale, sliceBias);
+}
+
+const uint32_t* LightClusters::GetClusterLights(int cluster) const {
+    return m_Indices.data() + m_Clusters[2 * cluster];
+}
+
+uint32_t LightClusters::GetClusterLightCount(int cluster) const {
+    return m_Clusters[2 * cluster + 1];
+}
+
+const LightClusterStats& LightClusters::GetStats() const {
+    return m_Stats;
+}
+
+void LightClusters::buildSlice(int slice) {
+    const float depthRatio = m_Far / m_Near;
+    const float sliceNear = m_Near * std::pow(depthRatio, static_cast<float>(slice) / LIGHT_CLUSTER_GRID_Z);
+    const float sliceFar = m_Near * std::pow(depthRatio, static_cast<float>(slice + 1) / LIGHT_CLUSTER_GRID_Z);
+
+    std::vector<TileRect>& rects = m_SliceRects[slice];
+    rects.clear();
+
+    for (size_t i = 0; i < m_ViewLights.size(); i++) {
+        const ViewLight& light = m_ViewLights[i];
+        float depth = -light.position.z;
+
+        float minDepth = std::max(depth - light.radius, sliceNear);
+        float maxDepth = std::min(depth + light.radius, sliceFar);
+        if (light.radius <= 0.0f || minDepth > maxDepth) {
+            continue;
+        }
+
+        // Projects the box around the sphere, cut to the depth range of the
+        // slice. For a fixed x, x / depth is monotonic in depth, so the
+        // extremes are at the corners.
+        float x0 = light.position.x - light.radius, x1 = light.position.x + light.radius;
+        float y0 = light.position.y - light.radius, y1 = light.position.y + light.radius;
+
+        float minNdcX = m_ProjectionX * std::min(std::min(x0 / minDepth, x0 / maxDepth), std::min(x1 / minDepth, x1 / maxDepth));
+        float maxNdcX = m_ProjectionX * std::max(std::max(x0 / minDepth, x0 / maxDepth), std::max(x1 / minDepth, x1 / maxDepth));
+        float minNdcY = m_ProjectionY * std::min(std::min(y0 / minDepth, y0 / maxDepth), std::min(y1 / minDepth, y1 / maxDepth));
+        float maxNdcY = m_ProjectionY * std::max(std::max(y0 / minDepth, y0 / maxDepth), std::max(y1 / minDepth, y1 / maxDepth));
+
+        if (maxNdcX < -1.0f || minNdcX > 1.0f || maxNdcY < -1.0f || minNdcY > 1.0f) {
+            continue;
+        }
+
+        TileRect rect;
+        rect.light = static_cast<uint32_t>(i);
+        rect.minX = std::max(static_cast<int>(std::floor((minNdcX * 0.5f + 0.5f) * LIGHT_CLUSTER_GRID_X)), 0);
+        rect.maxX = std::min(static_cast<int>(std::floor((maxNdcX * 0.5f + 0.5f) * LIGHT_CLUSTER_GRID_X)), LIGHT_CLUSTER_GRID_X - 1);
+        rect.minY = std::max(static_cast<int>(std::floor((minNdcY * 0.5f + 0.5f) * LIGHT_CLUSTER_GRID_Y)), 0);
+        rect.maxY = std::min(static_cast<int>(std::floor((maxNdcY * 0.5f + 0.5f) * LIGHT_CLUSTER_GRID_Y)), LIGHT_CLUSTER_GRID_Y - 1);
+        rects.push_back(rect);
+    }
+
+    // Count, then prefix sum and fill, so the lists of the slice go into one array.
+    uint32_t* clusters = m_Clusters.data() + 2 * slice * LIGHT_CLUSTER_GRID_X * LIGHT_CLUSTER_GRID_Y;
+    std::fill(clusters, clusters + 2 * LIGHT_CLUSTER_GRID_X * LIGHT_CLUSTER_GRID_Y, 0u);
+
+    for (const TileRect& rect : rects) {
+        for (int y = rect.minY; y <= rect.maxY; y++) {
+            for (int x = rect.minX; x <= rect.maxX; x++) {
+                clusters[2 * (y * LIGHT_CLUSTER_GRID_X + x) + 1]++;
+            }
+        }
+    }
+
+    uint32_t offset = 0;
+    for (int i = 0; i < LIGHT_CLUSTER_GRID_X * LIGHT_CLUSTER_GRID_Y; i++) {
+        clusters[2 * i] = offset;
+        offset += clusters[2 * i + 1];
+    }
+
+    std::vector<uint32_t>& indices = m_SliceIndices[slice];
+    indices.resize(offset);
+
+    // The offsets double as write cursors and are rewound afterwards.
+    for (const TileRect& rect : rects) {
+        for (int y = rect.minY; y <= rect.maxY; y++) {
+            for (int x = rect.minX; x <= rect.maxX; x++) {
+                indices[clusters[2 * (y * LIGHT_CLUSTER_GRID_X + x)]++] = rect.light;
+            }
+        }
+    }
+
+    for (int i = 0; i < LIGHT_CLUSTER_GRID_X * LIGHT_CLUSTER_GRID_Y; i++) {
+        clusters[2 * i] -= clusters[2 * i + 1];
+    }
+}
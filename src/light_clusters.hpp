@@ -0,0 +1,101 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "utility.hpp"
+#include "light_buffer.hpp"
+#include "thread_pool.hpp"
+
+// The view frustum is split into this many clusters: tiles in screen space
+// and exponentially growing slices in depth. Has to match cube.frag.
+constexpr int LIGHT_CLUSTER_GRID_X = 16;
+constexpr int LIGHT_CLUSTER_GRID_Y = 9;
+constexpr int LIGHT_CLUSTER_GRID_Z = 24;
+constexpr int LIGHT_CLUSTER_COUNT = LIGHT_CLUSTER_GRID_X * LIGHT_CLUSTER_GRID_Y * LIGHT_CLUSTER_GRID_Z;
+
+// Texture units of the cluster table and the light index list, next to the G-buffer units.
+constexpr GLuint LIGHT_CLUSTER_TEXTURE_UNIT = 5;
+constexpr GLuint LIGHT_INDEX_TEXTURE_UNIT = 6;
+
+struct LightClusterStats {
+    size_t lights = 0;
+    size_t references = 0;      // sum of the lights of every cluster
+    size_t maxClusterLights = 0;
+};
+
+// Clustered light culling for the forward path. Build assigns every light to
+// the clusters its sphere overlaps, then the lists of all clusters are packed
+// back to back into one index list. Upload puts the table of (offset, count)
+// pairs and the index list in two texture buffers, so a fragment only loops
+// over the lights of its own cluster instead of all of them.
+//
+// Clusters are numbered x first, then y, then the depth slice. Depth slices
+// are spaced exponentially between the near and far plane so clusters stay
+// roughly cubic along the view.
+class LightClusters {
+public:
+    LightClusters();
+    ~LightClusters();
+
+    LightClusters(const LightClusters&) = delete;
+    LightClusters& operator=(const LightClusters&) = delete;
+
+    // projection has to be a symmetric perspective projection such as the
+    // ones from glm::perspective. Does not touch GL, one depth slice per job
+    // when a pool is given.
+    void Build(const Light* lights, size_t count, const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane, ThreadPool* pool = nullptr);
+
+    // Uploads the result of the last Build. Lists past the texture buffer
+    // limit are cut off, and the cluster table is clamped to what was uploaded.
+    void Upload();
+
+    void Bind() const;
+
+    // What cube.frag needs to find the cluster of a fragment: the tiles per
+    // pixel in xy, and the scale and bias that turn the log of the view depth
+    // into a slice in zw.
+    glm::vec4 GetShaderParams(float viewportWidth, float viewportHeight) const;
+
+    // Lights of cluster, as indices into the array passed to Build.
+    const uint32_t* GetClusterLights(int cluster) const;
+    uint32_t GetClusterLightCount(int cluster) const;
+
+    const LightClusterStats& GetStats() const;
+
+private:
+    struct ViewLight {
+        glm::vec3 position;     // view space, the camera looks down -z
+        float radius;
+    };
+
+    struct TileRect {
+        uint32_t light;
+        int minX, minY, maxX, maxY;
+    };
+
+    std::vector<ViewLight> m_ViewLights;
+
+    // Per depth slice: the overlapped tiles and the light lists of its clusters.
+    std::vector<std::vector<TileRect>> m_SliceRects;
+    std::vector<std::vector<uint32_t>> m_SliceIndices;
+
+    // Two entries per cluster, the offset of its list in m_Indices and its length.
+    std::vector<uint32_t> m_Clusters;
+    std::vector<uint32_t> m_Indices;
+
+    float m_Near, m_Far;
+    float m_ProjectionX, m_ProjectionY;
+
+    GLuint m_ClusterTBO, m_ClusterTexture;
+    GLuint m_IndexTBO, m_IndexTexture;
+    size_t m_IndexCapacity;
+
+    LightClusterStats m_Stats;
+
+    void buildSlice(int slice);
+};
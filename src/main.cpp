@@ -5,14 +5,27 @@
 #include <iostream>
 #include <array>
 #include <vector>
+#include <string>
 
 #include "camera.hpp"
 #include "model.hpp"
-
-typedef struct {
-    glm::vec3 position;
-    glm::vec3 color;
-} Light;
+#include "uniform_buffer.hpp"
+#include "light_buffer.hpp"
+#include "asset_loader.hpp"
+#include "gl_extensions.hpp"
+#include "gl_state.hpp"
+#include "gl_debug.hpp"
+#include "profiler.hpp"
+#include "shader_cache.hpp"
+#include "shader_library.hpp"
+#include "render_queue.hpp"
+#include "simulation.hpp"
+#include "transform_system.hpp"
+#include "culling.hpp"
+#include "gpu_light_animation.hpp"
+#include "deferred_renderer.hpp"
+#include "light_clusters.hpp"
+#include "thread_pool.hpp"
 
 void glfw_error(const char* msg);
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -20,6 +33,7 @@ GLFWwindow* create_window();
 void process_input(GLFWwindow* window);
 void mouse_callback(GLFWwindow* window, double xposIn, double yposIn);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
 float windowWidth = 800.0f;
 float windowHeight = 600.0f;
@@ -28,87 +42,356 @@ Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 
 float deltaTime = 0.0f;
 
-int main() {
+// P toggles printing the profiler statistics, T starts and stops a trace capture.
+bool printProfilerStats = false;
+bool toggleProfilerCapture = false;
+
+// R switches between forward and deferred shading.
+bool deferredShading = false;
+
+constexpr float PROFILER_STATS_INTERVAL = 1.0f;
+constexpr const char* PROFILER_TRACE_PATH = "./profile.json";
+
+// Time per frame the GL thread may spend compiling and uploading loaded assets.
+constexpr double ASSET_UPLOAD_BUDGET = 0.002;
+
+constexpr float NEAR_PLANE = 0.1f;
+constexpr float FAR_PLANE = 100.0f;
+
+// The scene has a fixed number of lights, so the cube shader is built with a constant light loop.
+// Cube shaders read their transforms from the render queue's draw data, so
+// pooled meshes can be drawn together with a single multi-draw.
+constexpr int LIGHT_COUNT = 6;
+using CubeShader = ShaderPermutation<SHADER_FEATURE_MULTI_DRAW, LIGHT_COUNT>;
+
+// With --clustered the cube only evaluates the lights of its fragment's cluster.
+using CubeClusteredShader = ShaderPermutation<SHADER_FEATURE_CLUSTERED_LIGHTS | SHADER_FEATURE_MULTI_DRAW>;
+
+// The deferred path draws the cube into the G-buffer and lights it afterwards.
+using CubeGBufferShader = ShaderPermutation<SHADER_FEATURE_GBUFFER | SHADER_FEATURE_MULTI_DRAW>;
+
+// With --gpu-lights the light markers read their positions from the light buffer.
+using LightMarkerShader = ShaderPermutation<SHADER_FEATURE_LIGHT_BUFFER_INSTANCES>;
+
+int main(int argc, char** argv) {
+    // --gpu-lights animates the lights with a transform feedback pass instead
+    // of on the simulation thread, so light data never has to be uploaded.
+    bool gpuLights = false;
+
+    // --clustered assigns the lights to a grid of view space clusters on the
+    // CPU, so the forward path only shades each fragment with nearby lights.
+    bool clusteredLights = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--gpu-lights") {
+            gpuLights = true;
+        } else if (std::string(argv[i]) == "--deferred") {
+            deferredShading = true;
+        } else if (std::string(argv[i]) == "--clustered") {
+            clusteredLights = true;
+        } else {
+            std::cerr << "Usage: HelloLights [--gpu-lights] [--deferred] [--clustered]\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    // The clusters are built from the light positions on the CPU, which the GPU animation never reads back.
+    if (gpuLights && clusteredLights) {
+        std::cerr << "Error: --clustered does not work with --gpu-lights!\n";
+        return EXIT_FAILURE;
+    }
+
+    // Every model shares the vertex and index buffers of the pool. The three
+    // models below are the same mesh, so it is only uploaded once.
+    GeometryPool geometry;
+
+    // Queue the asset loads before the window exists so that disk I/O and mesh
+    // preparation overlap context creation.
+    AssetLoader loader;
+    loader.SetGeometryPool(&geometry);
+
+    std::unique_ptr<Model> cube;
+    std::unique_ptr<Model> cubeGBuffer;
+    std::unique_ptr<Model> light;
+
+    std::shared_ptr<Shader> cubeShader;
+    Uniform<int> lightCountUniform;
+    Uniform<glm::vec4> clusterParamsUniform;
+
+    TransformSystem transforms;
+    TransformHandle cubeTransform = transforms.Create();
+
+    // Only the cube is culled, the light markers are a single instanced draw.
+    CullingSystem culling;
+    std::vector<uint32_t> visibleObjects;
+
+    loader.LoadModel("./assets/meshes/cube.mesh", "./assets/shaders/cube.vert", "./assets/shaders/cube.frag", [&](std::unique_ptr<Model> model) {
+        cube = std::move(model);
+        culling.Add(cubeTransform, cube->GetBounds());
+
+        cubeShader = cube->GetShader();
+
+        // The light buffer always lives on the same texture unit, so the sampler only has to be set once.
+        cubeShader->Use();
+        cubeShader->Set(cubeShader->GetUniform<int>("uLights"), static_cast<int>(LIGHT_BUFFER_TEXTURE_UNIT));
+
+        if (cubeShader->GetDefines().Has("CLUSTERED_LIGHTS")) {
+            clusterParamsUniform = cubeShader->GetUniform<glm::vec4>("uClusterParams");
+            cubeShader->Set(cubeShader->GetUniform<int>("uLightClusters"), static_cast<int>(LIGHT_CLUSTER_TEXTURE_UNIT));
+            cubeShader->Set(cubeShader->GetUniform<int>("uLightIndices"), static_cast<int>(LIGHT_INDEX_TEXTURE_UNIT));
+        } else if (!cubeShader->GetDefines().Has("LIGHT_COUNT")) {
+            lightCountUniform = cubeShader->GetUniform<int>("uLightCount");
+        }
+    }, clusteredLights ? CubeClusteredShader::Defines() : CubeShader::Defines());
+
+    // Same mesh, loaded again with the G-buffer variant of the shader.
+    loader.LoadModel("./assets/meshes/cube.mesh", "./assets/shaders/cube.vert", "./assets/shaders/cube.frag", [&](std::unique_ptr<Model> model) {
+        cubeGBuffer = std::move(model);
+    }, CubeGBufferShader::Defines());
+
+    loader.LoadModel("./assets/meshes/cube.mesh", "./assets/shaders/light.vert", "./assets/shaders/light.frag", [&](std::unique_ptr<Model> model) {
+        light = std::move(model);
+        light->SetScale(glm::vec3(0.2f));
+
+        if (gpuLights) {
+            std::shared_ptr<Shader> lightShader = light->GetShader();
+            lightShader->Use();
+            lightShader->Set(lightShader->GetUniform<int>("uLights"), static_cast<int>(LIGHT_BUFFER_TEXTURE_UNIT));
+
+            light->SetInstanceCount(LIGHT_COUNT);
+        }
+    }, gpuLights ? LightMarkerShader::Defines() : ShaderDefines());
+
     GLFWwindow* window = create_window();
     if (!window) {
         glfwTerminate();
         exit(EXIT_FAILURE);
     }
 
-    std::vector<float> vertices { -0.5f, -0.5f, -0.5f, 0.5f, -0.5f, -0.5f, 0.5f,  0.5f, -0.5f, 0.5f,  0.5f, -0.5f, -0.5f,  0.5f, -0.5f,  -0.5f, -0.5f, -0.5f,  -0.5f, -0.5f,  0.5f, 0.5f, -0.5f,  0.5f, 0.5f,  0.5f,  0.5f, 0.5f,  0.5f,  0.5f, -0.5f,  0.5f,  0.5f, -0.5f, -0.5f,  0.5f, -0.5f,  0.5f,  0.5f, -0.5f,  0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f,  0.5f, -0.5f,  0.5f,  0.5f, 0.5f,  0.5f,  0.5f, 0.5f,  0.5f, -0.5f, 0.5f, -0.5f, -0.5f, 0.5f, -0.5f, -0.5f, 0.5f, -0.5f,  0.5f, 0.5f,  0.5f,  0.5f, -0.5f, -0.5f, -0.5f, 0.5f, -0.5f, -0.5f, 0.5f, -0.5f,  0.5f, 0.5f, -0.5f,  0.5f, -0.5f, -0.5f,  0.5f, -0.5f, -0.5f, -0.5f, -0.5f,  0.5f, -0.5f, 0.5f,  0.5f, -0.5f, 0.5f,  0.5f,  0.5f, 0.5f,  0.5f,  0.5f, -0.5f,  0.5f,  0.5f, -0.5f,  0.5f, -0.5f };
-    std::vector<float> normals { 0.0f,  0.0f, -1.0f, 0.0f,  0.0f, -1.0f, 0.0f,  0.0f, -1.0f, 0.0f,  0.0f, -1.0f, 0.0f,  0.0f, -1.0f, 0.0f,  0.0f, -1.0f, 0.0f,  0.0f, 1.0f, 0.0f,  0.0f, 1.0f, 0.0f,  0.0f, 1.0f, 0.0f,  0.0f, 1.0f, 0.0f,  0.0f, 1.0f, 0.0f,  0.0f, 1.0f, -1.0f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,  0.0f,  0.0f, 1.0f,  0.0f,  0.0f, 1.0f,  0.0f,  0.0f, 1.0f,  0.0f,  0.0f, 1.0f,  0.0f,  0.0f, 1.0f,  0.0f,  0.0f, 0.0f, -1.0f,  0.0f, 0.0f, -1.0f,  0.0f, 0.0f, -1.0f,  0.0f, 0.0f, -1.0f,  0.0f, 0.0f, -1.0f,  0.0f, 0.0f, -1.0f,  0.0f, 0.0f,  1.0f,  0.0f, 0.0f,  1.0f,  0.0f, 0.0f,  1.0f,  0.0f, 0.0f,  1.0f,  0.0f, 0.0f,  1.0f,  0.0f, 0.0f,  1.0f,  0.0f };
-    std::array<Light, 6> lights {{
-        { glm::vec3(3.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f) },
-        { glm::vec3(-3.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
-        { glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, 1.0f) },
-        { glm::vec3(0.0f, 0.0f, -3.0f), glm::vec3(0.96f, 1.0f, 0.0f) },
-        { glm::vec3(0.0f, 3.0f, 0.0f), glm::vec3(1.0f, 0.58f, 0.0f) },
-        { glm::vec3(0.0f, -3.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.9f) },
-    }};
-
-    Model cube(vertices, normals, {}, {}, "./assets/shaders/cube.vert", "./assets/shaders/cube.frag");
-    Model light(vertices, {}, {}, {}, "./assets/shaders/light.vert", "./assets/shaders/light.frag");
-    light.SetScale(glm::vec3(0.2f));
+    Shader::SetProgramCache(std::make_shared<ShaderCache>("./cache/shaders"));
+
+    DeferredRenderer deferredRenderer(std::make_shared<Shader>("./assets/shaders/deferred_light.vert", "./assets/shaders/deferred_light.frag"),
+                                      std::make_shared<Shader>("./assets/shaders/deferred_composite.vert", "./assets/shaders/deferred_composite.frag"));
+
+    std::vector<Light> lights {
+        Light(glm::vec3(3.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
+        Light(glm::vec3(-3.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
+        Light(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
+        Light(glm::vec3(0.0f, 0.0f, -3.0f), glm::vec3(0.96f, 1.0f, 0.0f)),
+        Light(glm::vec3(0.0f, 3.0f, 0.0f), glm::vec3(1.0f, 0.58f, 0.0f)),
+        Light(glm::vec3(0.0f, -3.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.9f)),
+    };
+
+    std::vector<ModelInstance> lightInstances(lights.size());
+
+    std::vector<TransformHandle> lightTransforms;
+    for (const Light& sceneLight : lights) {
+        lightTransforms.push_back(transforms.Create(sceneLight.position));
+    }
+
+    LightBuffer lightBuffer;
+    LightClusters lightClusters;
+    ThreadPool workers;
+
+    UniformBuffer frameBuffer(FRAME_BLOCK_BINDING, sizeof(FrameUniforms));
+    FrameUniforms frameUniforms;
+
+    RenderQueue renderQueue;
+
+    Profiler profiler;
+    profiler.InitGPU();
 
     float lastFrame = 0.0f;
-    float rotationSpeed = 30.0f;
+    float lastStatsTime = 0.0f;
+
+    // Lights animate on their own thread, input and the camera stay on this one.
+    Simulation simulation(lights);
+
+    std::unique_ptr<GPULightAnimation> gpuLightAnimation;
+
+    if (gpuLights) {
+        gpuLightAnimation = std::make_unique<GPULightAnimation>(std::make_shared<Shader>(GPULightAnimation::ReadSource("./assets/shaders/light_animate.vert")));
+
+        for (const Light& sceneLight : lights) {
+            gpuLightAnimation->Add(sceneLight, LIGHT_ROTATION_AXIS, LIGHT_ROTATION_SPEED);
+        }
+
+        gpuLightAnimation->Upload();
+    } else {
+        simulation.Start();
+    }
 
     while (!glfwWindowShouldClose(window)) {
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        profiler.BeginFrame();
+
         process_input(window);
 
-        glm::mat4 view = camera.GetViewMatrix();
-        glm::mat4 projection = glm::perspective(glm::radians(camera.GetZoom()), (float)windowWidth / (float)windowHeight, 0.1f, 100.0f);
-        glm::mat4 lightRotationMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(rotationSpeed * deltaTime), glm::vec3(1.0f, 1.0f, 1.0f));
-        glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(cube.GetMatrix())));
+        glState.ResetStats();
+
+        {
+            PROFILE_SCOPE(profiler, "Assets");
+            loader.Update(ASSET_UPLOAD_BUDGET);
+        }
+
+        {
+            PROFILE_SCOPE(profiler, "Update");
+
+            frameUniforms.view = camera.GetViewMatrix();
+            frameUniforms.projection = glm::perspective(glm::radians(camera.GetZoom()), (float)windowWidth / (float)windowHeight, NEAR_PLANE, FAR_PLANE);
+            frameUniforms.cameraPos = glm::vec4(camera.GetPosition(), 1.0f);
+            frameBuffer.Upload(frameUniforms);
 
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            // The GPU path keeps its lights in GPU memory, the markers read them from there.
+            if (!gpuLights) {
+                simulation.Sample(lights);
 
-        light.Begin();
-        for (size_t i = 0; i < lights.size(); i++) {
-            glm::vec4 rotatedPos = lightRotationMatrix * glm::vec4(lights[i].position, 1.0f);
-            lights[i].position = glm::vec3(rotatedPos);
+                for (size_t i = 0; i < lights.size(); i++) {
+                    transforms.SetPosition(lightTransforms[i], lights[i].position);
+                }
+            }
 
-            light.SetPosition(lights[i].position);
-            light.GetShader()->Set("uColor", lights[i].color);
-            light.Draw(view, projection);
+            transforms.Update();
+
+            culling.Update(transforms);
+            culling.Cull(frameUniforms.projection * frameUniforms.view, visibleObjects);
+
+            if (!gpuLights) {
+                for (size_t i = 0; i < lights.size(); i++) {
+                    lightInstances[i].transform = transforms.GetWorldMatrix(lightTransforms[i]);
+                    lightInstances[i].color = glm::vec4(lights[i].color, 1.0f);
+                }
+            }
         }
-        light.End();
-        
-        cube.Begin();
-        cube.GetShader()->Set("uNormal", normalMatrix);
-        
-        cube.GetShader()->Set("uCameraPos", camera.GetPosition());
-        cube.GetShader()->Set("uObjectColor", glm::vec3(1.0f, 1.0f, 1.0f));
 
-        cube.GetShader()->Set("uLightColor1", lights[0].color);
-        cube.GetShader()->Set("uLightPos1", lights[0].position);
+        {
+            PROFILE_SCOPE(profiler, "Render");
+
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            renderQueue.Begin(frameUniforms.view, FAR_PLANE);
+
+            if (gpuLightAnimation) {
+                PROFILE_SCOPE(profiler, "Light animation");
+
+                gpuLightAnimation->Update(deltaTime);
+                gpuLightAnimation->Bind();
+            }
+
+            GLint lightCount = LIGHT_COUNT;
+
+            {
+                PROFILE_SCOPE(profiler, "Light buffer");
+
+                if (!gpuLightAnimation) {
+                    lightBuffer.Upload(lights);
+                    lightBuffer.Bind();
+                    lightCount = lightBuffer.GetCount();
+                }
+
+                // Per-program uniforms are set up front, the queue only sets per-draw ones.
+                if (cube && lightCountUniform.IsValid()) {
+                    cubeShader->Use();
+                    cubeShader->Set(lightCountUniform, lightCount);
+                }
+            }
+
+            if (cube && clusterParamsUniform.IsValid()) {
+                PROFILE_SCOPE(profiler, "Light clusters");
+
+                lightClusters.Build(lights.data(), lights.size(), frameUniforms.view, frameUniforms.projection, NEAR_PLANE, FAR_PLANE, &workers);
+                lightClusters.Upload();
+                lightClusters.Bind();
+
+                cubeShader->Use();
+                cubeShader->Set(clusterParamsUniform, lightClusters.GetShaderParams(windowWidth, windowHeight));
+            }
+
+            bool deferred = deferredShading && cubeGBuffer;
+
+            // The lit scene goes through the G-buffer, the light markers are
+            // unlit and drawn forward on top of it either way.
+            if (deferred) {
+                int framebufferWidth, framebufferHeight;
+                glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+                deferredRenderer.Resize(framebufferWidth, framebufferHeight);
+
+                {
+                    PROFILE_SCOPE(profiler, "Geometry pass");
+
+                    deferredRenderer.BeginGeometryPass();
+
+                    if (!visibleObjects.empty()) {
+                        renderQueue.Submit(*cubeGBuffer, transforms.GetWorldMatrix(cubeTransform), transforms.GetNormalMatrix(cubeTransform), glm::vec3(1.0f, 1.0f, 1.0f));
+                    }
 
-        cube.GetShader()->Set("uLightColor2", lights[1].color);
-        cube.GetShader()->Set("uLightPos2", lights[1].position);
+                    renderQueue.Flush();
+                }
 
-        cube.GetShader()->Set("uLightColor3", lights[2].color);
-        cube.GetShader()->Set("uLightPos3", lights[2].position);
+                {
+                    PROFILE_SCOPE(profiler, "Lighting pass");
+                    deferredRenderer.LightingPass(lightCount);
+                }
 
-        cube.GetShader()->Set("uLightColor4", lights[3].color);
-        cube.GetShader()->Set("uLightPos4", lights[3].position);
+                {
+                    PROFILE_SCOPE(profiler, "Composite");
+                    deferredRenderer.Composite();
+                }
+            }
 
-        cube.GetShader()->Set("uLightColor5", lights[4].color);
-        cube.GetShader()->Set("uLightPos5", lights[4].position);
+            // Models are drawn as soon as the loader has finished them.
+            if (light) {
+                PROFILE_SCOPE(profiler, "Light instances");
 
-        cube.GetShader()->Set("uLightColor6", lights[5].color);
-        cube.GetShader()->Set("uLightPos6", lights[5].position);
+                if (!gpuLightAnimation) {
+                    light->SetInstances(lightInstances);
+                }
 
-        cube.Draw(view, projection);
-        cube.End();
+                renderQueue.SubmitInstanced(*light);
+            }
+
+            if (cube && !deferred && !visibleObjects.empty()) {
+                renderQueue.Submit(*cube, transforms.GetWorldMatrix(cubeTransform), transforms.GetNormalMatrix(cubeTransform), glm::vec3(1.0f, 1.0f, 1.0f));
+            }
+
+            PROFILE_SCOPE(profiler, "Draw");
+            renderQueue.Flush();
+        }
+
+        {
+            PROFILE_SCOPE(profiler, "Swap");
+            glfwSwapBuffers(window);
+        }
 
-        glfwSwapBuffers(window);
         glfwPollEvents();
+
+        glDebug.Drain();
+
+        profiler.EndFrame();
+
+        if (printProfilerStats && currentFrame - lastStatsTime >= PROFILER_STATS_INTERVAL) {
+            profiler.PrintStats();
+            lastStatsTime = currentFrame;
+        }
+
+        if (toggleProfilerCapture) {
+            toggleProfilerCapture = false;
+
+            if (profiler.IsCapturing()) {
+                profiler.WriteChromeTrace(PROFILER_TRACE_PATH);
+            } else {
+                std::cout << "Capturing profiler trace, press T again to write it" << std::endl;
+                profiler.StartCapture();
+            }
+        }
     }
 
+    // exit() skips destructors, so the simulation thread has to be joined here.
+    simulation.Stop();
+
     glfwDestroyWindow(window);
     glfwTerminate();
 
@@ -124,7 +407,7 @@ void glfw_error(const char* msg) {
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     windowWidth = static_cast<float>(width);
     windowHeight = static_cast<float>(height);
-    glViewport(0, 0, width, height);
+    glState.SetViewport(0, 0, width, height);
 }
 
 GLFWwindow* create_window() {
@@ -145,6 +428,10 @@ GLFWwindow* create_window() {
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
+#if GL_DEBUG_LEVEL > 0
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+#endif
+
     GLFWwindow* window = glfwCreateWindow(static_cast<int>(windowWidth), static_cast<float>(windowHeight), "Learn OpenGL", nullptr, nullptr);
     if (!window) {
         glfw_error("Failed to create GLFW window");
@@ -159,13 +446,17 @@ GLFWwindow* create_window() {
         return nullptr;
     }
 
+    LoadGLExtensions((GLADloadproc)glfwGetProcAddress);
+    glDebug.Init();
+
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glEnable(GL_DEPTH_TEST);
+    glState.SetDepthTest(true);
     // glEnable(GL_FRAMEBUFFER_SRGB);
 
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetKeyCallback(window, key_callback);
 
     int maxVertexUniforms = 0;
     glGetIntegerv(GL_MAX_VERTEX_UNIFORM_COMPONENTS, &maxVertexUniforms);
@@ -220,4 +511,20 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn) {
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     camera.ProcessMouseScroll(static_cast<float>(yoffset));
-}
\ No newline at end of file
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    if (action != GLFW_PRESS)
+        return;
+
+    if (key == GLFW_KEY_P)
+        printProfilerStats = !printProfilerStats;
+
+    if (key == GLFW_KEY_T)
+        toggleProfilerCapture = true;
+
+    if (key == GLFW_KEY_R) {
+        deferredShading = !deferredShading;
+        std::cout << (deferredShading ? "Deferred" : "Forward") << " shading" << std::endl;
+    }
+}
@@ -0,0 +1,131 @@
+#include "mapped_file.hpp"
+
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile() : m_Data(nullptr), m_Size(0), m_File(INVALID_HANDLE_VALUE), m_Mapping(nullptr) {}
+#else
+MappedFile::MappedFile() : m_Data(nullptr), m_Size(0) {}
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const char* path) {
+    Close();
+
+    m_File = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_File == INVALID_HANDLE_VALUE) {
+        std::cerr << "ERROR: Failed to open \"" << path << "\" for mapping\n";
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_File, &size) || size.QuadPart == 0) {
+        std::cerr << "ERROR: Failed to get the size of \"" << path << "\"\n";
+        Close();
+        return false;
+    }
+
+    m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_Mapping) {
+        std::cerr << "ERROR: Failed to map \"" << path << "\"\n";
+        Close();
+        return false;
+    }
+
+    m_Data = static_cast<const unsigned char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_Data) {
+        std::cerr << "ERROR: Failed to map \"" << path << "\"\n";
+        Close();
+        return false;
+    }
+
+    m_Size = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (m_Data) {
+        UnmapViewOfFile(m_Data);
+    }
+
+    if (m_Mapping) {
+        CloseHandle(m_Mapping);
+    }
+
+    if (m_File != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_File);
+    }
+
+    m_Data = nullptr;
+    m_Size = 0;
+    m_Mapping = nullptr;
+    m_File = INVALID_HANDLE_VALUE;
+}
+#else
+bool MappedFile::Open(const char* path) {
+    Close();
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        std::cerr << "ERROR: Failed to open \"" << path << "\" for mapping\n";
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == -1 || info.st_size == 0) {
+        std::cerr << "ERROR: Failed to get the size of \"" << path << "\"\n";
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping keeps its own reference to the file.
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        std::cerr << "ERROR: Failed to map \"" << path << "\"\n";
+        return false;
+    }
+
+    // The whole file is read front to back by the upload, so ask for read-ahead.
+    madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+    madvise(data, static_cast<size_t>(info.st_size), MADV_WILLNEED);
+
+    m_Data = static_cast<const unsigned char*>(data);
+    m_Size = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (m_Data) {
+        munmap(const_cast<unsigned char*>(m_Data), m_Size);
+    }
+
+    m_Data = nullptr;
+    m_Size = 0;
+}
+#endif
+
+const unsigned char* MappedFile::GetData() const {
+    return m_Data;
+}
+
+size_t MappedFile::GetSize() const {
+    return m_Size;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+
+// Read-only memory mapping of a whole file. The contents are paged in by the OS
+// on first touch, so large files can be handed to the driver without being
+// copied into a heap buffer first.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const char* path);
+    void Close();
+
+    const unsigned char* GetData() const;
+    size_t GetSize() const;
+
+private:
+    const unsigned char* m_Data;
+    size_t m_Size;
+
+#ifdef _WIN32
+    void* m_File;
+    void* m_Mapping;
+#endif
+};
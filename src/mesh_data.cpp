@@ -0,0 +1,160 @@
+#include "mesh_data.hpp"
+
+#include <glm/gtc/packing.hpp>
+
+#include <cstring>
+#include <iostream>
+
+bool BuildMeshData(const std::vector<float>& vertices, const std::vector<float>& normals, const std::vector<float>& colors, const std::vector<float>& texCoords, const VertexFormat& format, MeshData& mesh) {
+    // Determine if the colors and texCoords exist.
+    bool hasNormals = !normals.empty();
+    bool hasColors = !colors.empty();
+    bool hasTexCoords = !texCoords.empty();
+
+    if (hasNormals && normals.size() / 3 != vertices.size() / 3) {
+        std::cerr << "Error: Mismatch in vertex and normal data size!\n";
+        return false;
+    }
+
+    if (hasColors && colors.size() / 3 != vertices.size() / 3) {
+        std::cerr << "Error: Mismatch in vertex and color data size!\n";
+        return false;
+    }
+
+    if (hasTexCoords && texCoords.size() / 2 != vertices.size() / 3) {
+        std::cerr << "Error: Mismatch in vertex and texture coordinates data size!\n";
+        return false;
+    }
+
+    size_t numVertices = vertices.size() / 3;
+
+    mesh.vertexStorage = PackVertices(format, vertices.data(), hasNormals ? normals.data() : nullptr, hasColors ? colors.data() : nullptr, hasTexCoords ? texCoords.data() : nullptr, numVertices, mesh.layout);
+
+    // Merge duplicated vertices and order the triangles for the post-transform cache.
+    std::vector<uint32_t> indices = WeldVertices(mesh.vertexStorage, mesh.layout.stride);
+    size_t uniqueVertices = mesh.vertexStorage.size() / mesh.layout.stride;
+
+    OptimizeVertexCache(indices, uniqueVertices);
+    OptimizeVertexFetch(mesh.vertexStorage, mesh.layout.stride, indices);
+
+    // 16-bit indices are enough for most meshes and halve the index buffer.
+    if (uniqueVertices <= UINT16_MAX) {
+        std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(shortIndices.data());
+        mesh.indexStorage.assign(bytes, bytes + shortIndices.size() * sizeof(uint16_t));
+        mesh.indexType = GL_UNSIGNED_SHORT;
+    } else {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(indices.data());
+        mesh.indexStorage.assign(bytes, bytes + indices.size() * sizeof(uint32_t));
+        mesh.indexType = GL_UNSIGNED_INT;
+    }
+
+    mesh.vertexData = mesh.vertexStorage.data();
+    mesh.vertexBytes = mesh.vertexStorage.size();
+    mesh.indexData = mesh.indexStorage.data();
+    mesh.indexCount = indices.size();
+
+    return true;
+}
+
+static void touchPages(const void* data, size_t size) {
+    // Reading one byte per page makes the OS fault the mapping in on this thread.
+    const size_t pageSize = 4096;
+    const volatile unsigned char* bytes = static_cast<const volatile unsigned char*>(data);
+
+    unsigned char sink = 0;
+    for (size_t offset = 0; offset < size; offset += pageSize) {
+        sink ^= bytes[offset];
+    }
+
+    (void)sink;
+}
+
+bool LoadMeshData(const char* meshPath, MeshData& mesh) {
+    std::unique_ptr<MeshFile> file = std::make_unique<MeshFile>();
+    if (!file->Open(meshPath)) {
+        std::cerr << "Error: Failed to load mesh \"" << meshPath << "\"!\n";
+        return false;
+    }
+
+    mesh.layout = file->GetLayout();
+    mesh.vertexData = file->GetVertexData();
+    mesh.vertexBytes = file->GetVertexDataSize();
+    mesh.indexData = file->GetIndexData();
+    mesh.indexCount = file->GetIndexCount();
+    mesh.indexType = file->GetIndexType();
+
+    touchPages(mesh.vertexData, mesh.vertexBytes);
+    touchPages(mesh.indexData, file->GetIndexDataSize());
+
+    mesh.file = std::move(file);
+    return true;
+}
+
+void ReadMeshPositions(const MeshData& mesh, std::vector<glm::vec3>& positions) {
+    const VertexLayout& layout = mesh.layout;
+    positions.clear();
+
+    // Positions always come first, at location 0.
+    const VertexAttribute* position = nullptr;
+    for (uint32_t i = 0; i < layout.attributeCount; i++) {
+        if (layout.attributes[i].location == 0) {
+            position = &layout.attributes[i];
+        }
+    }
+
+    if (!mesh.IsValid() || position == nullptr || layout.stride == 0) {
+        return;
+    }
+
+    // Only the formats PackVertices writes are read, and only when they lie inside the vertex.
+    bool readable = position->components == 3 && (position->type == GL_FLOAT || position->type == GL_HALF_FLOAT || position->type == GL_SHORT);
+    size_t positionSize = position->type == GL_FLOAT ? 3 * sizeof(float) : 3 * sizeof(uint16_t);
+    if (!readable || position->offset > layout.stride || positionSize > layout.stride - position->offset) {
+        return;
+    }
+
+    const unsigned char* vertices = static_cast<const unsigned char*>(mesh.vertexData);
+    size_t vertexCount = mesh.vertexBytes / layout.stride;
+
+    glm::vec3 positionScale(layout.positionScale[0], layout.positionScale[1], layout.positionScale[2]);
+    glm::vec3 positionOffset(layout.positionOffset[0], layout.positionOffset[1], layout.positionOffset[2]);
+
+    positions.resize(vertexCount);
+
+    for (size_t i = 0; i < vertexCount; i++) {
+        const unsigned char* data = vertices + i * layout.stride + position->offset;
+        glm::vec3 point(0.0f);
+
+        if (position->type == GL_FLOAT) {
+            std::memcpy(&point, data, sizeof(point));
+        } else {
+            uint16_t packed[3];
+            std::memcpy(packed, data, sizeof(packed));
+
+            for (int axis = 0; axis < 3; axis++) {
+                point[axis] = position->type == GL_HALF_FLOAT ? glm::unpackHalf1x16(packed[axis]) : glm::unpackSnorm1x16(packed[axis]);
+            }
+        }
+
+        positions[i] = point * positionScale + positionOffset;
+    }
+}
+
+void ReadMeshIndices(const MeshData& mesh, std::vector<uint32_t>& indices) {
+    indices.resize(mesh.IsValid() ? mesh.indexCount : 0);
+
+    for (size_t i = 0; i < indices.size(); i++) {
+        switch (mesh.indexType) {
+        case GL_UNSIGNED_BYTE:
+            indices[i] = static_cast<const uint8_t*>(mesh.indexData)[i];
+            break;
+        case GL_UNSIGNED_SHORT:
+            indices[i] = static_cast<const uint16_t*>(mesh.indexData)[i];
+            break;
+        default:
+            indices[i] = static_cast<const uint32_t*>(mesh.indexData)[i];
+            break;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "mesh_file.hpp"
+#include "mesh_optimizer.hpp"
+#include "vertex_format.hpp"
+#include "vertex_layout.hpp"
+
+// Geometry that has been prepared on the CPU and only needs to be uploaded.
+// The data pointers refer either to the storage vectors or into a mapped mesh
+// file owned by the MeshData, so it does not touch GL and can be built on any
+// thread and then moved to the GL thread.
+struct MeshData {
+    VertexLayout layout;
+    const void* vertexData = nullptr;
+    size_t vertexBytes = 0;
+    const void* indexData = nullptr;
+    size_t indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_SHORT;
+
+    std::vector<unsigned char> vertexStorage;
+    std::vector<unsigned char> indexStorage;
+    std::unique_ptr<MeshFile> file;
+
+    MeshData() = default;
+    MeshData(MeshData&&) = default;
+    MeshData& operator=(MeshData&&) = default;
+
+    MeshData(const MeshData&) = delete;
+    MeshData& operator=(const MeshData&) = delete;
+
+    bool IsValid() const { return vertexData != nullptr && indexCount > 0; }
+};
+
+// Interleaves, welds and cache-optimises separate attribute streams. Empty
+// normals, colors or texCoords are left out of the layout.
+bool BuildMeshData(const std::vector<float>& vertices, const std::vector<float>& normals, const std::vector<float>& colors, const std::vector<float>& texCoords, const VertexFormat& format, MeshData& mesh);
+
+// Maps a binary mesh file and pages its contents in so the upload does not wait on disk.
+bool LoadMeshData(const char* meshPath, MeshData& mesh);
+
+// Decodes the object space position of every vertex, whatever format it is stored in.
+void ReadMeshPositions(const MeshData& mesh, std::vector<glm::vec3>& positions);
+
+// Widens the indices to 32 bits.
+void ReadMeshIndices(const MeshData& mesh, std::vector<uint32_t>& indices);
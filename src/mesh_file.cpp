@@ -0,0 +1,209 @@
+#include "mesh_file.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+size_t GetIndexSize(GLenum indexType) {
+    switch (indexType) {
+    case GL_UNSIGNED_BYTE:
+        return 1;
+    case GL_UNSIGNED_SHORT:
+        return 2;
+    case GL_UNSIGNED_INT:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+size_t GetAttributeSize(const VertexAttribute& attribute) {
+    if (attribute.components < 1 || attribute.components > 4) {
+        return 0;
+    }
+
+    switch (attribute.type) {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+        return attribute.components;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT:
+        return attribute.components * 2;
+    case GL_INT:
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:
+        return attribute.components * 4;
+    case GL_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_2_10_10_10_REV:
+        return attribute.components == 4 ? 4 : 0;
+    default:
+        return 0;
+    }
+}
+
+// Every attribute has to lie inside the vertex, or reading the last vertex runs past the data.
+static bool isValidLayout(const VertexLayout& layout) {
+    if (layout.stride == 0 || layout.attributeCount > MAX_VERTEX_ATTRIBUTES) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < layout.attributeCount; i++) {
+        const VertexAttribute& attribute = layout.attributes[i];
+        size_t size = GetAttributeSize(attribute);
+
+        if (size == 0 || attribute.location >= MESH_FILE_MAX_LOCATION || attribute.offset > layout.stride || size > layout.stride - attribute.offset) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template <typename T>
+static bool indicesInRange(const void* data, uint32_t count, uint32_t vertexCount) {
+    const T* indices = static_cast<const T*>(data);
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (indices[i] >= vertexCount) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static uint64_t alignOffset(uint64_t offset) {
+    return (offset + MESH_FILE_ALIGNMENT - 1) & ~static_cast<uint64_t>(MESH_FILE_ALIGNMENT - 1);
+}
+
+MeshFile::MeshFile() : m_Header() {}
+
+bool MeshFile::Open(const char* path) {
+    m_Header = MeshFileHeader();
+
+    if (!m_File.Open(path)) {
+        return false;
+    }
+
+    if (m_File.GetSize() < sizeof(MeshFileHeader)) {
+        std::cerr << "ERROR: \"" << path << "\" is too small to be a mesh file\n";
+        m_File.Close();
+        return false;
+    }
+
+    MeshFileHeader header;
+    std::memcpy(&header, m_File.GetData(), sizeof(MeshFileHeader));
+
+    if (header.magic != MESH_FILE_MAGIC || header.version != MESH_FILE_VERSION) {
+        std::cerr << "ERROR: \"" << path << "\" is not a version " << MESH_FILE_VERSION << " mesh file\n";
+        m_File.Close();
+        return false;
+    }
+
+    // Counts and strides are 32-bit, so their products cannot overflow 64 bits.
+    // The offsets come from the file, so the range checks subtract instead of
+    // adding, which a crafted header could make wrap around.
+    size_t indexSize = GetIndexSize(header.indexType);
+    uint64_t vertexBytes = static_cast<uint64_t>(header.vertexCount) * header.layout.stride;
+    uint64_t indexBytes = static_cast<uint64_t>(header.indexCount) * indexSize;
+    uint64_t fileSize = m_File.GetSize();
+
+    bool valid = indexSize != 0 &&
+                 isValidLayout(header.layout) &&
+                 header.vertexOffset >= sizeof(MeshFileHeader) &&
+                 header.vertexOffset <= fileSize && vertexBytes <= fileSize - header.vertexOffset &&
+                 header.indexOffset >= header.vertexOffset && header.indexOffset - header.vertexOffset >= vertexBytes &&
+                 header.indexOffset <= fileSize && indexBytes <= fileSize - header.indexOffset &&
+                 header.indexOffset % indexSize == 0;
+
+    if (!valid) {
+        std::cerr << "ERROR: \"" << path << "\" has a corrupt header\n";
+        m_File.Close();
+        return false;
+    }
+
+    // The indices are used as they are by the CPU readers and the GPU, so each one has to name a vertex.
+    const unsigned char* indexData = m_File.GetData() + header.indexOffset;
+    bool inRange = header.indexType == GL_UNSIGNED_BYTE ? indicesInRange<uint8_t>(indexData, header.indexCount, header.vertexCount) :
+                   header.indexType == GL_UNSIGNED_SHORT ? indicesInRange<uint16_t>(indexData, header.indexCount, header.vertexCount) :
+                   indicesInRange<uint32_t>(indexData, header.indexCount, header.vertexCount);
+
+    if (!inRange) {
+        std::cerr << "ERROR: \"" << path << "\" has indices past its last vertex\n";
+        m_File.Close();
+        return false;
+    }
+
+    m_Header = header;
+    return true;
+}
+
+const VertexLayout& MeshFile::GetLayout() const {
+    return m_Header.layout;
+}
+
+const void* MeshFile::GetVertexData() const {
+    return m_File.GetData() + m_Header.vertexOffset;
+}
+
+size_t MeshFile::GetVertexDataSize() const {
+    return static_cast<size_t>(m_Header.vertexCount) * m_Header.layout.stride;
+}
+
+uint32_t MeshFile::GetVertexCount() const {
+    return m_Header.vertexCount;
+}
+
+const void* MeshFile::GetIndexData() const {
+    return m_File.GetData() + m_Header.indexOffset;
+}
+
+size_t MeshFile::GetIndexDataSize() const {
+    return static_cast<size_t>(m_Header.indexCount) * GetIndexSize(m_Header.indexType);
+}
+
+uint32_t MeshFile::GetIndexCount() const {
+    return m_Header.indexCount;
+}
+
+GLenum MeshFile::GetIndexType() const {
+    return m_Header.indexType;
+}
+
+bool WriteMeshFile(const char* path, const VertexLayout& layout, const void* vertices, uint32_t vertexCount, const void* indices, uint32_t indexCount, GLenum indexType) {
+    MeshFileHeader header = {};
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+    header.vertexCount = vertexCount;
+    header.indexCount = indexCount;
+    header.indexType = indexType;
+    header.layout = layout;
+
+    uint64_t vertexBytes = static_cast<uint64_t>(vertexCount) * layout.stride;
+    uint64_t indexBytes = static_cast<uint64_t>(indexCount) * GetIndexSize(indexType);
+
+    header.vertexOffset = alignOffset(sizeof(MeshFileHeader));
+    header.indexOffset = alignOffset(header.vertexOffset + vertexBytes);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "ERROR: Failed to open \"" << path << "\" for writing\n";
+        return false;
+    }
+
+    const char padding[MESH_FILE_ALIGNMENT] = {};
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(padding, static_cast<std::streamsize>(header.vertexOffset - sizeof(header)));
+    file.write(static_cast<const char*>(vertices), static_cast<std::streamsize>(vertexBytes));
+    file.write(padding, static_cast<std::streamsize>(header.indexOffset - header.vertexOffset - vertexBytes));
+    file.write(static_cast<const char*>(indices), static_cast<std::streamsize>(indexBytes));
+
+    if (!file) {
+        std::cerr << "ERROR: Failed to write \"" << path << "\"\n";
+        return false;
+    }
+
+    return true;
+}
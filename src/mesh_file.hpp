@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+
+#include "mapped_file.hpp"
+#include "vertex_layout.hpp"
+
+// Binary mesh files hold vertex and index data that is ready to be handed to
+// glBufferData as is. The file starts with a MeshFileHeader, followed by the
+// interleaved vertices and then the indices, each at the offset given in the
+// header. All values are little endian.
+constexpr uint32_t MESH_FILE_MAGIC = 0x48534D48; // "HMSH"
+constexpr uint32_t MESH_FILE_VERSION = 2;
+constexpr uint32_t MESH_FILE_ALIGNMENT = 16;
+
+// Attribute locations in a file stay below the minimum GL_MAX_VERTEX_ATTRIBS.
+constexpr uint32_t MESH_FILE_MAX_LOCATION = 16;
+
+struct MeshFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t indexType;
+    uint32_t reserved;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    VertexLayout layout;
+};
+
+// A mesh file mapped into memory. The vertex and index pointers point straight
+// into the mapping and stay valid until the MeshFile is destroyed.
+class MeshFile {
+public:
+    MeshFile();
+
+    bool Open(const char* path);
+
+    const VertexLayout& GetLayout() const;
+
+    const void* GetVertexData() const;
+    size_t GetVertexDataSize() const;
+    uint32_t GetVertexCount() const;
+
+    const void* GetIndexData() const;
+    size_t GetIndexDataSize() const;
+    uint32_t GetIndexCount() const;
+    GLenum GetIndexType() const;
+
+private:
+    MappedFile m_File;
+    MeshFileHeader m_Header;
+};
+
+// Writes a mesh file. Used by the offline converter.
+bool WriteMeshFile(const char* path, const VertexLayout& layout, const void* vertices, uint32_t vertexCount, const void* indices, uint32_t indexCount, GLenum indexType);
+
+size_t GetIndexSize(GLenum indexType);
+
+// Bytes taken by one attribute, 0 if glVertexAttribPointer would reject its type or component count.
+size_t GetAttributeSize(const VertexAttribute& attribute);
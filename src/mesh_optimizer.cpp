@@ -0,0 +1,260 @@
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static uint64_t hashVertex(const unsigned char* vertex, size_t vertexSize) {
+    // FNV-1a over the raw bits so that only exactly identical vertices are merged.
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < vertexSize; i++) {
+        hash ^= vertex[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+std::vector<uint32_t> WeldVertices(std::vector<unsigned char>& vertices, size_t vertexSize) {
+    size_t vertexCount = vertices.size() / vertexSize;
+    std::vector<uint32_t> indices(vertexCount);
+
+    // Open addressing table of unique vertex indices, kept at most half full.
+    size_t tableSize = 1;
+    while (tableSize < vertexCount * 2) {
+        tableSize *= 2;
+    }
+
+    const uint32_t empty = UINT32_MAX;
+    std::vector<uint32_t> table(tableSize, empty);
+    uint32_t uniqueCount = 0;
+
+    for (size_t i = 0; i < vertexCount; i++) {
+        const unsigned char* vertex = &vertices[i * vertexSize];
+        size_t slot = static_cast<size_t>(hashVertex(vertex, vertexSize)) & (tableSize - 1);
+
+        while (table[slot] != empty) {
+            const unsigned char* existing = &vertices[static_cast<size_t>(table[slot]) * vertexSize];
+            if (std::memcmp(existing, vertex, vertexSize) == 0) {
+                break;
+            }
+
+            slot = (slot + 1) & (tableSize - 1);
+        }
+
+        if (table[slot] == empty) {
+            // Unique vertices are moved down in place. The destination never
+            // overtakes the source, so unread vertices are not overwritten.
+            if (uniqueCount != i) {
+                std::memmove(&vertices[uniqueCount * vertexSize], vertex, vertexSize);
+            }
+
+            table[slot] = uniqueCount++;
+        }
+
+        indices[i] = table[slot];
+    }
+
+    vertices.resize(static_cast<size_t>(uniqueCount) * vertexSize);
+    vertices.shrink_to_fit();
+
+    return indices;
+}
+
+namespace {
+
+constexpr int CACHE_SIZE = 32;
+constexpr float CACHE_DECAY_POWER = 1.5f;
+constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float VALENCE_BOOST_SCALE = 2.0f;
+constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+float vertexScore(int cachePosition, uint32_t remainingValence) {
+    if (remainingValence == 0) {
+        // No triangle needs this vertex any more.
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // The vertices of the last triangle get a fixed score so the next
+            // triangle does not simply reuse the same edge every time.
+            score = LAST_TRIANGLE_SCORE;
+        } else {
+            float scaler = 1.0f / (CACHE_SIZE - 3);
+            score = 1.0f - (cachePosition - 3) * scaler;
+            score = std::pow(score, CACHE_DECAY_POWER);
+        }
+    }
+
+    // Boost vertices with few triangles left so lone triangles are not stranded.
+    score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingValence), -VALENCE_BOOST_POWER);
+    return score;
+}
+
+}
+
+void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Vertex -> triangle adjacency in compressed form. The active part of each
+    // vertex's list shrinks as its triangles are emitted.
+    std::vector<uint32_t> valence(vertexCount, 0);
+    for (uint32_t index : indices) {
+        valence[index]++;
+    }
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) {
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + valence[v];
+    }
+
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (size_t k = 0; k < 3; k++) {
+            uint32_t v = indices[t * 3 + k];
+            adjacency[fill[v]++] = static_cast<uint32_t>(t);
+        }
+    }
+
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        vertexScores[v] = vertexScore(-1, valence[v]);
+    }
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; t++) {
+        triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    // Cache of vertex indices with room for the three vertices of the new triangle.
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> nextCache;
+    cache.reserve(CACHE_SIZE + 3);
+    nextCache.reserve(CACHE_SIZE + 3);
+
+    size_t scanCursor = 0;
+    int64_t bestTriangle = -1;
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+        if (bestTriangle < 0) {
+            // Nothing in the cache touches a remaining triangle, so fall back to
+            // the best remaining triangle. The cursor only ever moves forward.
+            float bestScore = -1.0f;
+            while (scanCursor < triangleCount && emitted[scanCursor]) {
+                scanCursor++;
+            }
+
+            for (size_t t = scanCursor; t < triangleCount; t++) {
+                if (!emitted[t] && triangleScores[t] > bestScore) {
+                    bestScore = triangleScores[t];
+                    bestTriangle = static_cast<int64_t>(t);
+                }
+            }
+        }
+
+        size_t triangle = static_cast<size_t>(bestTriangle);
+        emitted[triangle] = true;
+
+        const uint32_t* tri = &indices[triangle * 3];
+        output.insert(output.end(), tri, tri + 3);
+
+        // Remove the triangle from the active adjacency of its vertices.
+        for (size_t k = 0; k < 3; k++) {
+            uint32_t v = tri[k];
+            uint32_t begin = adjacencyOffsets[v];
+            uint32_t end = begin + valence[v];
+            for (uint32_t a = begin; a < end; a++) {
+                if (adjacency[a] == triangle) {
+                    std::swap(adjacency[a], adjacency[end - 1]);
+                    break;
+                }
+            }
+
+            valence[v]--;
+        }
+
+        // Move the triangle's vertices to the front of the LRU cache.
+        nextCache.assign(tri, tri + 3);
+        for (uint32_t v : cache) {
+            if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                nextCache.push_back(v);
+            }
+        }
+
+        // Vertices pushed out of the cache lose their cache score.
+        for (size_t i = CACHE_SIZE; i < nextCache.size(); i++) {
+            uint32_t v = nextCache[i];
+            vertexScores[v] = vertexScore(-1, valence[v]);
+        }
+
+        if (nextCache.size() > static_cast<size_t>(CACHE_SIZE)) {
+            // Keep the evicted vertices around for the triangle rescoring below.
+            for (size_t i = CACHE_SIZE; i < nextCache.size(); i++) {
+                uint32_t v = nextCache[i];
+                for (uint32_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v] + valence[v]; a++) {
+                    uint32_t t = adjacency[a];
+                    triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+                }
+            }
+
+            nextCache.resize(CACHE_SIZE);
+        }
+
+        std::swap(cache, nextCache);
+
+        for (size_t i = 0; i < cache.size(); i++) {
+            uint32_t v = cache[i];
+            vertexScores[v] = vertexScore(static_cast<int>(i), valence[v]);
+        }
+
+        // Rescore every triangle that touches the cache and pick the next one from them.
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (uint32_t v : cache) {
+            for (uint32_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v] + valence[v]; a++) {
+                uint32_t t = adjacency[a];
+                float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+                triangleScores[t] = score;
+
+                if (score > bestScore) {
+                    bestScore = score;
+                    bestTriangle = t;
+                }
+            }
+        }
+    }
+
+    indices.swap(output);
+}
+
+void OptimizeVertexFetch(std::vector<unsigned char>& vertices, size_t vertexSize, std::vector<uint32_t>& indices) {
+    size_t vertexCount = vertices.size() / vertexSize;
+
+    const uint32_t unused = UINT32_MAX;
+    std::vector<uint32_t> remap(vertexCount, unused);
+    std::vector<unsigned char> reordered;
+    reordered.reserve(vertices.size());
+
+    uint32_t next = 0;
+    for (uint32_t& index : indices) {
+        if (remap[index] == unused) {
+            remap[index] = next++;
+            const unsigned char* vertex = &vertices[static_cast<size_t>(index) * vertexSize];
+            reordered.insert(reordered.end(), vertex, vertex + vertexSize);
+        }
+
+        index = remap[index];
+    }
+
+    vertices.swap(reordered);
+}
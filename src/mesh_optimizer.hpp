@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Merges bit-identical vertices of an interleaved vertex stream of vertexSize
+// byte vertices. The stream is compacted in place and the returned indices
+// rebuild the original triangle list.
+std::vector<uint32_t> WeldVertices(std::vector<unsigned char>& vertices, size_t vertexSize);
+
+// Reorders the triangles of an indexed triangle list so that recently transformed
+// vertices are reused as often as possible (Tom Forsyth's linear-speed vertex
+// cache optimisation). The set of triangles and their winding are unchanged.
+void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+// Reorders vertices into the order the index buffer first references them so
+// vertex fetches walk memory linearly. Indices are remapped to match.
+void OptimizeVertexFetch(std::vector<unsigned char>& vertices, size_t vertexSize, std::vector<uint32_t>& indices);
@@ -1,45 +1,203 @@
 #include "model.hpp"
+#include "gl_state.hpp"
+#include "transform_system.hpp"
 
-Model::Model(const std::vector<float>& vertices, const std::vector<float>& normals, const std::vector<float>& colors, const std::vector<float>& texCoords, const char* vertexPath, const char* fragmentPath) : m_VAO(0), m_VBO(0), m_indexCount(static_cast<GLsizei>(vertices.size())), m_Shader(std::make_shared<Shader>(vertexPath, fragmentPath)), m_Position(glm::vec3(0.0f)), m_Rotation(0.0f), m_RotationAxis(glm::vec3(1.0f, 1.0f, 1.0f)), m_Scale(glm::vec3(1.0f)) {
-    setupModel(vertices, normals, colors, texCoords);
+#include <algorithm>
+
+Model::Model(const std::vector<float>& vertices, const std::vector<float>& normals, const std::vector<float>& colors, const std::vector<float>& texCoords, const char* vertexPath, const char* fragmentPath, const VertexFormat& format) : m_VAO(0), m_Pool(nullptr), m_InstanceVBO(0), m_instanceCapacity(0), m_instanceCount(0), m_Shader(std::make_shared<Shader>(vertexPath, fragmentPath)), m_PositionDequantize(1.0f), m_OctahedralNormals(false), m_Position(glm::vec3(0.0f)), m_Rotation(0.0f), m_RotationAxis(glm::vec3(1.0f, 1.0f, 1.0f)), m_Scale(glm::vec3(1.0f)), m_Matrix(1.0f), m_MatrixDirty(false) {
+    MeshData mesh;
+    BuildMeshData(vertices, normals, colors, texCoords, format, mesh);
+
+    setupModel(mesh);
+    setupUniforms();
+}
+
+Model::Model(const std::vector<float>& vertices, const std::vector<float>& normals, const std::vector<float>& colors, const std::vector<float>& texCoords, std::shared_ptr<Shader> shader, const VertexFormat& format) : m_VAO(0), m_Pool(nullptr), m_InstanceVBO(0), m_instanceCapacity(0), m_instanceCount(0), m_Shader(shader), m_PositionDequantize(1.0f), m_OctahedralNormals(false), m_Position(glm::vec3(0.0f)), m_Rotation(0.0f), m_RotationAxis(glm::vec3(1.0f, 0.3f, 0.5f)), m_Scale(glm::vec3(1.0f)), m_Matrix(1.0f), m_MatrixDirty(false) {
+    MeshData mesh;
+    BuildMeshData(vertices, normals, colors, texCoords, format, mesh);
+
+    setupModel(mesh);
+    setupUniforms();
+}
+
+Model::Model(const char* meshPath, const char* vertexPath, const char* fragmentPath) : m_VAO(0), m_Pool(nullptr), m_InstanceVBO(0), m_instanceCapacity(0), m_instanceCount(0), m_Shader(std::make_shared<Shader>(vertexPath, fragmentPath)), m_PositionDequantize(1.0f), m_OctahedralNormals(false), m_Position(glm::vec3(0.0f)), m_Rotation(0.0f), m_RotationAxis(glm::vec3(1.0f, 1.0f, 1.0f)), m_Scale(glm::vec3(1.0f)), m_Matrix(1.0f), m_MatrixDirty(false) {
+    MeshData mesh;
+    LoadMeshData(meshPath, mesh);
+
+    setupModel(mesh);
+    setupUniforms();
+}
+
+Model::Model(const char* meshPath, std::shared_ptr<Shader> shader) : m_VAO(0), m_Pool(nullptr), m_InstanceVBO(0), m_instanceCapacity(0), m_instanceCount(0), m_Shader(shader), m_PositionDequantize(1.0f), m_OctahedralNormals(false), m_Position(glm::vec3(0.0f)), m_Rotation(0.0f), m_RotationAxis(glm::vec3(1.0f, 1.0f, 1.0f)), m_Scale(glm::vec3(1.0f)), m_Matrix(1.0f), m_MatrixDirty(false) {
+    MeshData mesh;
+    LoadMeshData(meshPath, mesh);
+
+    setupModel(mesh);
+    setupUniforms();
 }
 
-Model::Model(const std::vector<float>& vertices, const std::vector<float>& normals, const std::vector<float>& colors, const std::vector<float>& texCoords, std::shared_ptr<Shader> shader) : m_VAO(0), m_VBO(0), m_indexCount(static_cast<GLsizei>(vertices.size())), m_Shader(shader), m_Position(glm::vec3(0.0f)), m_Rotation(0.0f), m_RotationAxis(glm::vec3(1.0f, 0.3f, 0.5f)), m_Scale(glm::vec3(1.0f)) {
-    setupModel(vertices, normals, colors, texCoords);
+Model::Model(const MeshData& mesh, std::shared_ptr<Shader> shader, GeometryPool* pool) : m_VAO(0), m_Pool(nullptr), m_InstanceVBO(0), m_instanceCapacity(0), m_instanceCount(0), m_Shader(shader), m_PositionDequantize(1.0f), m_OctahedralNormals(false), m_Position(glm::vec3(0.0f)), m_Rotation(0.0f), m_RotationAxis(glm::vec3(1.0f, 1.0f, 1.0f)), m_Scale(glm::vec3(1.0f)), m_Matrix(1.0f), m_MatrixDirty(false) {
+    setupModel(mesh, pool);
+    setupUniforms();
 }
 
 Model::~Model() {
-    GL_CHECK(glDeleteVertexArrays(1, &m_VAO));
-    GL_CHECK(glDeleteBuffers(1, &m_VBO));
+    if (m_VAO != m_Geometry.vertexArray) {
+        glState.DeleteVertexArray(m_VAO);
+    }
+
+    if (m_Pool) {
+        m_Pool->Release(m_Geometry);
+    } else {
+        glState.DeleteVertexArray(m_Geometry.vertexArray);
+        glState.DeleteBuffer(m_Geometry.vertexBuffer);
+        glState.DeleteBuffer(m_Geometry.indexBuffer);
+    }
+
+    if (m_InstanceVBO != 0) {
+        glState.DeleteBuffer(m_InstanceVBO);
+    }
 }
 
 void Model::Begin() const {
-    GL_CHECK(glBindVertexArray(m_VAO));
+    glState.BindVertexArray(m_VAO);
     m_Shader->Use();
 }
 
-void Model::Draw(const glm::mat4& view, const glm::mat4& projection) const {
-    m_Shader->Set("uModel", GetMatrix());
-    m_Shader->Set("uView", view);
-    m_Shader->Set("uProjection", projection);
+void Model::Draw() const {
+    m_Shader->Set(m_ModelUniform, GetMatrix() * m_PositionDequantize);
+
+    GL_CHECK(glDrawElementsBaseVertex(GL_TRIANGLES, m_Geometry.indexCount, m_Geometry.indexType, reinterpret_cast<void*>(m_Geometry.indexOffset), m_Geometry.baseVertex));
+}
 
-    GL_CHECK(glDrawArrays(GL_TRIANGLES, 0, m_indexCount));
+void Model::DrawInstanced() const {
+    DrawInstanced(GetMatrix());
+}
+
+void Model::Draw(const glm::mat4& transform, const glm::vec3& color) const {
+    Draw(transform, m_NormalUniform.IsValid() ? ComputeNormalMatrix(transform) : glm::mat3(1.0f), color);
+}
+
+void Model::Draw(const glm::mat4& transform, const glm::mat3& normal, const glm::vec3& color) const {
+    m_Shader->Set(m_ModelUniform, transform * m_PositionDequantize);
+
+    if (m_NormalUniform.IsValid()) {
+        m_Shader->Set(m_NormalUniform, normal);
+    }
+
+    m_Shader->Set(m_ColorUniform, color);
+
+    GL_CHECK(glDrawElementsBaseVertex(GL_TRIANGLES, m_Geometry.indexCount, m_Geometry.indexType, reinterpret_cast<void*>(m_Geometry.indexOffset), m_Geometry.baseVertex));
+}
+
+void Model::DrawInstanced(const glm::mat4& transform) const {
+    if (m_instanceCount == 0) {
+        return;
+    }
+
+    m_Shader->Set(m_ModelUniform, transform * m_PositionDequantize);
+
+    GL_CHECK(glDrawElementsInstancedBaseVertex(GL_TRIANGLES, m_Geometry.indexCount, m_Geometry.indexType, reinterpret_cast<void*>(m_Geometry.indexOffset), m_instanceCount, m_Geometry.baseVertex));
+}
+
+void Model::DrawWithDrawData(GLint drawIndex) const {
+    m_Shader->Set(m_DrawBaseUniform, drawIndex);
+
+    GL_CHECK(glDrawElementsBaseVertex(GL_TRIANGLES, m_Geometry.indexCount, m_Geometry.indexType, reinterpret_cast<void*>(m_Geometry.indexOffset), m_Geometry.baseVertex));
+}
+
+void Model::WriteDrawData(const glm::mat4& transform, const glm::mat3& normal, const glm::vec3& color, glm::vec4* texels) const {
+    glm::mat4 model = transform * m_PositionDequantize;
+
+    texels[0] = model[0];
+    texels[1] = model[1];
+    texels[2] = model[2];
+    texels[3] = model[3];
+    texels[4] = glm::vec4(normal[0], 0.0f);
+    texels[5] = glm::vec4(normal[1], 0.0f);
+    texels[6] = glm::vec4(normal[2], 0.0f);
+    texels[7] = glm::vec4(color, 1.0f);
 }
 
 void Model::End() const {
-    GL_CHECK(glBindVertexArray(0));
+    // The vertex array stays bound. Every bind goes through glState, so the next
+    // Begin only reaches GL if it needs a different one.
 }
 
 std::shared_ptr<Shader> Model::GetShader() const {
     return m_Shader;
 }
 
+GLuint Model::GetVertexArray() const {
+    return m_VAO;
+}
+
+GLsizei Model::GetIndexCount() const {
+    return m_Geometry.indexCount;
+}
+
+const GeometryAllocation& Model::GetGeometry() const {
+    return m_Geometry;
+}
+
+GLsizei Model::GetInstanceCount() const {
+    return m_instanceCount;
+}
+
+bool Model::IsInstanced() const {
+    return m_InstanceVBO != 0;
+}
+
+bool Model::UsesDrawData() const {
+    return m_DrawBaseUniform.IsValid();
+}
+
+Uniform<int> Model::GetDrawBaseUniform() const {
+    return m_DrawBaseUniform;
+}
+
+const AABB& Model::GetBounds() const {
+    return m_Bounds;
+}
+
+void Model::SetInstances(const std::vector<ModelInstance>& instances) {
+    SetInstances(instances.data(), instances.size());
+}
+
+void Model::SetInstances(const ModelInstance* instances, size_t count) {
+    if (m_InstanceVBO == 0) {
+        setupInstances();
+    }
+
+    glState.BindBuffer(GL_ARRAY_BUFFER, m_InstanceVBO);
+
+    if (count > m_instanceCapacity) {
+        m_instanceCapacity = std::max(count, m_instanceCapacity * 2);
+    }
+
+    // Orphan the previous store so rewriting it every frame does not stall on the last draw.
+    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity * sizeof(ModelInstance), nullptr, GL_STREAM_DRAW));
+    if (count > 0) {
+        GL_CHECK(glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(ModelInstance), instances));
+    }
+
+    glState.BindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_instanceCount = static_cast<GLsizei>(count);
+}
+
+void Model::SetInstanceCount(size_t count) {
+    m_instanceCount = static_cast<GLsizei>(count);
+}
+
 void Model::SetPosition(float x, float y, float z) {
     m_Position = glm::vec3(x, y, z);
+    m_MatrixDirty = true;
 }
 
 void Model::SetPosition(const glm::vec3& pos) {
     m_Position = glm::vec3(pos);
+    m_MatrixDirty = true;
 }
 
 glm::vec3 Model::GetPosition() const {
@@ -48,132 +206,143 @@ glm::vec3 Model::GetPosition() const {
 
 void Model::SetRotationDeg(float deg) {
     m_Rotation = glm::radians(deg);
+    m_MatrixDirty = true;
 }
 
 void Model::SetRotationRad(float rad) {
     m_Rotation = rad;
+    m_MatrixDirty = true;
 }
 
 void Model::SetRotationAxis(float x, float y, float z) {
     m_RotationAxis = glm::vec3(x, y, z);
+    m_MatrixDirty = true;
 }
 
 void Model::SetRotationAxis(const glm::vec3& axis) {
     m_RotationAxis = glm::vec3(axis);
+    m_MatrixDirty = true;
 }
 
 void Model::SetScale(float x, float y, float z) {
     m_Scale = glm::vec3(x, y, z);
+    m_MatrixDirty = true;
 }
 
 void Model::SetScale(const glm::vec3& scale) {
     m_Scale = glm::vec3(scale);
+    m_MatrixDirty = true;
 }
 
-glm::mat4 Model::GetMatrix() const {
-    glm::mat4 matrix(1.0f);
-    matrix = glm::translate(matrix, m_Position);
-    matrix = glm::rotate(matrix, m_Rotation, m_RotationAxis);
-    matrix = glm::scale(matrix, m_Scale);
+const glm::mat4& Model::GetMatrix() const {
+    if (m_MatrixDirty) {
+        m_Matrix = glm::mat4(1.0f);
+        m_Matrix = glm::translate(m_Matrix, m_Position);
+        m_Matrix = glm::rotate(m_Matrix, m_Rotation, m_RotationAxis);
+        m_Matrix = glm::scale(m_Matrix, m_Scale);
+        m_MatrixDirty = false;
+    }
 
-    return matrix;
+    return m_Matrix;
 }
 
-void Model::setupModel(const std::vector<float>& vertices, const std::vector<float>& normals, const std::vector<float>& colors, const std::vector<float>& texCoords) {
-    GLsizei stride = 3 * sizeof(float);
-
-    // Determine if the colors and texCoords exist.
-    bool hasNormals = !normals.empty();
-    bool hasColors = !colors.empty();
-    bool hasTexCoords = !texCoords.empty();
+void Model::setupUniforms() {
+    // MULTI_DRAW shaders have no per-draw uniforms but the draw base, the rest comes from the draw data.
+    if (m_Shader->HasUniform("uDrawData")) {
+        m_DrawBaseUniform = m_Shader->GetUniform<int>("uDrawBase");
 
-    if (hasNormals && normals.size() / 3 != vertices.size() / 3) {
-        std::cerr << "Error: Mismatch in vertex and normal data size!\n";
-        return;
+        m_Shader->Use();
+        m_Shader->Set(m_Shader->GetUniform<int>("uDrawData"), static_cast<int>(DRAW_DATA_TEXTURE_UNIT));
+    } else {
+        m_ModelUniform = m_Shader->GetUniform<glm::mat4>("uModel");
     }
 
-    if (hasColors && colors.size() / 3 != vertices.size() / 3) {
-        std::cerr << "Error: Mismatch in vertex and color data size!\n";
-        return;
+    // Material uniforms are optional, the light shader for instance has neither.
+    if (m_Shader->HasUniform("uNormal")) {
+        m_NormalUniform = m_Shader->GetUniform<glm::mat3>("uNormal");
     }
 
-    if (hasTexCoords && texCoords.size() / 2 != vertices.size() / 3) {
-        std::cerr << "Error: Mismatch in vertex and texture coordinates data size!\n";
-        return;
+    if (m_Shader->HasUniform("uObjectColor")) {
+        m_ColorUniform = m_Shader->GetUniform<glm::vec3>("uObjectColor");
     }
 
-    // Compute stride.
-    if (hasNormals) stride += 3 * sizeof(float);
-    if (hasColors) stride += 3 * sizeof(float);
-    if (hasTexCoords) stride += 2 * sizeof(float);
+    // Octahedral normals are decoded by the OCTAHEDRAL_NORMALS shader variant.
+    if (m_OctahedralNormals && !m_Shader->GetDefines().Has("OCTAHEDRAL_NORMALS")) {
+        std::cerr << "Error: Model has octahedral normals but its shader was not built with OCTAHEDRAL_NORMALS!\n";
+    }
+}
 
-    std::vector<float> interleavedData;
-    interleavedData.reserve(vertices.size() + (hasColors ? colors.size() : 0) + (hasTexCoords ? texCoords.size() : 0));
+void Model::setupInstances() {
+    // The vertex array of a pool page is shared, so the instance attributes go on a copy.
+    if (m_Pool && m_VAO == m_Geometry.vertexArray) {
+        m_VAO = m_Pool->CreateVertexArray(m_Geometry);
+    }
 
-    size_t numVertices = vertices.size() / 3;
-    for (size_t i = 0; i < numVertices; i++) {
-        interleavedData.push_back(vertices[i * 3]);
-        interleavedData.push_back(vertices[i * 3 + 1]);
-        interleavedData.push_back(vertices[i * 3 + 2]);
+    GL_CHECK(glGenBuffers(1, &m_InstanceVBO));
 
-        if (hasNormals) {
-            interleavedData.push_back(normals[i * 3]);
-            interleavedData.push_back(normals[i * 3 + 1]);
-            interleavedData.push_back(normals[i * 3 + 2]);
-        }
+    glState.BindVertexArray(m_VAO);
+    glState.BindBuffer(GL_ARRAY_BUFFER, m_InstanceVBO);
 
-        if (hasColors) {
-            interleavedData.push_back(colors[i * 3]);
-            interleavedData.push_back(colors[i * 3 + 1]);
-            interleavedData.push_back(colors[i * 3 + 2]);
-        }
+    GLsizei stride = sizeof(ModelInstance);
 
-        if (hasTexCoords) {
-            interleavedData.push_back(texCoords[i * 2]);
-            interleavedData.push_back(texCoords[i * 2 + 1]);
-        }
+    // A mat4 attribute is fed as four vec4 columns.
+    for (GLuint column = 0; column < 4; column++) {
+        size_t offset = offsetof(ModelInstance, transform) + column * sizeof(glm::vec4);
+        GL_CHECK(glVertexAttribPointer(INSTANCE_TRANSFORM_LOCATION + column, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offset)));
+        GL_CHECK(glEnableVertexAttribArray(INSTANCE_TRANSFORM_LOCATION + column));
+        GL_CHECK(glVertexAttribDivisor(INSTANCE_TRANSFORM_LOCATION + column, 1));
     }
 
-    // OpenGL buffer setup.
-    GL_CHECK(glGenVertexArrays(1, &m_VAO));
-    GL_CHECK(glBindVertexArray(m_VAO));
+    GL_CHECK(glVertexAttribPointer(INSTANCE_COLOR_LOCATION, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(ModelInstance, color))));
+    GL_CHECK(glEnableVertexAttribArray(INSTANCE_COLOR_LOCATION));
+    GL_CHECK(glVertexAttribDivisor(INSTANCE_COLOR_LOCATION, 1));
 
-    GL_CHECK(glGenBuffers(1, &m_VBO));
-    GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, m_VBO));
-    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, interleavedData.size() * sizeof(float), interleavedData.data(), GL_STATIC_DRAW));
+    glState.BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Model::setupModel(const MeshData& mesh, GeometryPool* pool) {
+    if (!mesh.IsValid()) {
+        std::cerr << "Error: Model created without mesh data!\n";
+        return;
+    }
 
-    // Set up vertex attribute pointers.
-    size_t offset = 0;
-    GLuint vertexArrayIndex = 0;
+    const VertexLayout& layout = mesh.layout;
+    const void* vertexData = mesh.vertexData;
+    size_t vertexBytes = mesh.vertexBytes;
 
-    GL_CHECK(glVertexAttribPointer(vertexArrayIndex, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offset)));
-    GL_CHECK(glEnableVertexAttribArray(vertexArrayIndex));
-    
-    offset += 3 * sizeof(float);
-    vertexArrayIndex += 1;
+    glm::vec3 positionScale(layout.positionScale[0], layout.positionScale[1], layout.positionScale[2]);
+    glm::vec3 positionOffset(layout.positionOffset[0], layout.positionOffset[1], layout.positionOffset[2]);
+    m_PositionDequantize = glm::scale(glm::translate(glm::mat4(1.0f), positionOffset), positionScale);
+    m_OctahedralNormals = (layout.flags & VERTEX_LAYOUT_OCTAHEDRAL_NORMALS) != 0;
 
-    if (hasNormals) {
-        GL_CHECK(glVertexAttribPointer(vertexArrayIndex, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offset)));
-        GL_CHECK(glEnableVertexAttribArray(vertexArrayIndex));
-        offset += 3 * sizeof(float);
-        vertexArrayIndex += 1;
-    }
+    std::vector<glm::vec3> positions;
+    ReadMeshPositions(mesh, positions);
 
-    if (hasColors) {
-        GL_CHECK(glVertexAttribPointer(vertexArrayIndex, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offset)));
-        GL_CHECK(glEnableVertexAttribArray(vertexArrayIndex));
-        offset += 3 * sizeof(float);
-        vertexArrayIndex += 1;
+    m_Bounds = AABB();
+    for (const glm::vec3& position : positions) {
+        m_Bounds.Expand(position);
     }
 
-    if (hasTexCoords) {
-        GL_CHECK(glVertexAttribPointer(vertexArrayIndex, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offset)));
-        GL_CHECK(glEnableVertexAttribArray(vertexArrayIndex));
+    if (pool) {
+        m_Geometry = pool->Acquire(mesh);
+        if (m_Geometry.IsValid()) {
+            m_Pool = pool;
+        }
+
+        m_VAO = m_Geometry.vertexArray;
+        return;
     }
 
-    std::cout << interleavedData.size() * sizeof(float) << " bytes of data used to create model\n";
+    size_t indexBytes = mesh.indexCount * GetIndexSize(mesh.indexType);
+
+    m_Geometry.indexCount = static_cast<GLsizei>(mesh.indexCount);
+    m_Geometry.indexType = mesh.indexType;
+
+    // OpenGL buffer setup. Data from a mesh file goes to the driver straight out
+    // of the mapping, without an intermediate copy.
+    CreateGeometryBuffers(layout, vertexBytes, vertexData, indexBytes, mesh.indexData, m_Geometry.vertexArray, m_Geometry.vertexBuffer, m_Geometry.indexBuffer);
+
+    std::cout << vertexBytes + indexBytes << " bytes of data used to create model\n";
 
-    // Clean up by undbinding the necessary buffers and objects.
-    GL_CHECK(glBindVertexArray(0));
-    GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    m_VAO = m_Geometry.vertexArray;
 }
\ No newline at end of file
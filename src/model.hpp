@@ -6,21 +6,81 @@
 #include <iostream>
 #include <vector>
 #include <memory>
+#include <cstddef>
 
 #include "utility.hpp"
 #include "shader.hpp"
+#include "mesh_data.hpp"
+#include "vertex_format.hpp"
+#include "bounds.hpp"
+#include "geometry_pool.hpp"
+
+// Attribute locations used by the per-instance data of DrawInstanced. The
+// transform is a mat4 and therefore takes four consecutive locations.
+constexpr GLuint INSTANCE_TRANSFORM_LOCATION = 4;
+constexpr GLuint INSTANCE_COLOR_LOCATION = 8;
+
+// Shaders built with MULTI_DRAW read their transform and color from a texture
+// buffer instead of uniforms, DRAW_DATA_TEXELS RGBA32F texels per draw: the
+// model matrix, the columns of the normal matrix and the color. See cube.vert.
+constexpr GLuint DRAW_DATA_TEXTURE_UNIT = 7;
+constexpr size_t DRAW_DATA_TEXELS = 8;
+
+// Data for one instance of an instanced draw. The transform is applied on top of
+// the model's own matrix, so it places a copy of the model in the world.
+struct ModelInstance {
+    glm::mat4 transform;
+    glm::vec4 color;
+};
 
 class Model {
 public:
-    Model(const std::vector<float>& vertices, const std::vector<float>& normals, const std::vector<float>& colors, const std::vector<float>& texCoords, const char* vertexPath, const char* fragmentPath);
-    Model(const std::vector<float>& vertices, const std::vector<float>& normals, const std::vector<float>& colors, const std::vector<float>& texCoords, std::shared_ptr<Shader> shader);
+    Model(const std::vector<float>& vertices, const std::vector<float>& normals, const std::vector<float>& colors, const std::vector<float>& texCoords, const char* vertexPath, const char* fragmentPath, const VertexFormat& format = VertexFormat());
+    Model(const std::vector<float>& vertices, const std::vector<float>& normals, const std::vector<float>& colors, const std::vector<float>& texCoords, std::shared_ptr<Shader> shader, const VertexFormat& format = VertexFormat());
+    Model(const char* meshPath, const char* vertexPath, const char* fragmentPath);
+    Model(const char* meshPath, std::shared_ptr<Shader> shader);
+    // With a pool the geometry is placed in the pool, and shared with any
+    // other model made from the same mesh. The pool has to outlive the model.
+    Model(const MeshData& mesh, std::shared_ptr<Shader> shader, GeometryPool* pool = nullptr);
     ~Model();
 
     void Begin() const;
-    void Draw(const glm::mat4& view, const glm::mat4& projection) const;
+    void Draw() const;
+    void DrawInstanced() const;
     void End() const;
 
+    // Draw with an explicit transform and material, assuming the VAO and program
+    // are already bound. Used by RenderQueue, which binds them once per batch.
+    void Draw(const glm::mat4& transform, const glm::vec3& color) const;
+    void Draw(const glm::mat4& transform, const glm::mat3& normal, const glm::vec3& color) const;
+    void DrawInstanced(const glm::mat4& transform) const;
+
+    // Draws with entry drawIndex of the bound draw data, for MULTI_DRAW shaders.
+    void DrawWithDrawData(GLint drawIndex) const;
+
+    // Writes the DRAW_DATA_TEXELS texels of a draw to texels.
+    void WriteDrawData(const glm::mat4& transform, const glm::mat3& normal, const glm::vec3& color, glm::vec4* texels) const;
+
     std::shared_ptr<Shader> GetShader() const;
+    GLuint GetVertexArray() const;
+    GLsizei GetIndexCount() const;
+    const GeometryAllocation& GetGeometry() const;
+    GLsizei GetInstanceCount() const;
+    bool IsInstanced() const;
+
+    // True for MULTI_DRAW shaders. The draw base uniform is the first entry of the draw data to use.
+    bool UsesDrawData() const;
+    Uniform<int> GetDrawBaseUniform() const;
+
+    // Object space bounds of the vertex positions, before GetMatrix is applied.
+    const AABB& GetBounds() const;
+
+    void SetInstances(const std::vector<ModelInstance>& instances);
+    void SetInstances(const ModelInstance* instances, size_t count);
+
+    // Draws count instances without an instance buffer, for shaders that fetch
+    // their per-instance data themselves.
+    void SetInstanceCount(size_t count);
 
     void SetPosition(float x, float y, float z);
     void SetPosition(const glm::vec3& pos);
@@ -36,18 +96,40 @@ public:
     void SetScale(float x, float y, float z);
     void SetScale(const glm::vec3& scale);
 
-    glm::mat4 GetMatrix() const;
+    // Rebuilt only after one of the setters above was called.
+    const glm::mat4& GetMatrix() const;
 
 private:
-    GLuint m_VAO, m_VBO;
-    GLsizei m_indexCount;
+    // Usually the vertex array of the geometry, instanced pooled models get one of their own.
+    GLuint m_VAO;
+    GeometryPool* m_Pool;
+    GeometryAllocation m_Geometry;
+
+    GLuint m_InstanceVBO;
+    size_t m_instanceCapacity;
+    GLsizei m_instanceCount;
     
     std::shared_ptr<Shader> m_Shader;
+    Uniform<glm::mat4> m_ModelUniform;
+    Uniform<glm::mat3> m_NormalUniform;
+    Uniform<glm::vec3> m_ColorUniform;
+    Uniform<int> m_DrawBaseUniform;
+
+    // Maps quantized positions back to object space. Identity for float positions.
+    glm::mat4 m_PositionDequantize;
+    bool m_OctahedralNormals;
+
+    AABB m_Bounds;
 
     glm::vec3 m_Position;
     float m_Rotation;
     glm::vec3 m_RotationAxis;
     glm::vec3 m_Scale;
 
-    void setupModel(const std::vector<float>& vertices, const std::vector<float>& normals, const std::vector<float>& colors, const std::vector<float>& texCoords);
+    mutable glm::mat4 m_Matrix;
+    mutable bool m_MatrixDirty;
+
+    void setupUniforms();
+    void setupInstances();
+    void setupModel(const MeshData& mesh, GeometryPool* pool = nullptr);
 };
\ No newline at end of file
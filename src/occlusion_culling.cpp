@@ -0,0 +1,420 @@
+#include "occlusion_culling.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Boxes are tested on the pool in groups of this many.
+constexpr size_t OCCLUSION_BATCH_SIZE = 1024;
+
+constexpr int OCCLUSION_TILE_PIXELS = OCCLUSION_TILE_SIZE * OCCLUSION_TILE_SIZE;
+
+bool BuildOccluderMesh(const MeshData& mesh, OccluderMesh& occluder) {
+    ReadMeshPositions(mesh, occluder.positions);
+    ReadMeshIndices(mesh, occluder.indices);
+
+    return !occluder.positions.empty() && !occluder.indices.empty();
+}
+
+OccluderMesh MakeBoxOccluder(const AABB& box) {
+    OccluderMesh occluder;
+
+    for (int i = 0; i < 8; i++) {
+        occluder.positions.emplace_back(i & 1 ? box.maximum.x : box.minimum.x, i & 2 ? box.maximum.y : box.minimum.y, i & 4 ? box.maximum.z : box.minimum.z);
+    }
+
+    // Two triangles per face. The winding does not matter, both sides are rasterized.
+    occluder.indices = {
+        0, 1, 3, 0, 3, 2,   // -z
+        4, 6, 7, 4, 7, 5,   // +z
+        0, 4, 5, 0, 5, 1,   // -y
+        2, 3, 7, 2, 7, 6,   // +y
+        0, 2, 6, 0, 6, 4,   // -x
+        1, 5, 7, 1, 7, 3,   // +x
+    };
+
+    return occluder;
+}
+
+OcclusionCuller::OcclusionCuller(int width, int height) : m_ViewProjection(1.0f) {
+    m_TilesX = std::max(1, (width + OCCLUSION_TILE_SIZE - 1) / OCCLUSION_TILE_SIZE);
+    m_TilesY = std::max(1, (height + OCCLUSION_TILE_SIZE - 1) / OCCLUSION_TILE_SIZE);
+    m_Width = m_TilesX * OCCLUSION_TILE_SIZE;
+    m_Height = m_TilesY * OCCLUSION_TILE_SIZE;
+
+    m_Depth.assign(static_cast<size_t>(m_Width) * static_cast<size_t>(m_Height), 1.0f);
+    m_TileMaxDepth.assign(static_cast<size_t>(m_TilesX * m_TilesY), 1.0f);
+    m_Bins.resize(static_cast<size_t>(m_TilesX * m_TilesY));
+}
+
+void OcclusionCuller::Begin(const glm::mat4& viewProjection) {
+    m_ViewProjection = viewProjection;
+
+    std::fill(m_Depth.begin(), m_Depth.end(), 1.0f);
+    std::fill(m_TileMaxDepth.begin(), m_TileMaxDepth.end(), 1.0f);
+
+    m_Triangles.clear();
+    for (std::vector<uint32_t>& bin : m_Bins) {
+        bin.clear();
+    }
+
+    m_Stats = OcclusionStats();
+}
+
+void OcclusionCuller::AddOccluder(const OccluderMesh& occluder, const glm::mat4& transform) {
+    glm::mat4 matrix = m_ViewProjection * transform;
+
+    std::vector<glm::vec4> clip(occluder.positions.size());
+    for (size_t i = 0; i < clip.size(); i++) {
+        clip[i] = matrix * glm::vec4(occluder.positions[i], 1.0f);
+    }
+
+    m_Stats.occluders++;
+
+    for (size_t i = 0; i + 2 < occluder.indices.size(); i += 3) {
+        glm::vec4 vertices[3] = { clip[occluder.indices[i]], clip[occluder.indices[i + 1]], clip[occluder.indices[i + 2]] };
+
+        // Entirely outside one of the side planes.
+        bool outside = false;
+        for (int axis = 0; axis < 2 && !outside; axis++) {
+            outside = (vertices[0][axis] > vertices[0].w && vertices[1][axis] > vertices[1].w && vertices[2][axis] > vertices[2].w) ||
+                      (vertices[0][axis] < -vertices[0].w && vertices[1][axis] < -vertices[1].w && vertices[2][axis] < -vertices[2].w);
+        }
+
+        if (outside) {
+            continue;
+        }
+
+        // Only the near plane is clipped against, it keeps w positive. Everything
+        // else is left to the per tile bounds and the depth range.
+        glm::vec4 polygon[4];
+        int polygonSize = 0;
+
+        for (int v = 0; v < 3; v++) {
+            const glm::vec4& current = vertices[v];
+            const glm::vec4& next = vertices[(v + 1) % 3];
+            float currentDistance = current.z + current.w;
+            float nextDistance = next.z + next.w;
+
+            if (currentDistance >= 0.0f) {
+                polygon[polygonSize++] = current;
+            }
+
+            if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f)) {
+                float t = currentDistance / (currentDistance - nextDistance);
+                polygon[polygonSize++] = current + (next - current) * t;
+            }
+        }
+
+        for (int v = 1; v + 1 < polygonSize; v++) {
+            addTriangle(polygon[0], polygon[v], polygon[v + 1]);
+        }
+    }
+}
+
+void OcclusionCuller::Rasterize(ThreadPool* pool) {
+    int tileCount = m_TilesX * m_TilesY;
+
+    for (int tile = 0; tile < tileCount; tile++) {
+        if (m_Bins[tile].empty()) {
+            continue;
+        }
+
+        if (pool == nullptr) {
+            rasterizeTile(tile);
+        } else {
+            pool->Submit([this, tile]() { rasterizeTile(tile); });
+        }
+    }
+
+    if (pool != nullptr) {
+        pool->Wait();
+    }
+}
+
+bool OcclusionCuller::IsVisible(const AABB& worldBounds) const {
+    if (worldBounds.IsEmpty()) {
+        return true;
+    }
+
+    glm::vec3 screenMin(FLT_MAX);
+    glm::vec3 screenMax(-FLT_MAX);
+
+    for (int i = 0; i < 8; i++) {
+        glm::vec3 corner(i & 1 ? worldBounds.maximum.x : worldBounds.minimum.x, i & 2 ? worldBounds.maximum.y : worldBounds.minimum.y, i & 4 ? worldBounds.maximum.z : worldBounds.minimum.z);
+        glm::vec4 clip = m_ViewProjection * glm::vec4(corner, 1.0f);
+
+        // Reaches past the near plane, there is no sensible screen rectangle.
+        if (clip.z + clip.w < 0.0f || clip.w <= 0.0f) {
+            return true;
+        }
+
+        glm::vec3 screen((clip.x / clip.w * 0.5f + 0.5f) * static_cast<float>(m_Width), (clip.y / clip.w * 0.5f + 0.5f) * static_cast<float>(m_Height), clip.z / clip.w * 0.5f + 0.5f);
+        screenMin = glm::min(screenMin, screen);
+        screenMax = glm::max(screenMax, screen);
+    }
+
+    // Every pixel the rectangle touches, clamped to the buffer. Off screen
+    // boxes are left to frustum culling.
+    int minX = std::max(0, static_cast<int>(std::floor(screenMin.x)));
+    int minY = std::max(0, static_cast<int>(std::floor(screenMin.y)));
+    int maxX = std::min(m_Width - 1, static_cast<int>(std::floor(screenMax.x)));
+    int maxY = std::min(m_Height - 1, static_cast<int>(std::floor(screenMax.y)));
+
+    if (minX > maxX || minY > maxY) {
+        return true;
+    }
+
+    return testRect(minX, minY, maxX, maxY, screenMin.z - OCCLUSION_DEPTH_BIAS);
+}
+
+void OcclusionCuller::Cull(const AABB* worldBounds, std::vector<uint32_t>& objects, ThreadPool* pool) {
+    size_t count = objects.size();
+    m_Visible.resize(count);
+
+    auto test = [this, worldBounds, &objects](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            m_Visible[i] = IsVisible(worldBounds[objects[i]]) ? 1 : 0;
+        }
+    };
+
+    if (pool == nullptr || count <= OCCLUSION_BATCH_SIZE) {
+        test(0, count);
+    } else {
+        for (size_t begin = 0; begin < count; begin += OCCLUSION_BATCH_SIZE) {
+            size_t end = std::min(count, begin + OCCLUSION_BATCH_SIZE);
+            pool->Submit([&test, begin, end]() { test(begin, end); });
+        }
+
+        pool->Wait();
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (m_Visible[i]) {
+            objects[kept++] = objects[i];
+        }
+    }
+
+    objects.resize(kept);
+
+    m_Stats.tested += count;
+    m_Stats.occluded += count - kept;
+}
+
+int OcclusionCuller::GetWidth() const {
+    return m_Width;
+}
+
+int OcclusionCuller::GetHeight() const {
+    return m_Height;
+}
+
+float OcclusionCuller::GetDepth(int x, int y) const {
+    int tile = (y / OCCLUSION_TILE_SIZE) * m_TilesX + x / OCCLUSION_TILE_SIZE;
+    return m_Depth[static_cast<size_t>(tile) * OCCLUSION_TILE_PIXELS + (y % OCCLUSION_TILE_SIZE) * OCCLUSION_TILE_SIZE + x % OCCLUSION_TILE_SIZE];
+}
+
+const OcclusionStats& OcclusionCuller::GetStats() const {
+    return m_Stats;
+}
+
+void OcclusionCuller::addTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c) {
+    ScreenTriangle triangle;
+    const glm::vec4* vertices[3] = { &a, &b, &c };
+
+    for (int v = 0; v < 3; v++) {
+        const glm::vec4& vertex = *vertices[v];
+        triangle.x[v] = (vertex.x / vertex.w * 0.5f + 0.5f) * static_cast<float>(m_Width);
+        triangle.y[v] = (vertex.y / vertex.w * 0.5f + 0.5f) * static_cast<float>(m_Height);
+        triangle.z[v] = vertex.z / vertex.w * 0.5f + 0.5f;
+    }
+
+    float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) - (triangle.y[1] - triangle.y[0]) * (triangle.x[2] - triangle.x[0]);
+    if (std::abs(area) < 1e-6f) {
+        return;
+    }
+
+    // Counter-clockwise from here on, so inside is where all edge functions are positive.
+    if (area < 0.0f) {
+        std::swap(triangle.x[1], triangle.x[2]);
+        std::swap(triangle.y[1], triangle.y[2]);
+        std::swap(triangle.z[1], triangle.z[2]);
+    }
+
+    float minX = std::min({ triangle.x[0], triangle.x[1], triangle.x[2] });
+    float maxX = std::max({ triangle.x[0], triangle.x[1], triangle.x[2] });
+    float minY = std::min({ triangle.y[0], triangle.y[1], triangle.y[2] });
+    float maxY = std::max({ triangle.y[0], triangle.y[1], triangle.y[2] });
+
+    int tileMinX = std::max(0, static_cast<int>(std::floor(minX)) / OCCLUSION_TILE_SIZE);
+    int tileMinY = std::max(0, static_cast<int>(std::floor(minY)) / OCCLUSION_TILE_SIZE);
+    int tileMaxX = std::min(m_TilesX - 1, static_cast<int>(std::floor(maxX)) / OCCLUSION_TILE_SIZE);
+    int tileMaxY = std::min(m_TilesY - 1, static_cast<int>(std::floor(maxY)) / OCCLUSION_TILE_SIZE);
+
+    if (maxX < 0.0f || maxY < 0.0f || tileMinX > tileMaxX || tileMinY > tileMaxY) {
+        return;
+    }
+
+    uint32_t index = static_cast<uint32_t>(m_Triangles.size());
+    m_Triangles.push_back(triangle);
+    m_Stats.triangles++;
+
+    for (int ty = tileMinY; ty <= tileMaxY; ty++) {
+        for (int tx = tileMinX; tx <= tileMaxX; tx++) {
+            m_Bins[ty * m_TilesX + tx].push_back(index);
+        }
+    }
+}
+
+void OcclusionCuller::rasterizeTile(int tile) {
+    int originX = (tile % m_TilesX) * OCCLUSION_TILE_SIZE;
+    int originY = (tile / m_TilesX) * OCCLUSION_TILE_SIZE;
+    float* depth = &m_Depth[static_cast<size_t>(tile) * OCCLUSION_TILE_PIXELS];
+
+    for (uint32_t index : m_Bins[tile]) {
+        const ScreenTriangle& triangle = m_Triangles[index];
+
+        // Edge i runs from vertex i to the next one, E(x, y) = A * x + B * y + C.
+        float edgeA[3], edgeB[3], edgeC[3];
+        for (int e = 0; e < 3; e++) {
+            int next = (e + 1) % 3;
+            edgeA[e] = triangle.y[e] - triangle.y[next];
+            edgeB[e] = triangle.x[next] - triangle.x[e];
+            edgeC[e] = -(edgeA[e] * triangle.x[e] + edgeB[e] * triangle.y[e]);
+        }
+
+        float dx1 = triangle.x[1] - triangle.x[0], dy1 = triangle.y[1] - triangle.y[0];
+        float dx2 = triangle.x[2] - triangle.x[0], dy2 = triangle.y[2] - triangle.y[0];
+        float dz1 = triangle.z[1] - triangle.z[0], dz2 = triangle.z[2] - triangle.z[0];
+        float area = dx1 * dy2 - dy1 * dx2;
+
+        float dzdx = (dz1 * dy2 - dz2 * dy1) / area;
+        float dzdy = (dz2 * dx1 - dz1 * dx2) / area;
+
+        // Depth is taken at the far corner of each pixel, never past the farthest vertex.
+        float zOffset = triangle.z[0] - dzdx * triangle.x[0] - dzdy * triangle.y[0] + 0.5f * (std::abs(dzdx) + std::abs(dzdy));
+        float zMax = std::max({ triangle.z[0], triangle.z[1], triangle.z[2] });
+
+        int minX = std::max(originX, static_cast<int>(std::floor(std::min({ triangle.x[0], triangle.x[1], triangle.x[2] }))));
+        int maxX = std::min(originX + OCCLUSION_TILE_SIZE - 1, static_cast<int>(std::floor(std::max({ triangle.x[0], triangle.x[1], triangle.x[2] }))));
+        int minY = std::max(originY, static_cast<int>(std::floor(std::min({ triangle.y[0], triangle.y[1], triangle.y[2] }))));
+        int maxY = std::min(originY + OCCLUSION_TILE_SIZE - 1, static_cast<int>(std::floor(std::max({ triangle.y[0], triangle.y[1], triangle.y[2] }))));
+
+        // Blocks of four start on a multiple of four, which tiles always are.
+        minX &= ~3;
+
+        for (int y = minY; y <= maxY; y++) {
+            float* row = depth + (y - originY) * OCCLUSION_TILE_SIZE - originX;
+            float centerY = static_cast<float>(y) + 0.5f;
+
+#ifdef __SSE2__
+            __m128 rowEdge[3];
+            __m128 stepA[3];
+            for (int e = 0; e < 3; e++) {
+                rowEdge[e] = _mm_set1_ps(edgeB[e] * centerY + edgeC[e]);
+                stepA[e] = _mm_set1_ps(edgeA[e]);
+            }
+
+            __m128 rowDepth = _mm_set1_ps(dzdy * centerY + zOffset);
+            __m128 depthStep = _mm_set1_ps(dzdx);
+            __m128 farthest = _mm_set1_ps(zMax);
+            __m128 zero = _mm_setzero_ps();
+
+            for (int x = minX; x <= maxX; x += 4) {
+                float base = static_cast<float>(x) + 0.5f;
+                __m128 centerX = _mm_add_ps(_mm_set1_ps(base), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+
+                __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(stepA[0], centerX), rowEdge[0]), zero);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(stepA[1], centerX), rowEdge[1]), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(stepA[2], centerX), rowEdge[2]), zero));
+
+                if (_mm_movemask_ps(inside) == 0) {
+                    continue;
+                }
+
+                __m128 z = _mm_min_ps(_mm_add_ps(_mm_mul_ps(depthStep, centerX), rowDepth), farthest);
+                __m128 current = _mm_loadu_ps(row + x);
+                __m128 nearest = _mm_min_ps(current, z);
+
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+            }
+#else
+            for (int x = minX; x <= maxX; x++) {
+                float centerX = static_cast<float>(x) + 0.5f;
+
+                bool inside = true;
+                for (int e = 0; e < 3; e++) {
+                    inside = inside && edgeA[e] * centerX + edgeB[e] * centerY + edgeC[e] >= 0.0f;
+                }
+
+                if (inside) {
+                    float z = std::min(dzdx * centerX + dzdy * centerY + zOffset, zMax);
+                    row[x] = std::min(row[x], z);
+                }
+            }
+#endif
+        }
+    }
+
+    float tileMax = 0.0f;
+    for (int i = 0; i < OCCLUSION_TILE_PIXELS; i++) {
+        tileMax = std::max(tileMax, depth[i]);
+    }
+
+    m_TileMaxDepth[tile] = tileMax;
+}
+
+bool OcclusionCuller::testRect(int minX, int minY, int maxX, int maxY, float depth) const {
+    for (int ty = minY / OCCLUSION_TILE_SIZE; ty <= maxY / OCCLUSION_TILE_SIZE; ty++) {
+        for (int tx = minX / OCCLUSION_TILE_SIZE; tx <= maxX / OCCLUSION_TILE_SIZE; tx++) {
+            int tile = ty * m_TilesX + tx;
+
+            // Behind everything in the tile.
+            if (depth > m_TileMaxDepth[tile]) {
+                continue;
+            }
+
+            int originX = tx * OCCLUSION_TILE_SIZE;
+            int originY = ty * OCCLUSION_TILE_SIZE;
+            int x0 = std::max(minX, originX), x1 = std::min(maxX, originX + OCCLUSION_TILE_SIZE - 1);
+            int y0 = std::max(minY, originY), y1 = std::min(maxY, originY + OCCLUSION_TILE_SIZE - 1);
+
+            const float* pixels = &m_Depth[static_cast<size_t>(tile) * OCCLUSION_TILE_PIXELS];
+
+            for (int y = y0; y <= y1; y++) {
+                const float* row = pixels + (y - originY) * OCCLUSION_TILE_SIZE - originX;
+
+#ifdef __SSE2__
+                __m128 boxDepth = _mm_set1_ps(depth);
+
+                for (int x = x0 & ~3; x <= x1; x += 4) {
+                    // Lanes outside [x0, x1] belong to the tile but not to the rectangle.
+                    int lanes = 0xF;
+                    if (x < x0) {
+                        lanes &= 0xF << (x0 - x);
+                    }
+                    if (x + 3 > x1) {
+                        lanes &= 0xF >> (x + 3 - x1);
+                    }
+
+                    if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), boxDepth)) & lanes) {
+                        return true;
+                    }
+                }
+#else
+                for (int x = x0; x <= x1; x++) {
+                    if (row[x] >= depth) {
+                        return true;
+                    }
+                }
+#endif
+            }
+        }
+    }
+
+    return false;
+}
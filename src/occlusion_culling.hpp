@@ -0,0 +1,103 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bounds.hpp"
+#include "mesh_data.hpp"
+#include "thread_pool.hpp"
+
+// The depth buffer is split into square tiles that are rasterized and tested
+// independently. A tile row is a multiple of four so SIMD never straddles tiles.
+constexpr int OCCLUSION_TILE_SIZE = 32;
+constexpr int OCCLUSION_BUFFER_WIDTH = 256;
+constexpr int OCCLUSION_BUFFER_HEIGHT = 128;
+
+// Added to the nearest depth of a tested box, so an occluder is never hidden by its own depth.
+constexpr float OCCLUSION_DEPTH_BIAS = 1e-4f;
+
+// Triangles of an occluder in object space. Occluders only have to be roughly
+// the shape of what they stand for, as long as they do not stick out of it.
+struct OccluderMesh {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+};
+
+bool BuildOccluderMesh(const MeshData& mesh, OccluderMesh& occluder);
+
+// The twelve triangles of box.
+OccluderMesh MakeBoxOccluder(const AABB& box);
+
+struct OcclusionStats {
+    size_t occluders = 0;
+    size_t triangles = 0;
+    size_t tested = 0;
+    size_t occluded = 0;
+};
+
+// Software occlusion culling on a small depth buffer. A few large occluders
+// are rasterized on the CPU, then the screen space bounds of other objects are
+// tested against the result, so objects behind the occluders never reach the
+// render queue. Nothing here touches GL.
+//
+// Depth is stored as window depth in [0, 1], with every pixel holding the
+// farthest depth of the occluder covering it, so the test stays conservative.
+// Each tile also keeps its farthest depth, which lets most boxes be accepted
+// or rejected per tile instead of per pixel.
+class OcclusionCuller {
+public:
+    // width and height are rounded up to whole tiles.
+    OcclusionCuller(int width = OCCLUSION_BUFFER_WIDTH, int height = OCCLUSION_BUFFER_HEIGHT);
+
+    // Clears the depth buffer and the occluders of the previous frame.
+    void Begin(const glm::mat4& viewProjection);
+
+    // Transforms, clips and bins the triangles of occluder. Call between Begin and Rasterize.
+    void AddOccluder(const OccluderMesh& occluder, const glm::mat4& transform);
+
+    // Fills the depth buffer, one tile per job when a pool is given.
+    void Rasterize(ThreadPool* pool = nullptr);
+
+    // True unless worldBounds is entirely behind the rasterized occluders.
+    bool IsVisible(const AABB& worldBounds) const;
+
+    // Removes the objects that are occluded from objects, keeping the order
+    // of the others. worldBounds is indexed by the ids in objects.
+    void Cull(const AABB* worldBounds, std::vector<uint32_t>& objects, ThreadPool* pool = nullptr);
+
+    int GetWidth() const;
+    int GetHeight() const;
+
+    // Depth of pixel x, y counted from the bottom left corner.
+    float GetDepth(int x, int y) const;
+
+    const OcclusionStats& GetStats() const;
+
+private:
+    struct ScreenTriangle {
+        float x[3], y[3], z[3];
+    };
+
+    int m_Width, m_Height;
+    int m_TilesX, m_TilesY;
+
+    // Tile after tile, row after row within a tile.
+    std::vector<float> m_Depth;
+    std::vector<float> m_TileMaxDepth;
+
+    glm::mat4 m_ViewProjection;
+
+    std::vector<ScreenTriangle> m_Triangles;
+    std::vector<std::vector<uint32_t>> m_Bins;
+
+    std::vector<uint8_t> m_Visible;
+
+    OcclusionStats m_Stats;
+
+    void addTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+    void rasterizeTile(int tile);
+    bool testRect(int minX, int minY, int maxX, int maxY, float depth) const;
+};
@@ -0,0 +1,306 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <map>
+
+// Name used for the whole frame in the statistics and the trace.
+static const char* FRAME_SCOPE_NAME = "Frame";
+
+void Profiler::History::Add(double sample) {
+    if (samples.size() < PROFILER_HISTORY) {
+        samples.push_back(sample);
+    } else {
+        samples[next] = sample;
+    }
+
+    next = (next + 1) % PROFILER_HISTORY;
+}
+
+ProfileStats Profiler::History::Compute() const {
+    std::vector<double> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum = 0.0;
+    for (double sample : sorted) {
+        sum += sample;
+    }
+
+    size_t p99 = static_cast<size_t>(std::ceil(0.99 * static_cast<double>(sorted.size())));
+    p99 = std::min(std::max<size_t>(p99, 1), sorted.size()) - 1;
+
+    return ProfileStats{ sorted.front(), sum / static_cast<double>(sorted.size()), sorted[p99] };
+}
+
+Profiler::Profiler() : m_Start(Clock::now()), m_GPU(false), m_FrameIndex(0), m_Capturing(false) {}
+
+Profiler::~Profiler() {
+    if (!m_GPU) {
+        return;
+    }
+
+    for (FrameRecord& frame : m_Frames) {
+        if (!frame.queries.empty()) {
+            GL_CHECK(glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data()));
+        }
+
+        GL_CHECK(glDeleteQueries(1, &frame.frameQuery));
+    }
+}
+
+void Profiler::InitGPU() {
+    if (m_GPU) {
+        return;
+    }
+
+    for (FrameRecord& frame : m_Frames) {
+        GL_CHECK(glGenQueries(1, &frame.frameQuery));
+    }
+
+    m_GPU = true;
+}
+
+void Profiler::BeginFrame() {
+    m_FrameIndex++;
+    FrameRecord& frame = m_Frames[m_FrameIndex % PROFILER_FRAME_LATENCY];
+
+    // This slot was last used PROFILER_FRAME_LATENCY frames ago, so its queries should be done by now.
+    if (frame.pending) {
+        resolve(frame);
+    }
+
+    frame.scopes.clear();
+    frame.queriesUsed = 0;
+    frame.cpuBegin = now();
+    frame.pending = true;
+
+    if (m_GPU) {
+        // GL_TIMESTAMP queried directly does not wait for the GPU, it is only used to line the GPU clock up with the CPU one.
+        GLint64 gpuNow = 0;
+        GL_CHECK(glGetInteger64v(GL_TIMESTAMP, &gpuNow));
+        frame.gpuOffset = frame.cpuBegin - static_cast<int64_t>(gpuNow);
+
+        GL_CHECK(glBeginQuery(GL_TIME_ELAPSED, frame.frameQuery));
+    }
+}
+
+void Profiler::EndFrame() {
+    FrameRecord& frame = m_Frames[m_FrameIndex % PROFILER_FRAME_LATENCY];
+
+    if (!m_OpenScopes.empty()) {
+        std::cerr << "Error: Profiler frame ended with " << m_OpenScopes.size() << " open scopes!\n";
+
+        while (!m_OpenScopes.empty()) {
+            EndScope();
+        }
+    }
+
+    if (m_GPU) {
+        GL_CHECK(glEndQuery(GL_TIME_ELAPSED));
+    }
+
+    frame.cpuEnd = now();
+}
+
+void Profiler::BeginScope(const char* name) {
+    FrameRecord& frame = m_Frames[m_FrameIndex % PROFILER_FRAME_LATENCY];
+
+    ScopeRecord scope;
+    scope.name = name;
+    scope.depth = static_cast<uint32_t>(m_OpenScopes.size());
+    scope.cpuBegin = now();
+    scope.cpuEnd = scope.cpuBegin;
+    scope.gpuBegin = m_GPU ? issueTimestamp(frame) : 0;
+    scope.gpuEnd = scope.gpuBegin;
+
+    m_OpenScopes.push_back(frame.scopes.size());
+    frame.scopes.push_back(scope);
+}
+
+void Profiler::EndScope() {
+    if (m_OpenScopes.empty()) {
+        std::cerr << "Error: Profiler scope ended without being started!\n";
+        return;
+    }
+
+    FrameRecord& frame = m_Frames[m_FrameIndex % PROFILER_FRAME_LATENCY];
+    ScopeRecord& scope = frame.scopes[m_OpenScopes.back()];
+    m_OpenScopes.pop_back();
+
+    if (m_GPU) {
+        scope.gpuEnd = issueTimestamp(frame);
+    }
+
+    scope.cpuEnd = now();
+}
+
+void Profiler::StartCapture() {
+    m_Trace.clear();
+    m_Capturing = true;
+}
+
+bool Profiler::IsCapturing() const {
+    return m_Capturing;
+}
+
+static void writeJSONString(std::ostream& out, const std::string& text) {
+    out << '"';
+
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\';
+        }
+
+        out << c;
+    }
+
+    out << '"';
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path) {
+    m_Capturing = false;
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: Failed to open " << path << " to write the profiler trace!\n";
+        return false;
+    }
+
+    // Timestamps are in microseconds. CPU and GPU scopes go on separate tracks.
+    file << "{\"traceEvents\":[\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+
+    file << std::fixed << std::setprecision(3);
+
+    for (const TraceEvent& event : m_Trace) {
+        int tid = std::string(event.category) == "gpu" ? 2 : 1;
+
+        file << ",\n{\"name\":";
+        writeJSONString(file, event.name);
+        file << ",\"cat\":\"" << event.category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid;
+        file << ",\"ts\":" << static_cast<double>(event.begin) / 1000.0;
+        file << ",\"dur\":" << static_cast<double>(event.duration) / 1000.0 << "}";
+    }
+
+    file << "\n]}\n";
+
+    std::cout << "Wrote " << m_Trace.size() << " profiler events to " << path << std::endl;
+    m_Trace.clear();
+
+    return file.good();
+}
+
+void Profiler::PrintStats() const {
+    std::map<std::string, const History*> cpu;
+    for (const auto& entry : m_CPUHistory) {
+        cpu[entry.first] = &entry.second;
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Scope                    CPU min / avg / p99 (ms)      GPU min / avg / p99 (ms)\n";
+
+    for (const auto& entry : cpu) {
+        ProfileStats stats = entry.second->Compute();
+        std::cout << std::left << std::setw(24) << entry.first << std::right;
+        std::cout << std::setw(8) << stats.minimum << std::setw(8) << stats.average << std::setw(8) << stats.p99;
+
+        ProfileStats gpu;
+        if (GetGPUStats(entry.first, gpu)) {
+            std::cout << "      " << std::setw(8) << gpu.minimum << std::setw(8) << gpu.average << std::setw(8) << gpu.p99;
+        }
+
+        std::cout << "\n";
+    }
+
+    std::cout << std::defaultfloat << std::flush;
+}
+
+bool Profiler::GetCPUStats(const std::string& name, ProfileStats& stats) const {
+    auto it = m_CPUHistory.find(name);
+    if (it == m_CPUHistory.end() || it->second.samples.empty()) {
+        return false;
+    }
+
+    stats = it->second.Compute();
+    return true;
+}
+
+bool Profiler::GetGPUStats(const std::string& name, ProfileStats& stats) const {
+    auto it = m_GPUHistory.find(name);
+    if (it == m_GPUHistory.end() || it->second.samples.empty()) {
+        return false;
+    }
+
+    stats = it->second.Compute();
+    return true;
+}
+
+int64_t Profiler::now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_Start).count();
+}
+
+uint32_t Profiler::issueTimestamp(FrameRecord& frame) {
+    if (frame.queriesUsed == frame.queries.size()) {
+        GLuint query = 0;
+        GL_CHECK(glGenQueries(1, &query));
+        frame.queries.push_back(query);
+    }
+
+    GLuint index = static_cast<GLuint>(frame.queriesUsed++);
+    GL_CHECK(glQueryCounter(frame.queries[index], GL_TIMESTAMP));
+
+    return index;
+}
+
+void Profiler::resolve(FrameRecord& frame) {
+    frame.pending = false;
+
+    m_CPUHistory[FRAME_SCOPE_NAME].Add(static_cast<double>(frame.cpuEnd - frame.cpuBegin) * 1e-6);
+    addTraceEvent(FRAME_SCOPE_NAME, "cpu", frame.cpuBegin, frame.cpuEnd);
+
+    for (const ScopeRecord& scope : frame.scopes) {
+        m_CPUHistory[scope.name].Add(static_cast<double>(scope.cpuEnd - scope.cpuBegin) * 1e-6);
+        addTraceEvent(scope.name, "cpu", scope.cpuBegin, scope.cpuEnd);
+    }
+
+    if (!m_GPU) {
+        return;
+    }
+
+    // The frame query ends after every timestamp of the frame, so once it is
+    // available the rest are too. If not, the GPU is more than
+    // PROFILER_FRAME_LATENCY frames behind and the GPU times are skipped.
+    GLint available = 0;
+    GL_CHECK(glGetQueryObjectiv(frame.frameQuery, GL_QUERY_RESULT_AVAILABLE, &available));
+    if (!available) {
+        return;
+    }
+
+    GLuint64 elapsed = 0;
+    GL_CHECK(glGetQueryObjectui64v(frame.frameQuery, GL_QUERY_RESULT, &elapsed));
+    m_GPUHistory[FRAME_SCOPE_NAME].Add(static_cast<double>(elapsed) * 1e-6);
+
+    std::vector<GLuint64> timestamps(frame.queriesUsed);
+    for (size_t i = 0; i < frame.queriesUsed; i++) {
+        GL_CHECK(glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &timestamps[i]));
+    }
+
+    for (const ScopeRecord& scope : frame.scopes) {
+        int64_t begin = static_cast<int64_t>(timestamps[scope.gpuBegin]) + frame.gpuOffset;
+        int64_t end = static_cast<int64_t>(timestamps[scope.gpuEnd]) + frame.gpuOffset;
+
+        m_GPUHistory[scope.name].Add(static_cast<double>(end - begin) * 1e-6);
+        addTraceEvent(scope.name, "gpu", begin, end);
+    }
+}
+
+void Profiler::addTraceEvent(const char* name, const char* category, int64_t begin, int64_t end) {
+    if (!m_Capturing || m_Trace.size() >= PROFILER_MAX_TRACE_EVENTS) {
+        return;
+    }
+
+    m_Trace.push_back(TraceEvent{ name, category, begin, end - begin });
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utility.hpp"
+
+// Frames between issuing a GPU query and reading it back. Results that are
+// still not available after this many frames are dropped rather than waited on.
+constexpr size_t PROFILER_FRAME_LATENCY = 4;
+
+// Samples kept per scope for the rolling statistics.
+constexpr size_t PROFILER_HISTORY = 240;
+
+// Trace events kept while capturing, so a forgotten capture cannot eat all memory.
+constexpr size_t PROFILER_MAX_TRACE_EVENTS = 1 << 20;
+
+struct ProfileStats {
+    double minimum;
+    double average;
+    double p99;
+};
+
+// Times named scopes on the CPU with steady_clock and on the GPU with
+// GL_TIMESTAMP queries. The whole frame is additionally measured with a
+// GL_TIME_ELAPSED query. Queries are pooled per frame and read back
+// PROFILER_FRAME_LATENCY frames later, so the profiler never stalls the
+// pipeline. Must be used from the thread that owns the context.
+class Profiler {
+public:
+    Profiler();
+    ~Profiler();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    // Creates the GPU queries. Without a call to this only CPU times are recorded.
+    void InitGPU();
+
+    void BeginFrame();
+    void EndFrame();
+
+    // Scopes nest, and the name must outlive the frame (a string literal).
+    void BeginScope(const char* name);
+    void EndScope();
+
+    // Trace events are collected from the start of a capture until the trace is written.
+    void StartCapture();
+    bool IsCapturing() const;
+    bool WriteChromeTrace(const std::string& path);
+
+    // Prints min/avg/p99 of every scope over the last PROFILER_HISTORY frames.
+    void PrintStats() const;
+
+    bool GetCPUStats(const std::string& name, ProfileStats& stats) const;
+    bool GetGPUStats(const std::string& name, ProfileStats& stats) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct ScopeRecord {
+        const char* name;
+        uint32_t depth;
+        int64_t cpuBegin;
+        int64_t cpuEnd;
+        uint32_t gpuBegin;  // Indices into the frame's query pool.
+        uint32_t gpuEnd;
+    };
+
+    struct FrameRecord {
+        std::vector<ScopeRecord> scopes;
+        std::vector<GLuint> queries;
+        size_t queriesUsed = 0;
+        GLuint frameQuery = 0;
+        int64_t cpuBegin = 0;
+        int64_t cpuEnd = 0;
+        int64_t gpuOffset = 0;  // CPU time minus GPU time when the frame began.
+        bool pending = false;
+    };
+
+    struct History {
+        std::vector<double> samples;
+        size_t next = 0;
+
+        void Add(double sample);
+        ProfileStats Compute() const;
+    };
+
+    struct TraceEvent {
+        std::string name;
+        const char* category;
+        int64_t begin;
+        int64_t duration;
+    };
+
+    Clock::time_point m_Start;
+    bool m_GPU;
+
+    FrameRecord m_Frames[PROFILER_FRAME_LATENCY];
+    size_t m_FrameIndex;
+    std::vector<size_t> m_OpenScopes;
+
+    std::unordered_map<std::string, History> m_CPUHistory;
+    std::unordered_map<std::string, History> m_GPUHistory;
+
+    bool m_Capturing;
+    std::vector<TraceEvent> m_Trace;
+
+    int64_t now() const;
+    uint32_t issueTimestamp(FrameRecord& frame);
+    void resolve(FrameRecord& frame);
+    void addTraceEvent(const char* name, const char* category, int64_t begin, int64_t end);
+};
+
+// Times the enclosing block.
+class ProfileScope {
+public:
+    ProfileScope(Profiler& profiler, const char* name) : m_Profiler(profiler) {
+        m_Profiler.BeginScope(name);
+    }
+
+    ~ProfileScope() {
+        m_Profiler.EndScope();
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler& m_Profiler;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(profiler, name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(profiler, name)
@@ -0,0 +1,263 @@
+#include "render_queue.hpp"
+#include "gl_state.hpp"
+#include "transform_system.hpp"
+
+#include <algorithm>
+
+constexpr uint64_t DEPTH_BITS = 24;
+constexpr uint64_t DEPTH_MAX = (1ull << DEPTH_BITS) - 1;
+
+RenderQueue::RenderQueue() : m_DrawDataBuffer(0), m_DrawDataTexture(0), m_IndirectBuffer(0) {}
+
+RenderQueue::~RenderQueue() {
+    if (m_DrawDataTexture != 0) {
+        GL_CHECK(glDeleteTextures(1, &m_DrawDataTexture));
+        glState.DeleteBuffer(m_DrawDataBuffer);
+    }
+
+    if (m_IndirectBuffer != 0) {
+        glState.DeleteBuffer(m_IndirectBuffer);
+    }
+}
+
+void RenderQueue::Begin(const glm::mat4& view, float farPlane) {
+    m_Items.clear();
+    m_Keys.clear();
+
+    m_Stats = RenderQueueStats();
+
+    m_View = view;
+    m_FarPlane = farPlane;
+}
+
+void RenderQueue::Submit(const Model& model, const glm::mat4& transform, const glm::vec3& color, RenderLayer layer) {
+    push(RenderItem{ &model, transform, ComputeNormalMatrix(transform), color, false }, layer);
+}
+
+void RenderQueue::Submit(const Model& model, const glm::mat4& transform, const glm::mat3& normal, const glm::vec3& color, RenderLayer layer) {
+    push(RenderItem{ &model, transform, normal, color, false }, layer);
+}
+
+void RenderQueue::SubmitInstanced(const Model& model, RenderLayer layer) {
+    push(RenderItem{ &model, model.GetMatrix(), glm::mat3(1.0f), glm::vec3(1.0f), true }, layer);
+}
+
+void RenderQueue::Flush() {
+    // Sorting the small key/index pairs is cheaper than moving the items around.
+    std::sort(m_Keys.begin(), m_Keys.end(), [](const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b) {
+        return a.first < b.first;
+    });
+
+    planBatches();
+
+    if (!m_DrawData.empty()) {
+        uploadDrawData();
+    }
+
+    GLuint currentProgram = 0;
+    GLuint currentVertexArray = 0;
+
+    for (const DrawBatch& batch : m_Batches) {
+        const RenderItem& item = m_Items[m_Keys[batch.first].second];
+        Shader& shader = *item.model->GetShader();
+
+        if (shader.GetID() != currentProgram) {
+            shader.Use();
+            currentProgram = shader.GetID();
+            m_Stats.programChanges++;
+        }
+
+        if (item.model->GetVertexArray() != currentVertexArray) {
+            glState.BindVertexArray(item.model->GetVertexArray());
+            currentVertexArray = item.model->GetVertexArray();
+            m_Stats.vertexArrayChanges++;
+        }
+
+        drawBatch(batch);
+
+        m_Stats.items += batch.count;
+        m_Stats.draws++;
+    }
+
+    m_Items.clear();
+    m_Keys.clear();
+}
+
+size_t RenderQueue::GetSize() const {
+    return m_Items.size();
+}
+
+const RenderQueueStats& RenderQueue::GetStats() const {
+    return m_Stats;
+}
+
+uint64_t RenderQueue::MakeKey(RenderLayer layer, GLuint program, GLuint vertexArray, float depth) {
+    uint64_t quantizedDepth = static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * static_cast<float>(DEPTH_MAX));
+    uint64_t state = (static_cast<uint64_t>(program & 0xFFFF) << 16) | static_cast<uint64_t>(vertexArray & 0xFFFF);
+
+    uint64_t key = static_cast<uint64_t>(layer) << 62;
+
+    if (layer == RENDER_LAYER_TRANSPARENT) {
+        key |= (DEPTH_MAX - quantizedDepth) << 38;
+        key |= state << 6;
+    } else {
+        key |= state << 30;
+        key |= quantizedDepth << 6;
+    }
+
+    return key;
+}
+
+// Splits the sorted items into batches and fills the draw data and the
+// multi-draw parameters of the whole queue, so each is uploaded only once.
+void RenderQueue::planBatches() {
+    m_Batches.clear();
+    m_DrawData.clear();
+    m_Commands.clear();
+    m_Counts.clear();
+    m_Offsets.clear();
+    m_BaseVertices.clear();
+
+    // gl_DrawIDARB is what tells the draws of a multi-draw apart in the shader.
+    bool multiDraw = glExtensions.shaderDrawParameters;
+
+    size_t i = 0;
+    while (i < m_Keys.size()) {
+        const RenderItem& item = m_Items[m_Keys[i].second];
+
+        DrawBatch batch;
+        batch.first = static_cast<uint32_t>(i);
+        batch.count = 1;
+        batch.drawIndex = static_cast<GLint>(m_DrawData.size() / DRAW_DATA_TEXELS);
+        batch.command = 0;
+
+        if (item.instanced || !item.model->UsesDrawData()) {
+            m_Batches.push_back(batch);
+            i++;
+            continue;
+        }
+
+        const Model& model = *item.model;
+        size_t end = i + 1;
+
+        while (multiDraw && end < m_Keys.size()) {
+            const RenderItem& next = m_Items[m_Keys[end].second];
+            if (next.instanced || !next.model->UsesDrawData() || next.model->GetShader()->GetID() != model.GetShader()->GetID() ||
+                next.model->GetVertexArray() != model.GetVertexArray() || next.model->GetGeometry().indexType != model.GetGeometry().indexType) {
+                break;
+            }
+            end++;
+        }
+
+        batch.count = static_cast<uint32_t>(end - i);
+        batch.command = glExtensions.multiDrawIndirect ? m_Commands.size() : m_Counts.size();
+
+        for (size_t j = i; j < end; j++) {
+            const RenderItem& batched = m_Items[m_Keys[j].second];
+
+            size_t texel = m_DrawData.size();
+            m_DrawData.resize(texel + DRAW_DATA_TEXELS);
+            batched.model->WriteDrawData(batched.transform, batched.normal, batched.color, &m_DrawData[texel]);
+
+            if (batch.count == 1) {
+                continue;
+            }
+
+            const GeometryAllocation& geometry = batched.model->GetGeometry();
+
+            if (glExtensions.multiDrawIndirect) {
+                DrawElementsIndirectCommand command;
+                command.count = static_cast<GLuint>(geometry.indexCount);
+                command.instanceCount = 1;
+                command.firstIndex = static_cast<GLuint>(geometry.indexOffset / GetIndexSize(geometry.indexType));
+                command.baseVertex = geometry.baseVertex;
+                command.baseInstance = 0;
+                m_Commands.push_back(command);
+            } else {
+                m_Counts.push_back(geometry.indexCount);
+                m_Offsets.push_back(reinterpret_cast<const void*>(geometry.indexOffset));
+                m_BaseVertices.push_back(geometry.baseVertex);
+            }
+        }
+
+        m_Batches.push_back(batch);
+        i = end;
+    }
+}
+
+void RenderQueue::uploadDrawData() {
+    if (m_DrawDataTexture == 0) {
+        GL_CHECK(glGenBuffers(1, &m_DrawDataBuffer));
+        GL_CHECK(glGenTextures(1, &m_DrawDataTexture));
+
+        GL_CHECK(glBindBuffer(GL_TEXTURE_BUFFER, m_DrawDataBuffer));
+        GL_CHECK(glBufferData(GL_TEXTURE_BUFFER, m_DrawData.size() * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW));
+
+        GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, m_DrawDataTexture));
+        GL_CHECK(glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_DrawDataBuffer));
+        GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, 0));
+    }
+
+    // Orphaned every time, a queue may be flushed several times per frame.
+    GL_CHECK(glBindBuffer(GL_TEXTURE_BUFFER, m_DrawDataBuffer));
+    GL_CHECK(glBufferData(GL_TEXTURE_BUFFER, m_DrawData.size() * sizeof(glm::vec4), m_DrawData.data(), GL_STREAM_DRAW));
+    GL_CHECK(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+
+    GL_CHECK(glActiveTexture(GL_TEXTURE0 + DRAW_DATA_TEXTURE_UNIT));
+    GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, m_DrawDataTexture));
+
+    if (!m_Commands.empty()) {
+        if (m_IndirectBuffer == 0) {
+            GL_CHECK(glGenBuffers(1, &m_IndirectBuffer));
+        }
+
+        // Stays bound for the draws, the binding is not part of the vertex array.
+        glState.BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_IndirectBuffer);
+        GL_CHECK(glBufferData(GL_DRAW_INDIRECT_BUFFER, m_Commands.size() * sizeof(DrawElementsIndirectCommand), m_Commands.data(), GL_STREAM_DRAW));
+    }
+}
+
+void RenderQueue::drawBatch(const DrawBatch& batch) {
+    const RenderItem& item = m_Items[m_Keys[batch.first].second];
+    const Model& model = *item.model;
+
+    if (item.instanced) {
+        model.DrawInstanced(item.transform);
+        return;
+    }
+
+    if (!model.UsesDrawData()) {
+        model.Draw(item.transform, item.normal, item.color);
+        return;
+    }
+
+    if (batch.count == 1) {
+        model.DrawWithDrawData(batch.drawIndex);
+        return;
+    }
+
+    model.GetShader()->Set(model.GetDrawBaseUniform(), batch.drawIndex);
+
+    GLenum indexType = model.GetGeometry().indexType;
+    GLsizei count = static_cast<GLsizei>(batch.count);
+
+    if (glExtensions.multiDrawIndirect) {
+        const void* offset = reinterpret_cast<const void*>(batch.command * sizeof(DrawElementsIndirectCommand));
+        GL_CHECK(glExtensions.MultiDrawElementsIndirect(GL_TRIANGLES, indexType, offset, count, 0));
+    } else {
+        GL_CHECK(glMultiDrawElementsBaseVertex(GL_TRIANGLES, &m_Counts[batch.command], indexType, &m_Offsets[batch.command], count, &m_BaseVertices[batch.command]));
+    }
+
+    m_Stats.multiDraws++;
+}
+
+void RenderQueue::push(const RenderItem& item, RenderLayer layer) {
+    // View space looks down -z, so the distance in front of the camera is the negated z.
+    glm::vec4 viewPosition = m_View * glm::vec4(glm::vec3(item.transform[3]), 1.0f);
+    float depth = -viewPosition.z / m_FarPlane;
+
+    uint64_t key = MakeKey(layer, item.model->GetShader()->GetID(), item.model->GetVertexArray(), depth);
+
+    m_Keys.emplace_back(key, static_cast<uint32_t>(m_Items.size()));
+    m_Items.push_back(item);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "model.hpp"
+#include "gl_extensions.hpp"
+
+// Layers are drawn in order. Opaque items are sorted by state first and then
+// front to back, transparent items strictly back to front.
+enum RenderLayer : uint8_t {
+    RENDER_LAYER_OPAQUE = 0,
+    RENDER_LAYER_TRANSPARENT = 1,
+};
+
+struct RenderItem {
+    const Model* model;
+    glm::mat4 transform;
+    glm::mat3 normal;
+    glm::vec3 color;
+    bool instanced;
+};
+
+struct RenderQueueStats {
+    size_t items = 0;
+    size_t draws = 0;           // draw calls issued, a multi-draw counts once
+    size_t multiDraws = 0;
+    size_t programChanges = 0;
+    size_t vertexArrayChanges = 0;
+};
+
+// Collects the draws of a frame, sorts them by a packed 64-bit key and submits
+// them so that programs and vertex arrays are only switched between batches.
+//
+// Opaque key:      | layer:2 | program:16 | vertex array:16 | depth:24 | 0:6 |
+// Transparent key: | layer:2 | far depth:24 | program:16 | vertex array:16 | 0:6 |
+//
+// GL names are truncated to 16 bits. A collision only weakens the batching,
+// Flush compares the real names before skipping a bind.
+//
+// Models with MULTI_DRAW shaders get their transform and color from a draw
+// data buffer that Flush fills for the whole queue at once. Where the context
+// has ARB_shader_draw_parameters, consecutive such items that share program,
+// vertex array and index type, as pooled meshes do, are drawn with a single
+// multi-draw, indirect when available.
+class RenderQueue {
+public:
+    RenderQueue();
+    ~RenderQueue();
+
+    RenderQueue(const RenderQueue&) = delete;
+    RenderQueue& operator=(const RenderQueue&) = delete;
+
+    // Starts a new frame. The view matrix and far plane are used to compute the
+    // depth part of the keys. The stats add up over every Flush until the next Begin.
+    void Begin(const glm::mat4& view, float farPlane);
+
+    // Without a normal matrix one is derived from the transform. Pass the one
+    // kept by TransformSystem to avoid recomputing it for every draw.
+    void Submit(const Model& model, const glm::mat4& transform, const glm::vec3& color = glm::vec3(1.0f), RenderLayer layer = RENDER_LAYER_OPAQUE);
+    void Submit(const Model& model, const glm::mat4& transform, const glm::mat3& normal, const glm::vec3& color = glm::vec3(1.0f), RenderLayer layer = RENDER_LAYER_OPAQUE);
+    void SubmitInstanced(const Model& model, RenderLayer layer = RENDER_LAYER_OPAQUE);
+
+    // Sorts and draws every submitted item, then empties the queue.
+    void Flush();
+
+    size_t GetSize() const;
+    const RenderQueueStats& GetStats() const;
+
+    static uint64_t MakeKey(RenderLayer layer, GLuint program, GLuint vertexArray, float depth);
+
+private:
+    std::vector<RenderItem> m_Items;
+    std::vector<std::pair<uint64_t, uint32_t>> m_Keys;
+
+    glm::mat4 m_View = glm::mat4(1.0f);
+    float m_FarPlane = 1.0f;
+
+    RenderQueueStats m_Stats;
+
+    // A run of sorted items that is drawn together. count is 1 unless it is a multi-draw.
+    struct DrawBatch {
+        uint32_t first;
+        uint32_t count;
+        GLint drawIndex;
+        size_t command;     // first entry in m_Commands or the multi-draw arrays
+    };
+
+    std::vector<DrawBatch> m_Batches;
+    std::vector<glm::vec4> m_DrawData;
+
+    std::vector<DrawElementsIndirectCommand> m_Commands;
+    std::vector<GLsizei> m_Counts;
+    std::vector<const void*> m_Offsets;
+    std::vector<GLint> m_BaseVertices;
+
+    // Created on first use.
+    GLuint m_DrawDataBuffer;
+    GLuint m_DrawDataTexture;
+    GLuint m_IndirectBuffer;
+
+    void push(const RenderItem& item, RenderLayer layer);
+    void planBatches();
+    void uploadDrawData();
+    void drawBatch(const DrawBatch& batch);
+};
@@ -1,32 +1,173 @@
 #include "shader.hpp"
+#include "gl_extensions.hpp"
+#include "gl_state.hpp"
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath) {
-    std::string vertexCode, fragmentCode;
-    std::ifstream vShaderFile, fShaderFile;
+ShaderDefines& ShaderDefines::Define(const std::string& name, const std::string& value) {
+    auto it = std::lower_bound(m_Defines.begin(), m_Defines.end(), name, [](const std::pair<std::string, std::string>& define, const std::string& key) {
+        return define.first < key;
+    });
+
+    if (it != m_Defines.end() && it->first == name) {
+        it->second = value;
+    } else {
+        m_Defines.insert(it, { name, value });
+    }
 
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    return *this;
+}
 
-    try {
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
+ShaderDefines& ShaderDefines::Define(const std::string& name, int value) {
+    return Define(name, std::to_string(value));
+}
+
+bool ShaderDefines::Has(const std::string& name) const {
+    return std::any_of(m_Defines.begin(), m_Defines.end(), [&name](const std::pair<std::string, std::string>& define) {
+        return define.first == name;
+    });
+}
 
-        std::stringstream vShaderStream, fShaderStream;
+std::string ShaderDefines::ToSource() const {
+    std::string source;
+    for (const auto& define : m_Defines) {
+        source += "#define " + define.first + " " + define.second + "\n";
+    }
 
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
+    return source;
+}
 
-        vShaderFile.close();
-        fShaderFile.close();
+std::string ShaderDefines::ToKey() const {
+    std::string key;
+    for (const auto& define : m_Defines) {
+        key += define.first + "=" + define.second + ";";
+    }
 
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+    return key;
+}
+
+static bool readFile(const std::string& path, std::string& contents) {
+    std::ifstream file;
+    file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+
+    try {
+        file.open(path);
+
+        std::stringstream stream;
+        stream << file.rdbuf();
+        file.close();
+
+        contents = stream.str();
     } catch(const std::ifstream::failure& e) {
-        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ\n" << e.what() << std::endl; 
+        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ \"" << path << "\"\n" << e.what() << std::endl;
+        return false;
     }
 
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
+    return true;
+}
+
+static std::string directoryOf(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+static std::string expandIncludes(const std::string& code, const std::string& path, int depth) {
+    if (depth > 16) {
+        std::cerr << "ERROR: Shader includes nested too deeply in \"" << path << "\"" << std::endl;
+        return code;
+    }
+
+    std::string result;
+    result.reserve(code.size());
+
+    std::istringstream stream(code);
+    std::string line;
+    while (std::getline(stream, line)) {
+        size_t start = line.find_first_not_of(" \t");
+        if (start != std::string::npos && line.compare(start, 8, "#include") == 0) {
+            size_t open = line.find('"', start + 8);
+            size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+
+            if (close == std::string::npos) {
+                std::cerr << "ERROR: Malformed #include in \"" << path << "\": " << line << std::endl;
+                continue;
+            }
+
+            std::string includePath = directoryOf(path) + line.substr(open + 1, close - open - 1);
+            std::string included;
+            if (readFile(includePath, included)) {
+                result += expandIncludes(included, includePath, depth + 1);
+                result += "\n";
+            }
+
+            continue;
+        }
+
+        result += line;
+        result += "\n";
+    }
+
+    return result;
+}
+
+std::string PreprocessShader(const std::string& code, const std::string& path, const ShaderDefines& defines) {
+    std::string expanded = expandIncludes(code, path, 0);
+
+    // Defines have to follow the #version directive, which must come first.
+    size_t insertAt = 0;
+    size_t version = expanded.find("#version");
+    if (version != std::string::npos) {
+        size_t lineEnd = expanded.find('\n', version);
+        insertAt = lineEnd == std::string::npos ? expanded.size() : lineEnd + 1;
+    }
+
+    expanded.insert(insertAt, defines.ToSource());
+    return expanded;
+}
+
+ShaderSource ReadShaderSource(const char* vertexPath, const char* fragmentPath, const ShaderDefines& defines) {
+    ShaderSource source;
+    source.vertexPath = vertexPath;
+    source.fragmentPath = fragmentPath ? fragmentPath : "";
+    source.defines = defines;
+
+    std::string vertexCode, fragmentCode;
+    if (readFile(vertexPath, vertexCode)) {
+        source.vertexCode = PreprocessShader(vertexCode, vertexPath, defines);
+    }
+
+    if (!source.fragmentPath.empty() && readFile(fragmentPath, fragmentCode)) {
+        source.fragmentCode = PreprocessShader(fragmentCode, fragmentPath, defines);
+    }
+
+    return source;
+}
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath) : Shader(ReadShaderSource(vertexPath, fragmentPath)) {}
+
+std::shared_ptr<ShaderCache> Shader::s_ProgramCache;
+
+void Shader::SetProgramCache(std::shared_ptr<ShaderCache> cache) {
+    s_ProgramCache = cache;
+}
+
+Shader::Shader(const ShaderSource& source) : m_Defines(source.defines) {
+    if (s_ProgramCache) {
+        this->m_ID = s_ProgramCache->Load(source);
+    }
+
+    if (this->m_ID == 0 && compile(source) && s_ProgramCache) {
+        s_ProgramCache->Store(this->m_ID, source);
+    }
+
+    reflectUniforms();
+    bindUniformBlocks();
+}
+
+bool Shader::compile(const ShaderSource& source) {
+    const char* vertexPath = source.vertexPath.c_str();
+    const char* fragmentPath = source.fragmentPath.c_str();
+
+    const char* vShaderCode = source.vertexCode.c_str();
+    const char* fShaderCode = source.fragmentCode.c_str();
 
     int success;
     char infoLog[INFOLOG_SIZE];
@@ -41,19 +182,41 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
         std::cerr << "ERROR: Failed to compile vertex shader \"" << vertexPath << "\"\n" << infoLog << std::endl;
     }
 
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    GL_CHECK(glShaderSource(fragmentShader, 1, &fShaderCode, nullptr));
-    GL_CHECK(glCompileShader(fragmentShader));
-    GL_CHECK(glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success));
+    GLuint fragmentShader = 0;
 
-    if (!success) {
-        GL_CHECK(glGetShaderInfoLog(fragmentShader, INFOLOG_SIZE, nullptr, infoLog));
-        std::cerr << "ERROR: Failed to compile fragment shader \"" << fragmentPath << "\"\n" << infoLog << std::endl;
+    if (!source.fragmentPath.empty()) {
+        fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+        GL_CHECK(glShaderSource(fragmentShader, 1, &fShaderCode, nullptr));
+        GL_CHECK(glCompileShader(fragmentShader));
+        GL_CHECK(glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success));
+
+        if (!success) {
+            GL_CHECK(glGetShaderInfoLog(fragmentShader, INFOLOG_SIZE, nullptr, infoLog));
+            std::cerr << "ERROR: Failed to compile fragment shader \"" << fragmentPath << "\"\n" << infoLog << std::endl;
+        }
     }
 
     this->m_ID = glCreateProgram();
+
+    if (s_ProgramCache && s_ProgramCache->IsEnabled()) {
+        GL_CHECK(glExtensions.ProgramParameteri(this->m_ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    }
+
     GL_CHECK(glAttachShader(this->m_ID, vertexShader));
-    GL_CHECK(glAttachShader(this->m_ID, fragmentShader));
+    if (fragmentShader != 0) {
+        GL_CHECK(glAttachShader(this->m_ID, fragmentShader));
+    }
+
+    // Feedback varyings are part of the link, so they have to be declared before it.
+    if (!source.feedbackVaryings.empty()) {
+        std::vector<const char*> varyings;
+        for (const std::string& varying : source.feedbackVaryings) {
+            varyings.push_back(varying.c_str());
+        }
+
+        GL_CHECK(glTransformFeedbackVaryings(this->m_ID, static_cast<GLsizei>(varyings.size()), varyings.data(), GL_INTERLEAVED_ATTRIBS));
+    }
+
     GL_CHECK(glLinkProgram(this->m_ID));
     GL_CHECK(glGetProgramiv(this->m_ID, GL_LINK_STATUS, &success));
 
@@ -63,183 +226,266 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
     }
 
     GL_CHECK(glDeleteShader(vertexShader));
-    GL_CHECK(glDeleteShader(fragmentShader));
+    if (fragmentShader != 0) {
+        GL_CHECK(glDeleteShader(fragmentShader));
+    }
+
+    return success != 0;
 }
 
 Shader::~Shader() {
-    GL_CHECK(glDeleteProgram(this->m_ID));
+    glState.DeleteProgram(this->m_ID);
 
     std::cout << "Shader has been deleted!\n";
 }
 
 void Shader::Use() {
-    GL_CHECK(glUseProgram(this->m_ID));
+    glState.UseProgram(this->m_ID);
 }
 
-void Shader::Set(const std::string& name, bool value) const {
-    static bool notified = false;
+GLuint Shader::GetID() const {
+    return this->m_ID;
+}
 
-    GLint location = glGetUniformLocation(this->m_ID, name.c_str());
-    if (location == -1) {
-        if (!notified) {
-            std::cerr << "Failed to find \"" << name << "\"" << std::endl;
-            notified = true;
-        }
-    } else {
-        GL_CHECK(glUniform1i(location, static_cast<int>(value)));
+void Shader::Set(Uniform<bool> uniform, bool value) const {
+    if (uniform.IsValid()) {
+        GL_CHECK(glUniform1i(uniform.location, static_cast<int>(value)));
     }
 }
-    
-void Shader::Set(const std::string& name, int value) const {
-    static bool notified = false;
 
-    GLint location = glGetUniformLocation(this->m_ID, name.c_str());
-    if (location == -1) {
-        if (!notified) {
-            std::cerr << "Failed to find \"" << name << "\"" << std::endl;
-            notified = true;
-        }
-    } else {
-        GL_CHECK(glUniform1i(location, value));
+void Shader::Set(Uniform<int> uniform, int value) const {
+    if (uniform.IsValid()) {
+        GL_CHECK(glUniform1i(uniform.location, value));
     }
 }
 
-void Shader::Set(const std::string& name, float value) const {
-    static bool notified = false;
+void Shader::Set(Uniform<float> uniform, float value) const {
+    if (uniform.IsValid()) {
+        GL_CHECK(glUniform1f(uniform.location, value));
+    }
+}
 
-    GLint location = glGetUniformLocation(this->m_ID, name.c_str());
-    if (location == -1) {
-        if (!notified) {
-            std::cerr << "Failed to find \"" << name << "\"" << std::endl;
-            notified = true;
-        }
-    } else {
-        GL_CHECK(glUniform1f(location, value));
+void Shader::Set(Uniform<glm::vec2> uniform, const glm::vec2& value) const {
+    if (uniform.IsValid()) {
+        GL_CHECK(glUniform2fv(uniform.location, 1, &value[0]));
     }
 }
 
-void Shader::Set(const std::string& name, const glm::vec2& value) const {
-    static bool notified = false;
+void Shader::Set(Uniform<glm::vec2> uniform, float x, float y) const {
+    if (uniform.IsValid()) {
+        GL_CHECK(glUniform2f(uniform.location, x, y));
+    }
+}
 
-    GLint location = glGetUniformLocation(this->m_ID, name.c_str());
-    if (location == -1) {
-        if (!notified) {
-            std::cerr << "Failed to find \"" << name << "\"" << std::endl;
-            notified = true;
-        }
-    } else {
-        GL_CHECK(glUniform2fv(location, 1, &value[0]));
+void Shader::Set(Uniform<glm::vec3> uniform, const glm::vec3& value) const {
+    if (uniform.IsValid()) {
+        GL_CHECK(glUniform3fv(uniform.location, 1, &value[0]));
     }
 }
 
-void Shader::Set(const std::string& name, float x, float y) const {
-    static bool notified = false;
+void Shader::Set(Uniform<glm::vec3> uniform, float x, float y, float z) const {
+    if (uniform.IsValid()) {
+        GL_CHECK(glUniform3f(uniform.location, x, y, z));
+    }
+}
 
-    GLint location = glGetUniformLocation(this->m_ID, name.c_str());
-    if (location == -1) {
-        if (!notified) {
-            std::cerr << "Failed to find \"" << name << "\"" << std::endl;
-            notified = true;
-        }
-    } else {
-        GL_CHECK(glUniform2f(location, x, y));
+void Shader::Set(Uniform<glm::vec4> uniform, const glm::vec4& value) const {
+    if (uniform.IsValid()) {
+        GL_CHECK(glUniform4fv(uniform.location, 1, &value[0]));
     }
 }
 
-void Shader::Set(const std::string& name, const glm::vec3& value) const {
-    static bool notified = false;
+void Shader::Set(Uniform<glm::vec4> uniform, float x, float y, float z, float w) const {
+    if (uniform.IsValid()) {
+        GL_CHECK(glUniform4f(uniform.location, x, y, z, w));
+    }
+}
 
-    GLint location = glGetUniformLocation(this->m_ID, name.c_str());
-    if (location == -1) {
-        if (!notified) {
-            std::cerr << "Failed to find \"" << name << "\"" << std::endl;
-            notified = true;
-        }
-    } else {
-        GL_CHECK(glUniform3fv(location, 1, &value[0]));
+void Shader::Set(Uniform<glm::mat2> uniform, const glm::mat2& value) const {
+    if (uniform.IsValid()) {
+        GL_CHECK(glUniformMatrix2fv(uniform.location, 1, GL_FALSE, glm::value_ptr(value)));
     }
 }
 
-void Shader::Set(const std::string& name, float x, float y, float z) const {
-    static bool notified = false;
+void Shader::Set(Uniform<glm::mat3> uniform, const glm::mat3& value) const {
+    if (uniform.IsValid()) {
+        GL_CHECK(glUniformMatrix3fv(uniform.location, 1, GL_FALSE, glm::value_ptr(value)));
+    }
+}
 
-    GLint location = glGetUniformLocation(this->m_ID, name.c_str());
-    if (location == -1) {
-        if (!notified) {
-            std::cerr << "Failed to find \"" << name << "\"" << std::endl;
-            notified = true;
-        }
-    } else {
-        GL_CHECK(glUniform3f(location, x, y, z));
+void Shader::Set(Uniform<glm::mat4> uniform, const glm::mat4& value) const {
+    if (uniform.IsValid()) {
+        GL_CHECK(glUniformMatrix4fv(uniform.location, 1, GL_FALSE, glm::value_ptr(value)));
     }
 }
 
-void Shader::Set(const std::string& name, const glm::vec4& value) const {
-    static bool notified = false;
+void Shader::Set(const std::string& name, bool value) const {
+    Set(GetUniform<bool>(name), value);
+}
 
-    GLint location = glGetUniformLocation(this->m_ID, name.c_str());
-    if (location == -1) {
-        if (!notified) {
-            std::cerr << "Failed to find \"" << name << "\"" << std::endl;
-            notified = true;
-        }
-    } else {
-        GL_CHECK(glUniform4fv(location, 1, &value[0]));
-    }
+void Shader::Set(const std::string& name, int value) const {
+    Set(GetUniform<int>(name), value);
 }
 
-void Shader::Set(const std::string& name, float x, float y, float z, float w) const {
-    static bool notified = false;
+void Shader::Set(const std::string& name, float value) const {
+    Set(GetUniform<float>(name), value);
+}
 
-    GLint location = glGetUniformLocation(this->m_ID, name.c_str());
-    if (location == -1) {
-        if (!notified) {
-            std::cerr << "Failed to find \"" << name << "\"" << std::endl;
-            notified = true;
-        }
-    } else {
-        GL_CHECK(glUniform4f(location, x, y, z, w));
-    }
+void Shader::Set(const std::string& name, const glm::vec2& value) const {
+    Set(GetUniform<glm::vec2>(name), value);
+}
+
+void Shader::Set(const std::string& name, float x, float y) const {
+    Set(GetUniform<glm::vec2>(name), x, y);
+}
+
+void Shader::Set(const std::string& name, const glm::vec3& value) const {
+    Set(GetUniform<glm::vec3>(name), value);
+}
+
+void Shader::Set(const std::string& name, float x, float y, float z) const {
+    Set(GetUniform<glm::vec3>(name), x, y, z);
+}
+
+void Shader::Set(const std::string& name, const glm::vec4& value) const {
+    Set(GetUniform<glm::vec4>(name), value);
+}
+
+void Shader::Set(const std::string& name, float x, float y, float z, float w) const {
+    Set(GetUniform<glm::vec4>(name), x, y, z, w);
 }
 
 void Shader::Set(const std::string& name, const glm::mat2& value) const {
-    static bool notified = false;
+    Set(GetUniform<glm::mat2>(name), value);
+}
 
-    GLint location = glGetUniformLocation(this->m_ID, name.c_str());
-    if (location == -1) {
-        if (!notified) {
-            std::cerr << "Failed to find \"" << name << "\"" << std::endl;
-            notified = true;
+void Shader::Set(const std::string& name, const glm::mat3& value) const {
+    Set(GetUniform<glm::mat3>(name), value);
+}
+
+void Shader::Set(const std::string& name, const glm::mat4& value) const {
+    Set(GetUniform<glm::mat4>(name), value);
+}
+
+void Shader::reflectUniforms() {
+    GLint uniformCount = 0;
+    GLint maxNameLength = 0;
+    GL_CHECK(glGetProgramiv(this->m_ID, GL_ACTIVE_UNIFORMS, &uniformCount));
+    GL_CHECK(glGetProgramiv(this->m_ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength));
+
+    std::vector<char> nameBuffer(static_cast<size_t>(maxNameLength) + 1);
+
+    for (GLint i = 0; i < uniformCount; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        GL_CHECK(glGetActiveUniform(this->m_ID, static_cast<GLuint>(i), static_cast<GLsizei>(nameBuffer.size()), &length, &size, &type, nameBuffer.data()));
+
+        std::string name(nameBuffer.data(), static_cast<size_t>(length));
+
+        // Members of uniform blocks have no location and are not set through the table.
+        GLint location = glGetUniformLocation(this->m_ID, name.c_str());
+        if (location == -1) {
+            continue;
+        }
+
+        // Arrays are reported as "name[0]". Register the bare name as well as every
+        // element. Struct array members such as "lights[0].position" are reported
+        // one by one and kept as they are.
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+            std::string baseName = name.substr(0, name.size() - 3);
+            m_Uniforms.push_back({ baseName, location, type });
+
+            for (GLint element = 0; element < size; element++) {
+                std::string elementName = baseName + "[" + std::to_string(element) + "]";
+                m_Uniforms.push_back({ elementName, glGetUniformLocation(this->m_ID, elementName.c_str()), type });
+            }
+        } else {
+            m_Uniforms.push_back({ name, location, type });
         }
-    } else {
-        GL_CHECK(glUniformMatrix2fv(location, 1, GL_FALSE, glm::value_ptr(value)));
     }
+
+    std::sort(m_Uniforms.begin(), m_Uniforms.end(), [](const UniformInfo& a, const UniformInfo& b) {
+        return a.name < b.name;
+    });
 }
 
-void Shader::Set(const std::string& name, const glm::mat3& value) const {
-    static bool notified = false;
+void Shader::bindUniformBlocks() {
+    GLint blockCount = 0;
+    GLint maxNameLength = 0;
+    GL_CHECK(glGetProgramiv(this->m_ID, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount));
+    GL_CHECK(glGetProgramiv(this->m_ID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxNameLength));
 
-    GLint location = glGetUniformLocation(this->m_ID, name.c_str());
-    if (location == -1) {
-        if (!notified) {
-            std::cerr << "Failed to find \"" << name << "\"" << std::endl;
-            notified = true;
+    std::vector<char> nameBuffer(static_cast<size_t>(maxNameLength) + 1);
+
+    for (GLint i = 0; i < blockCount; i++) {
+        GL_CHECK(glGetActiveUniformBlockName(this->m_ID, static_cast<GLuint>(i), static_cast<GLsizei>(nameBuffer.size()), nullptr, nameBuffer.data()));
+
+        GLint binding = GetUniformBlockBinding(nameBuffer.data());
+        if (binding == -1) {
+            std::cerr << "Uniform block \"" << nameBuffer.data() << "\" has no shared binding point" << std::endl;
+            continue;
         }
-    } else {
-        GL_CHECK(glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value)));
+
+        GL_CHECK(glUniformBlockBinding(this->m_ID, static_cast<GLuint>(i), static_cast<GLuint>(binding)));
     }
 }
 
-void Shader::Set(const std::string& name, const glm::mat4& value) const {
-    static bool notified = false;
+static bool isIntegerUniform(GLenum type) {
+    switch (type) {
+    case GL_INT:
+    case GL_BOOL:
+    case GL_SAMPLER_1D:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_2D_SHADOW:
+    case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_2D_MULTISAMPLE:
+    case GL_SAMPLER_BUFFER:
+    case GL_INT_SAMPLER_2D:
+    case GL_INT_SAMPLER_BUFFER:
+    case GL_UNSIGNED_INT_SAMPLER_2D:
+    case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+        return true;
+    default:
+        return false;
+    }
+}
+
+const ShaderDefines& Shader::GetDefines() const {
+    return m_Defines;
+}
+
+bool Shader::HasUniform(const std::string& name) const {
+    auto it = std::lower_bound(m_Uniforms.begin(), m_Uniforms.end(), name, [](const UniformInfo& info, const std::string& value) {
+        return info.name < value;
+    });
 
-    GLint location = glGetUniformLocation(this->m_ID, name.c_str());
-    if (location == -1) {
-        if (!notified) {
+    return it != m_Uniforms.end() && it->name == name;
+}
+
+GLint Shader::findUniform(const std::string& name, GLenum type) const {
+    auto it = std::lower_bound(m_Uniforms.begin(), m_Uniforms.end(), name, [](const UniformInfo& info, const std::string& value) {
+        return info.name < value;
+    });
+
+    if (it == m_Uniforms.end() || it->name != name) {
+        if (m_ReportedUniforms.insert(name).second) {
             std::cerr << "Failed to find \"" << name << "\"" << std::endl;
-            notified = true;
         }
-    } else {
-        GL_CHECK(glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value)));
+
+        return -1;
     }
-}
+
+    bool compatible = it->type == type || ((type == GL_INT || type == GL_BOOL) && isIntegerUniform(it->type));
+    if (!compatible) {
+        if (m_ReportedUniforms.insert(name).second) {
+            std::cerr << "Uniform \"" << name << "\" does not match the requested type" << std::endl;
+        }
+
+        return -1;
+    }
+
+    return it->location;
+}
\ No newline at end of file
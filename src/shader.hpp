@@ -8,18 +8,103 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+#include <memory>
 
 #include "utility.hpp"
+#include "uniform_buffer.hpp"
+#include "shader_cache.hpp"
 
 #define INFOLOG_SIZE 1024
 
+// Handle to a uniform that was resolved once from the shader's location table.
+// Setting a uniform through a handle does no string lookups or driver queries,
+// so handles should be resolved up front and kept for the lifetime of the shader.
+template <typename T>
+struct Uniform {
+    GLint location = -1;
+
+    bool IsValid() const { return location != -1; }
+};
+
+// Preprocessor defines that specialise a shader. Defines are kept sorted by
+// name so that equal sets always produce the same source text and key.
+class ShaderDefines {
+public:
+    ShaderDefines& Define(const std::string& name, const std::string& value = "1");
+    ShaderDefines& Define(const std::string& name, int value);
+
+    bool Has(const std::string& name) const;
+
+    // One "#define NAME VALUE" line per define.
+    std::string ToSource() const;
+
+    // Compact "NAME=VALUE;..." form used as part of cache keys.
+    std::string ToKey() const;
+
+private:
+    std::vector<std::pair<std::string, std::string>> m_Defines;
+};
+
+// Shader source code read from disk. Includes are expanded and the defines are
+// injected after the #version line. Reading does not touch GL, so it can happen
+// on a worker thread before the program is compiled on the GL thread.
+struct ShaderSource {
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::string vertexCode;
+    std::string fragmentCode;
+    ShaderDefines defines;
+
+    // Vertex outputs captured by transform feedback, interleaved in this order.
+    std::vector<std::string> feedbackVaryings;
+};
+
+// Without a fragment path the program only has a vertex stage, for transform feedback passes.
+ShaderSource ReadShaderSource(const char* vertexPath, const char* fragmentPath, const ShaderDefines& defines = ShaderDefines());
+
+// Expands #include "file" directives (relative to the including file) in code
+// read from path, then injects the defines. Exposed for callers that cache raw
+// file contents, such as ShaderLibrary.
+std::string PreprocessShader(const std::string& code, const std::string& path, const ShaderDefines& defines);
+
 class Shader {
 public:
     Shader(const char* vertexPath, const char* fragmentPath);
+    explicit Shader(const ShaderSource& source);
     ~Shader();
 
     void Use();
 
+    GLuint GetID() const;
+
+    template <typename T>
+    Uniform<T> GetUniform(const std::string& name) const;
+
+    // Shaders created after this look for a cached program binary before
+    // compiling, and store the binary after a successful link.
+    static void SetProgramCache(std::shared_ptr<ShaderCache> cache);
+
+    const ShaderDefines& GetDefines() const;
+
+    // Checks for an active uniform without reporting it as missing.
+    bool HasUniform(const std::string& name) const;
+
+    void Set(Uniform<bool> uniform, bool value) const;
+    void Set(Uniform<int> uniform, int value) const;
+    void Set(Uniform<float> uniform, float value) const;
+    void Set(Uniform<glm::vec2> uniform, const glm::vec2& value) const;
+    void Set(Uniform<glm::vec2> uniform, float x, float y) const;
+    void Set(Uniform<glm::vec3> uniform, const glm::vec3& value) const;
+    void Set(Uniform<glm::vec3> uniform, float x, float y, float z) const;
+    void Set(Uniform<glm::vec4> uniform, const glm::vec4& value) const;
+    void Set(Uniform<glm::vec4> uniform, float x, float y, float z, float w) const;
+    void Set(Uniform<glm::mat2> uniform, const glm::mat2& value) const;
+    void Set(Uniform<glm::mat3> uniform, const glm::mat3& value) const;
+    void Set(Uniform<glm::mat4> uniform, const glm::mat4& value) const;
+
     void Set(const std::string& name, bool value) const;
     void Set(const std::string& name, int value) const;
     void Set(const std::string& name, float value) const;
@@ -31,8 +116,45 @@ public:
     void Set(const std::string& name, float x, float y, float z, float w) const;
     void Set(const std::string& name, const glm::mat2& value) const;
     void Set(const std::string& name, const glm::mat3& value) const;
-    void Set(const std::string& name, const glm::mat4& value) const; 
-    
+    void Set(const std::string& name, const glm::mat4& value) const;
+
 private:
+    struct UniformInfo {
+        std::string name;
+        GLint location;
+        GLenum type;
+    };
+
     GLuint m_ID = 0;
-};
\ No newline at end of file
+    ShaderDefines m_Defines;
+
+    static std::shared_ptr<ShaderCache> s_ProgramCache;
+
+    // Active uniforms sorted by name, reflected once after the program is linked.
+    std::vector<UniformInfo> m_Uniforms;
+
+    // Names that have already been reported as missing or mistyped, so each
+    // problem is only printed once without silencing warnings for other names.
+    mutable std::unordered_set<std::string> m_ReportedUniforms;
+
+    bool compile(const ShaderSource& source);
+    void reflectUniforms();
+    void bindUniformBlocks();
+    GLint findUniform(const std::string& name, GLenum type) const;
+};
+
+template <typename T> struct UniformType;
+template <> struct UniformType<bool>      { static constexpr GLenum value = GL_BOOL; };
+template <> struct UniformType<int>       { static constexpr GLenum value = GL_INT; };
+template <> struct UniformType<float>     { static constexpr GLenum value = GL_FLOAT; };
+template <> struct UniformType<glm::vec2> { static constexpr GLenum value = GL_FLOAT_VEC2; };
+template <> struct UniformType<glm::vec3> { static constexpr GLenum value = GL_FLOAT_VEC3; };
+template <> struct UniformType<glm::vec4> { static constexpr GLenum value = GL_FLOAT_VEC4; };
+template <> struct UniformType<glm::mat2> { static constexpr GLenum value = GL_FLOAT_MAT2; };
+template <> struct UniformType<glm::mat3> { static constexpr GLenum value = GL_FLOAT_MAT3; };
+template <> struct UniformType<glm::mat4> { static constexpr GLenum value = GL_FLOAT_MAT4; };
+
+template <typename T>
+Uniform<T> Shader::GetUniform(const std::string& name) const {
+    return Uniform<T>{ findUniform(name, UniformType<T>::value) };
+}
\ No newline at end of file
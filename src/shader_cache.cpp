@@ -0,0 +1,157 @@
+#include "shader_cache.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "shader.hpp"
+#include "gl_extensions.hpp"
+
+constexpr uint32_t PROGRAM_CACHE_MAGIC = 0x42504C48; // "HLPB"
+constexpr uint32_t PROGRAM_CACHE_VERSION = 1;
+
+struct ProgramCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t binaryFormat;
+    uint32_t length;
+};
+
+static uint64_t fnv1a(uint64_t hash, const std::string& text) {
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+
+    // Separate the fields so that moving text from one to the next changes the hash.
+    hash ^= 0xFF;
+    hash *= 1099511628211ull;
+
+    return hash;
+}
+
+static std::string glString(GLenum name) {
+    const char* value = reinterpret_cast<const char*>(glGetString(name));
+    return value ? value : "";
+}
+
+ShaderCache::ShaderCache(const std::string& directory) : m_Directory(directory), m_Enabled(glExtensions.programBinary) {
+    if (!m_Enabled) {
+        return;
+    }
+
+    m_DriverID = glString(GL_VENDOR) + "\n" + glString(GL_RENDERER) + "\n" + glString(GL_VERSION);
+
+    std::error_code error;
+    std::filesystem::create_directories(m_Directory, error);
+    if (error) {
+        std::cerr << "ERROR: Failed to create shader cache directory \"" << m_Directory << "\": " << error.message() << std::endl;
+        m_Enabled = false;
+    }
+}
+
+GLuint ShaderCache::Load(const ShaderSource& source) const {
+    if (!m_Enabled) {
+        return 0;
+    }
+
+    uint64_t key = hashSource(source);
+
+    std::ifstream file(entryPath(key), std::ios::binary);
+    if (!file) {
+        return 0;
+    }
+
+    ProgramCacheHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != PROGRAM_CACHE_MAGIC || header.version != PROGRAM_CACHE_VERSION || header.key != key) {
+        return 0;
+    }
+
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), static_cast<std::streamsize>(binary.size()))) {
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    GL_CHECK(glExtensions.ProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size())));
+
+    // Drivers are allowed to reject binaries at any time, for instance after an update.
+    GLint success = 0;
+    GL_CHECK(glGetProgramiv(program, GL_LINK_STATUS, &success));
+    if (!success) {
+        GL_CHECK(glDeleteProgram(program));
+        return 0;
+    }
+
+    return program;
+}
+
+void ShaderCache::Store(GLuint program, const ShaderSource& source) const {
+    if (!m_Enabled) {
+        return;
+    }
+
+    GLint length = 0;
+    GL_CHECK(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0) {
+        return;
+    }
+
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLenum binaryFormat = 0;
+    GL_CHECK(glExtensions.GetProgramBinary(program, length, nullptr, &binaryFormat, binary.data()));
+
+    ProgramCacheHeader header = { PROGRAM_CACHE_MAGIC, PROGRAM_CACHE_VERSION, hashSource(source), binaryFormat, static_cast<uint32_t>(length) };
+
+    // Write to a temporary file and rename it so a concurrent reader never sees a partial entry.
+    std::string path = entryPath(header.key);
+    std::string temporaryPath = path + ".tmp";
+
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+
+        if (!file) {
+            std::cerr << "ERROR: Failed to write shader cache entry \"" << temporaryPath << "\"" << std::endl;
+            return;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        std::cerr << "ERROR: Failed to store shader cache entry \"" << path << "\": " << error.message() << std::endl;
+        std::filesystem::remove(temporaryPath, error);
+    }
+}
+
+bool ShaderCache::IsEnabled() const {
+    return m_Enabled;
+}
+
+uint64_t ShaderCache::hashSource(const ShaderSource& source) const {
+    uint64_t hash = 14695981039346656037ull;
+    hash = fnv1a(hash, source.vertexCode);
+    hash = fnv1a(hash, source.fragmentCode);
+    for (const std::string& varying : source.feedbackVaryings) {
+        hash = fnv1a(hash, varying);
+    }
+    hash = fnv1a(hash, m_DriverID);
+
+    return hash;
+}
+
+std::string ShaderCache::entryPath(uint64_t key) const {
+    static const char digits[] = "0123456789abcdef";
+
+    std::string name(16, '0');
+    for (int i = 15; i >= 0; i--) {
+        name[i] = digits[key & 0xF];
+        key >>= 4;
+    }
+
+    return (std::filesystem::path(m_Directory) / (name + ".bin")).string();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+
+struct ShaderSource;
+
+// On-disk cache of linked program binaries. Entries are keyed by a hash of the
+// complete vertex and fragment source together with the GL vendor, renderer
+// and version strings, so a driver update or any source change misses the
+// cache instead of loading a stale binary.
+class ShaderCache {
+public:
+    explicit ShaderCache(const std::string& directory);
+
+    // Creates and links a program from a cached binary. Returns 0 when there is
+    // no entry or the driver rejects it, in which case the caller compiles from source.
+    GLuint Load(const ShaderSource& source) const;
+
+    // Saves the binary of a linked program. The program must have been linked
+    // with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+    void Store(GLuint program, const ShaderSource& source) const;
+
+    bool IsEnabled() const;
+
+private:
+    std::string m_Directory;
+    std::string m_DriverID;
+    bool m_Enabled;
+
+    uint64_t hashSource(const ShaderSource& source) const;
+    std::string entryPath(uint64_t key) const;
+};
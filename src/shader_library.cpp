@@ -0,0 +1,49 @@
+#include "shader_library.hpp"
+
+std::shared_ptr<Shader> ShaderLibrary::Get(const std::string& vertexPath, const std::string& fragmentPath, const ShaderDefines& defines) {
+    std::string key = vertexPath + "|" + fragmentPath + "|" + defines.ToKey();
+
+    auto it = m_Variants.find(key);
+    if (it != m_Variants.end()) {
+        return it->second;
+    }
+
+    ShaderSource source;
+    source.vertexPath = vertexPath;
+    source.fragmentPath = fragmentPath;
+    source.defines = defines;
+    source.vertexCode = PreprocessShader(readFile(vertexPath), vertexPath, defines);
+    source.fragmentCode = PreprocessShader(readFile(fragmentPath), fragmentPath, defines);
+
+    std::shared_ptr<Shader> shader = std::make_shared<Shader>(source);
+    m_Variants.emplace(key, shader);
+
+    return shader;
+}
+
+void ShaderLibrary::Clear() {
+    m_Variants.clear();
+    m_Files.clear();
+}
+
+size_t ShaderLibrary::GetVariantCount() const {
+    return m_Variants.size();
+}
+
+const std::string& ShaderLibrary::readFile(const std::string& path) {
+    auto it = m_Files.find(path);
+    if (it != m_Files.end()) {
+        return it->second;
+    }
+
+    std::ifstream file(path);
+    std::stringstream stream;
+
+    if (file) {
+        stream << file.rdbuf();
+    } else {
+        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ \"" << path << "\"" << std::endl;
+    }
+
+    return m_Files.emplace(path, stream.str()).first->second;
+}
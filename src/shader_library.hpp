@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "shader.hpp"
+
+// Features a shader variant can be specialised for. Each one maps to a define
+// that the shaders test with #ifdef.
+enum ShaderFeature : uint32_t {
+    SHADER_FEATURE_NONE = 0,
+    SHADER_FEATURE_OCTAHEDRAL_NORMALS = 1u << 0,  // OCTAHEDRAL_NORMALS
+    SHADER_FEATURE_LIGHT_BUFFER_INSTANCES = 1u << 1,  // LIGHT_BUFFER_INSTANCES
+    SHADER_FEATURE_GBUFFER = 1u << 2,  // GBUFFER
+    SHADER_FEATURE_CLUSTERED_LIGHTS = 1u << 3,  // CLUSTERED_LIGHTS
+    SHADER_FEATURE_MULTI_DRAW = 1u << 4,  // MULTI_DRAW
+};
+
+// Compile-time description of a shader variant. LightCount fixes the light
+// loop in cube.frag so the compiler can unroll it; 0 keeps the runtime count.
+template <uint32_t Features, int LightCount = 0>
+struct ShaderPermutation {
+    static constexpr uint32_t features = Features;
+    static constexpr int lightCount = LightCount;
+
+    static ShaderDefines Defines() {
+        ShaderDefines defines;
+
+        if constexpr ((Features & SHADER_FEATURE_OCTAHEDRAL_NORMALS) != 0) {
+            defines.Define("OCTAHEDRAL_NORMALS");
+        }
+
+        if constexpr ((Features & SHADER_FEATURE_LIGHT_BUFFER_INSTANCES) != 0) {
+            defines.Define("LIGHT_BUFFER_INSTANCES");
+        }
+
+        if constexpr ((Features & SHADER_FEATURE_GBUFFER) != 0) {
+            defines.Define("GBUFFER");
+        }
+
+        if constexpr ((Features & SHADER_FEATURE_CLUSTERED_LIGHTS) != 0) {
+            defines.Define("CLUSTERED_LIGHTS");
+        }
+
+        if constexpr ((Features & SHADER_FEATURE_MULTI_DRAW) != 0) {
+            defines.Define("MULTI_DRAW");
+        }
+
+        if constexpr (LightCount > 0) {
+            defines.Define("LIGHT_COUNT", LightCount);
+        }
+
+        return defines;
+    }
+};
+
+// Builds and caches shader variants. A variant is identified by its file paths
+// and defines, and each file is read from disk only once however many variants
+// are built from it.
+class ShaderLibrary {
+public:
+    std::shared_ptr<Shader> Get(const std::string& vertexPath, const std::string& fragmentPath, const ShaderDefines& defines = ShaderDefines());
+
+    template <typename Permutation>
+    std::shared_ptr<Shader> Get(const std::string& vertexPath, const std::string& fragmentPath) {
+        return Get(vertexPath, fragmentPath, Permutation::Defines());
+    }
+
+    // Drops every variant and file, for instance to reload shaders after they changed on disk.
+    void Clear();
+
+    size_t GetVariantCount() const;
+
+private:
+    std::unordered_map<std::string, std::shared_ptr<Shader>> m_Variants;
+    std::unordered_map<std::string, std::string> m_Files;
+
+    const std::string& readFile(const std::string& path);
+};
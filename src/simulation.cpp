@@ -0,0 +1,100 @@
+#include "simulation.hpp"
+
+#include <algorithm>
+
+Simulation::Simulation(const std::vector<Light>& lights, double tickSeconds) : m_Start(Clock::now()), m_TickSeconds(tickSeconds), m_Running(false) {
+    m_State.previousLights = lights;
+    m_State.lights = lights;
+
+    m_Animation.Reserve(lights.size());
+    for (const Light& light : lights) {
+        m_Animation.Add(light.position, LIGHT_ROTATION_AXIS, LIGHT_ROTATION_SPEED);
+    }
+
+    // Until the first tick is published the reader sees the initial state.
+    m_Snapshots.GetWriteBuffer() = m_State;
+    m_Snapshots.Publish();
+}
+
+Simulation::~Simulation() {
+    Stop();
+}
+
+void Simulation::Start() {
+    if (m_Running.exchange(true)) {
+        return;
+    }
+
+    m_Thread = std::thread(&Simulation::run, this);
+}
+
+void Simulation::Stop() {
+    if (!m_Running.exchange(false)) {
+        return;
+    }
+
+    m_Thread.join();
+}
+
+void Simulation::Sample(std::vector<Light>& lights) {
+    m_Snapshots.Update();
+    const SimulationState& state = m_Snapshots.GetReadBuffer();
+
+    // Rendering one tick behind keeps the sample time between the two ticks in the snapshot.
+    double sampleTime = GetTime() - m_TickSeconds;
+    float alpha = static_cast<float>(std::clamp(1.0 - (state.time - sampleTime) / m_TickSeconds, 0.0, 1.0));
+
+    lights.resize(state.lights.size());
+
+    for (size_t i = 0; i < state.lights.size(); i++) {
+        lights[i].position = glm::mix(state.previousLights[i].position, state.lights[i].position, alpha);
+        lights[i].color = state.lights[i].color;
+    }
+}
+
+double Simulation::GetTime() const {
+    return std::chrono::duration<double>(Clock::now() - m_Start).count();
+}
+
+double Simulation::GetTickSeconds() const {
+    return m_TickSeconds;
+}
+
+void Simulation::run() {
+    auto tick = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_TickSeconds));
+    Clock::time_point nextTick = Clock::now() + tick;
+
+    while (m_Running.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_until(nextTick);
+
+        int ticks = 0;
+        while (Clock::now() >= nextTick && ticks < SIMULATION_MAX_CATCH_UP_TICKS) {
+            step();
+            nextTick += tick;
+            ticks++;
+        }
+
+        if (Clock::now() >= nextTick) {
+            nextTick = Clock::now() + tick;
+        }
+
+        // Only the latest tick is handed over, the snapshot carries the one before it for interpolation.
+        SimulationState& snapshot = m_Snapshots.GetWriteBuffer();
+        snapshot.tick = m_State.tick;
+        snapshot.time = m_State.time;
+        snapshot.previousLights = m_State.previousLights;
+        snapshot.lights = m_State.lights;
+        m_Snapshots.Publish();
+    }
+}
+
+void Simulation::step() {
+    m_State.previousLights = m_State.lights;
+    m_State.tick++;
+
+    // Positions are a function of the tick count, so they never accumulate error.
+    m_Animation.Evaluate(static_cast<double>(m_State.tick) * m_TickSeconds);
+    m_Animation.WritePositions(m_State.lights.data());
+
+    m_State.time = std::chrono::duration<double>(Clock::now() - m_Start).count();
+}
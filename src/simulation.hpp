@@ -0,0 +1,72 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "light_buffer.hpp"
+#include "light_animation.hpp"
+#include "triple_buffer.hpp"
+
+// Degrees per second the lights orbit around LIGHT_ROTATION_AXIS.
+constexpr float LIGHT_ROTATION_SPEED = 30.0f;
+const glm::vec3 LIGHT_ROTATION_AXIS = glm::vec3(1.0f, 1.0f, 1.0f);
+
+// Ticks the simulation may run back to back to catch up after a stall. Time
+// beyond that is dropped, so a long hitch slows the scene down instead of
+// making the simulation thread spiral.
+constexpr int SIMULATION_MAX_CATCH_UP_TICKS = 5;
+
+// A snapshot holds the state after a tick and the one before it, so the
+// renderer can always interpolate between consecutive ticks even when it
+// missed some of them.
+struct SimulationState {
+    uint64_t tick = 0;
+    double time = 0.0;
+    std::vector<Light> previousLights;
+    std::vector<Light> lights;
+};
+
+// Animates the scene at a fixed tick rate on its own thread and hands
+// snapshots to the render thread through a triple buffer.
+class Simulation {
+public:
+    Simulation(const std::vector<Light>& lights, double tickSeconds = 1.0 / 60.0);
+    ~Simulation();
+
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    void Start();
+    void Stop();
+
+    // Render thread only. Writes the lights as they were one tick ago,
+    // interpolated between the two ticks around that time.
+    void Sample(std::vector<Light>& lights);
+
+    // Seconds since the simulation was created, on the clock both threads use.
+    double GetTime() const;
+    double GetTickSeconds() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point m_Start;
+    double m_TickSeconds;
+
+    // Only used by the simulation thread.
+    SimulationState m_State;
+    LightAnimation m_Animation;
+
+    TripleBuffer<SimulationState> m_Snapshots;
+
+    std::atomic<bool> m_Running;
+    std::thread m_Thread;
+
+    void run();
+    void step();
+};
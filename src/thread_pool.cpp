@@ -0,0 +1,74 @@
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(size_t threadCount) : m_ActiveJobs(0), m_Stopping(false) {
+    if (threadCount == 0) {
+        size_t cores = std::thread::hardware_concurrency();
+        threadCount = cores > 1 ? cores - 1 : 1;
+    }
+
+    m_Threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        m_Threads.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+    }
+
+    m_JobAvailable.notify_all();
+
+    for (std::thread& thread : m_Threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Jobs.push_back(std::move(job));
+    }
+
+    m_JobAvailable.notify_one();
+}
+
+void ThreadPool::Wait() {
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_JobsDone.wait(lock, [this]() { return m_Jobs.empty() && m_ActiveJobs == 0; });
+}
+
+size_t ThreadPool::GetThreadCount() const {
+    return m_Threads.size();
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> job;
+
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_JobAvailable.wait(lock, [this]() { return m_Stopping || !m_Jobs.empty(); });
+
+            // Finish queued work before shutting down.
+            if (m_Jobs.empty()) {
+                return;
+            }
+
+            job = std::move(m_Jobs.front());
+            m_Jobs.pop_front();
+            m_ActiveJobs++;
+        }
+
+        job();
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_ActiveJobs--;
+            if (m_Jobs.empty() && m_ActiveJobs == 0) {
+                m_JobsDone.notify_all();
+            }
+        }
+    }
+}
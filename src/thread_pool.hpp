@@ -0,0 +1,40 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that run submitted jobs in FIFO order.
+class ThreadPool {
+public:
+    // A thread count of 0 uses one thread per hardware core minus the one the caller runs on.
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void Submit(std::function<void()> job);
+
+    // Blocks until every submitted job has finished.
+    void Wait();
+
+    size_t GetThreadCount() const;
+
+private:
+    std::vector<std::thread> m_Threads;
+    std::deque<std::function<void()>> m_Jobs;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_JobAvailable;
+    std::condition_variable m_JobsDone;
+
+    size_t m_ActiveJobs;
+    bool m_Stopping;
+
+    void workerLoop();
+};
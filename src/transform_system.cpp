@@ -0,0 +1,335 @@
+#include "transform_system.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+glm::mat3 ComputeNormalMatrix(const glm::mat4& transform) {
+    glm::vec3 x(transform[0]);
+    glm::vec3 y(transform[1]);
+    glm::vec3 z(transform[2]);
+
+    glm::vec3 cx = glm::cross(y, z);
+    glm::vec3 cy = glm::cross(z, x);
+    glm::vec3 cz = glm::cross(x, y);
+
+    // A degenerate matrix keeps the cofactors, the shader normalizes the result anyway.
+    float det = glm::dot(x, cx);
+    float inverseDet = det != 0.0f ? 1.0f / det : 1.0f;
+
+    return glm::mat3(cx * inverseDet, cy * inverseDet, cz * inverseDet);
+}
+
+// Runs body over [0, count) in TRANSFORM_BATCH_SIZE ranges, on the pool when
+// there is more than one range to hand out.
+template <typename F>
+static void forEachBatch(ThreadPool* pool, size_t count, const F& body) {
+    if (pool == nullptr || count <= TRANSFORM_BATCH_SIZE) {
+        body(0, count);
+        return;
+    }
+
+    for (size_t begin = 0; begin < count; begin += TRANSFORM_BATCH_SIZE) {
+        size_t end = std::min(count, begin + TRANSFORM_BATCH_SIZE);
+        pool->Submit([&body, begin, end]() { body(begin, end); });
+    }
+
+    pool->Wait();
+}
+
+TransformSystem::TransformSystem() : m_LevelsDirty(false) {}
+
+TransformHandle TransformSystem::Create(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale, TransformHandle parent) {
+    TransformHandle handle = static_cast<TransformHandle>(m_Parent.size());
+
+    if (parent != INVALID_TRANSFORM && parent >= handle) {
+        std::cerr << "Error: Transform parent does not exist!\n";
+        parent = INVALID_TRANSFORM;
+    }
+
+    glm::quat normalized = glm::normalize(rotation);
+
+    m_PositionX.push_back(position.x);
+    m_PositionY.push_back(position.y);
+    m_PositionZ.push_back(position.z);
+    m_RotationX.push_back(normalized.x);
+    m_RotationY.push_back(normalized.y);
+    m_RotationZ.push_back(normalized.z);
+    m_RotationW.push_back(normalized.w);
+    m_ScaleX.push_back(scale.x);
+    m_ScaleY.push_back(scale.y);
+    m_ScaleZ.push_back(scale.z);
+
+    m_Parent.push_back(parent);
+    m_Dirty.push_back(1);
+    m_Changed.push_back(0);
+
+    m_Local.emplace_back(1.0f);
+    m_World.emplace_back(1.0f);
+    m_Normal.emplace_back(1.0f);
+
+    if (parent != INVALID_TRANSFORM) {
+        m_LevelsDirty = true;
+    }
+
+    return handle;
+}
+
+void TransformSystem::Reserve(size_t count) {
+    for (std::vector<float>* stream : { &m_PositionX, &m_PositionY, &m_PositionZ, &m_RotationX, &m_RotationY, &m_RotationZ, &m_RotationW, &m_ScaleX, &m_ScaleY, &m_ScaleZ }) {
+        stream->reserve(count);
+    }
+
+    m_Parent.reserve(count);
+    m_Dirty.reserve(count);
+    m_Changed.reserve(count);
+    m_Local.reserve(count);
+    m_World.reserve(count);
+    m_Normal.reserve(count);
+}
+
+void TransformSystem::Clear() {
+    for (std::vector<float>* stream : { &m_PositionX, &m_PositionY, &m_PositionZ, &m_RotationX, &m_RotationY, &m_RotationZ, &m_RotationW, &m_ScaleX, &m_ScaleY, &m_ScaleZ }) {
+        stream->clear();
+    }
+
+    m_Parent.clear();
+    m_Dirty.clear();
+    m_Changed.clear();
+    m_BatchDirty.clear();
+    m_Local.clear();
+    m_World.clear();
+    m_Normal.clear();
+    m_Levels.clear();
+    m_LevelsDirty = false;
+    m_Stats = TransformStats();
+}
+
+void TransformSystem::SetPosition(TransformHandle handle, const glm::vec3& position) {
+    m_PositionX[handle] = position.x;
+    m_PositionY[handle] = position.y;
+    m_PositionZ[handle] = position.z;
+    markDirty(handle);
+}
+
+void TransformSystem::SetRotation(TransformHandle handle, const glm::quat& rotation) {
+    glm::quat normalized = glm::normalize(rotation);
+
+    m_RotationX[handle] = normalized.x;
+    m_RotationY[handle] = normalized.y;
+    m_RotationZ[handle] = normalized.z;
+    m_RotationW[handle] = normalized.w;
+    markDirty(handle);
+}
+
+void TransformSystem::SetRotation(TransformHandle handle, float radians, const glm::vec3& axis) {
+    SetRotation(handle, glm::angleAxis(radians, glm::normalize(axis)));
+}
+
+void TransformSystem::SetScale(TransformHandle handle, const glm::vec3& scale) {
+    m_ScaleX[handle] = scale.x;
+    m_ScaleY[handle] = scale.y;
+    m_ScaleZ[handle] = scale.z;
+    markDirty(handle);
+}
+
+void TransformSystem::SetParent(TransformHandle handle, TransformHandle parent) {
+    if (parent != INVALID_TRANSFORM && parent >= handle) {
+        std::cerr << "Error: Transform parent has to be created before its child!\n";
+        return;
+    }
+
+    m_Parent[handle] = parent;
+    m_LevelsDirty = true;
+    markDirty(handle);
+}
+
+glm::vec3 TransformSystem::GetPosition(TransformHandle handle) const {
+    return glm::vec3(m_PositionX[handle], m_PositionY[handle], m_PositionZ[handle]);
+}
+
+glm::quat TransformSystem::GetRotation(TransformHandle handle) const {
+    return glm::quat(m_RotationW[handle], m_RotationX[handle], m_RotationY[handle], m_RotationZ[handle]);
+}
+
+glm::vec3 TransformSystem::GetScale(TransformHandle handle) const {
+    return glm::vec3(m_ScaleX[handle], m_ScaleY[handle], m_ScaleZ[handle]);
+}
+
+TransformHandle TransformSystem::GetParent(TransformHandle handle) const {
+    return m_Parent[handle];
+}
+
+void TransformSystem::Update(ThreadPool* pool) {
+    size_t count = m_Parent.size();
+
+    m_Stats = TransformStats();
+    m_Stats.transforms = count;
+
+    if (m_LevelsDirty) {
+        buildLevels();
+    }
+
+    // Parents come first, so one forward pass pushes dirty flags down the whole hierarchy.
+    size_t batchCount = (count + TRANSFORM_BATCH_SIZE - 1) / TRANSFORM_BATCH_SIZE;
+    m_BatchDirty.assign(batchCount, 0);
+
+    for (size_t i = 0; i < count; i++) {
+        TransformHandle parent = m_Parent[i];
+
+        if (parent != INVALID_TRANSFORM) {
+            m_Dirty[i] |= m_Dirty[parent];
+        }
+
+        m_BatchDirty[i / TRANSFORM_BATCH_SIZE] |= m_Dirty[i];
+        m_Stats.worldUpdates += m_Dirty[i];
+    }
+
+    if (m_Stats.worldUpdates == 0) {
+        std::fill(m_Changed.begin(), m_Changed.end(), 0);
+        return;
+    }
+
+    std::vector<size_t> batches;
+    for (size_t batch = 0; batch < batchCount; batch++) {
+        if (m_BatchDirty[batch]) {
+            batches.push_back(batch);
+            m_Stats.localUpdates += std::min(count, (batch + 1) * TRANSFORM_BATCH_SIZE) - batch * TRANSFORM_BATCH_SIZE;
+        }
+    }
+
+    // Local matrices, and the world matrices of roots, one dirty batch per job.
+    if (pool == nullptr || batches.size() <= 1) {
+        for (size_t batch : batches) {
+            updateLocal(batch * TRANSFORM_BATCH_SIZE, std::min(count, (batch + 1) * TRANSFORM_BATCH_SIZE));
+        }
+    } else {
+        for (size_t batch : batches) {
+            pool->Submit([this, batch, count]() {
+                updateLocal(batch * TRANSFORM_BATCH_SIZE, std::min(count, (batch + 1) * TRANSFORM_BATCH_SIZE));
+            });
+        }
+
+        pool->Wait();
+    }
+
+    // Each level only reads world matrices of the level above it.
+    for (const std::vector<TransformHandle>& level : m_Levels) {
+        forEachBatch(pool, level.size(), [this, &level](size_t begin, size_t end) {
+            updateWorld(level.data() + begin, end - begin);
+        });
+    }
+
+    // The flags of this update become the changed set, and the old changed set is cleared for reuse.
+    m_Dirty.swap(m_Changed);
+    std::fill(m_Dirty.begin(), m_Dirty.end(), 0);
+}
+
+const glm::mat4& TransformSystem::GetWorldMatrix(TransformHandle handle) const {
+    return m_World[handle];
+}
+
+const glm::mat3& TransformSystem::GetNormalMatrix(TransformHandle handle) const {
+    return m_Normal[handle];
+}
+
+const glm::mat4* TransformSystem::GetWorldMatrices() const {
+    return m_World.data();
+}
+
+const glm::mat3* TransformSystem::GetNormalMatrices() const {
+    return m_Normal.data();
+}
+
+const uint8_t* TransformSystem::GetChanged() const {
+    return m_Changed.data();
+}
+
+size_t TransformSystem::GetCount() const {
+    return m_Parent.size();
+}
+
+const TransformStats& TransformSystem::GetStats() const {
+    return m_Stats;
+}
+
+void TransformSystem::markDirty(TransformHandle handle) {
+    m_Dirty[handle] = 1;
+}
+
+void TransformSystem::buildLevels() {
+    size_t count = m_Parent.size();
+    std::vector<uint32_t> depth(count, 0);
+
+    m_Levels.clear();
+
+    for (size_t i = 0; i < count; i++) {
+        TransformHandle parent = m_Parent[i];
+        if (parent == INVALID_TRANSFORM) {
+            continue;
+        }
+
+        depth[i] = depth[parent] + 1;
+
+        if (m_Levels.size() < depth[i]) {
+            m_Levels.resize(depth[i]);
+        }
+
+        m_Levels[depth[i] - 1].push_back(static_cast<TransformHandle>(i));
+    }
+
+    m_LevelsDirty = false;
+}
+
+void TransformSystem::updateLocal(size_t begin, size_t end) {
+    // Every transform of the batch is rebuilt, clean ones included. That keeps
+    // the loop free of branches so it vectorizes over the streams.
+    for (size_t i = begin; i < end; i++) {
+        float x = m_RotationX[i], y = m_RotationY[i], z = m_RotationZ[i], w = m_RotationW[i];
+        float sx = m_ScaleX[i], sy = m_ScaleY[i], sz = m_ScaleZ[i];
+
+        float xx = x * x, yy = y * y, zz = z * z;
+        float xy = x * y, xz = x * z, yz = y * z;
+        float wx = w * x, wy = w * y, wz = w * z;
+
+        glm::mat4& local = m_Local[i];
+
+        local[0][0] = (1.0f - 2.0f * (yy + zz)) * sx;
+        local[0][1] = 2.0f * (xy + wz) * sx;
+        local[0][2] = 2.0f * (xz - wy) * sx;
+        local[0][3] = 0.0f;
+
+        local[1][0] = 2.0f * (xy - wz) * sy;
+        local[1][1] = (1.0f - 2.0f * (xx + zz)) * sy;
+        local[1][2] = 2.0f * (yz + wx) * sy;
+        local[1][3] = 0.0f;
+
+        local[2][0] = 2.0f * (xz + wy) * sz;
+        local[2][1] = 2.0f * (yz - wx) * sz;
+        local[2][2] = (1.0f - 2.0f * (xx + yy)) * sz;
+        local[2][3] = 0.0f;
+
+        local[3][0] = m_PositionX[i];
+        local[3][1] = m_PositionY[i];
+        local[3][2] = m_PositionZ[i];
+        local[3][3] = 1.0f;
+    }
+
+    for (size_t i = begin; i < end; i++) {
+        if (m_Dirty[i] && m_Parent[i] == INVALID_TRANSFORM) {
+            m_World[i] = m_Local[i];
+            m_Normal[i] = ComputeNormalMatrix(m_World[i]);
+        }
+    }
+}
+
+void TransformSystem::updateWorld(const TransformHandle* handles, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        TransformHandle handle = handles[i];
+        if (!m_Dirty[handle]) {
+            continue;
+        }
+
+        m_World[handle] = m_World[m_Parent[handle]] * m_Local[handle];
+        m_Normal[handle] = ComputeNormalMatrix(m_World[handle]);
+    }
+}
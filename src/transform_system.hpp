@@ -0,0 +1,98 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+using TransformHandle = uint32_t;
+constexpr TransformHandle INVALID_TRANSFORM = 0xFFFFFFFFu;
+
+// Transforms per job when Update runs on a thread pool. Also the granularity
+// at which unchanged transforms are skipped in the local matrix pass.
+constexpr size_t TRANSFORM_BATCH_SIZE = 4096;
+
+struct TransformStats {
+    size_t transforms = 0;
+    size_t localUpdates = 0;
+    size_t worldUpdates = 0;
+};
+
+// Inverse transpose of the upper 3x3, built from cofactors instead of a full 4x4 inverse.
+glm::mat3 ComputeNormalMatrix(const glm::mat4& transform);
+
+// Stores position, rotation and scale of many objects in structure-of-arrays
+// form and keeps their world and normal matrices up to date. Update only
+// recomputes transforms that were changed since the last update, or whose
+// parent was.
+//
+// A parent always has a lower handle than its children, so dirty flags
+// propagate in a single forward pass and world matrices can be computed one
+// hierarchy level at a time, with each level split across threads.
+class TransformSystem {
+public:
+    TransformSystem();
+
+    TransformHandle Create(const glm::vec3& position = glm::vec3(0.0f), const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f), const glm::vec3& scale = glm::vec3(1.0f), TransformHandle parent = INVALID_TRANSFORM);
+    void Reserve(size_t count);
+    void Clear();
+
+    void SetPosition(TransformHandle handle, const glm::vec3& position);
+    void SetRotation(TransformHandle handle, const glm::quat& rotation);
+    void SetRotation(TransformHandle handle, float radians, const glm::vec3& axis);
+    void SetScale(TransformHandle handle, const glm::vec3& scale);
+
+    // The parent has to be created before the child, i.e. have a lower handle.
+    void SetParent(TransformHandle handle, TransformHandle parent);
+
+    glm::vec3 GetPosition(TransformHandle handle) const;
+    glm::quat GetRotation(TransformHandle handle) const;
+    glm::vec3 GetScale(TransformHandle handle) const;
+    TransformHandle GetParent(TransformHandle handle) const;
+
+    // Recomputes the matrices of changed transforms. Without a pool, or when
+    // there is too little work to split, everything runs on the calling thread.
+    void Update(ThreadPool* pool = nullptr);
+
+    // Valid after Update. The arrays are indexed by handle.
+    const glm::mat4& GetWorldMatrix(TransformHandle handle) const;
+    const glm::mat3& GetNormalMatrix(TransformHandle handle) const;
+    const glm::mat4* GetWorldMatrices() const;
+    const glm::mat3* GetNormalMatrices() const;
+
+    // Per handle, 1 if the world matrix was recomputed by the last Update.
+    const uint8_t* GetChanged() const;
+
+    size_t GetCount() const;
+    const TransformStats& GetStats() const;
+
+private:
+    std::vector<float> m_PositionX, m_PositionY, m_PositionZ;
+    std::vector<float> m_RotationX, m_RotationY, m_RotationZ, m_RotationW;
+    std::vector<float> m_ScaleX, m_ScaleY, m_ScaleZ;
+
+    std::vector<TransformHandle> m_Parent;
+    std::vector<uint8_t> m_Dirty;
+    std::vector<uint8_t> m_Changed;
+    std::vector<uint8_t> m_BatchDirty;
+
+    std::vector<glm::mat4> m_Local;
+    std::vector<glm::mat4> m_World;
+    std::vector<glm::mat3> m_Normal;
+
+    // Handles of child transforms grouped by depth, starting at depth 1. Roots
+    // are finished in the local pass and need no level.
+    std::vector<std::vector<TransformHandle>> m_Levels;
+    bool m_LevelsDirty;
+
+    TransformStats m_Stats;
+
+    void markDirty(TransformHandle handle);
+    void buildLevels();
+    void updateLocal(size_t begin, size_t end);
+    void updateWorld(const TransformHandle* handles, size_t count);
+};
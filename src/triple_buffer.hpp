@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free hand-over of the latest value from one writer thread to one reader
+// thread. The writer fills the back buffer and publishes it, the reader picks
+// up whatever was published last. Neither side ever waits for the other, and
+// intermediate values are skipped when the writer is faster than the reader.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : m_Middle(1), m_Back(0), m_Front(2) {}
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Writer side. Valid until the next Publish.
+    T& GetWriteBuffer() {
+        return m_Buffers[m_Back];
+    }
+
+    void Publish() {
+        uint8_t previous = m_Middle.exchange(static_cast<uint8_t>(m_Back | NEW_DATA), std::memory_order_acq_rel);
+        m_Back = previous & INDEX_MASK;
+    }
+
+    // Reader side. Swaps in the most recently published buffer, if there is
+    // one newer than the current read buffer, and returns whether it did.
+    bool Update() {
+        if ((m_Middle.load(std::memory_order_relaxed) & NEW_DATA) == 0) {
+            return false;
+        }
+
+        uint8_t previous = m_Middle.exchange(m_Front, std::memory_order_acq_rel);
+        m_Front = previous & INDEX_MASK;
+        return true;
+    }
+
+    // Valid until the next Update.
+    const T& GetReadBuffer() const {
+        return m_Buffers[m_Front];
+    }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t NEW_DATA = 0x4;
+
+    T m_Buffers[3];
+
+    // Index of the buffer between writer and reader, plus NEW_DATA while the reader has not taken it.
+    alignas(64) std::atomic<uint8_t> m_Middle;
+
+    // Each only touched by its own side.
+    alignas(64) uint8_t m_Back;
+    alignas(64) uint8_t m_Front;
+};
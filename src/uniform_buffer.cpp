@@ -0,0 +1,53 @@
+#include "uniform_buffer.hpp"
+#include "gl_state.hpp"
+
+#include <cstring>
+
+struct UniformBlockName {
+    const char* name;
+    GLuint binding;
+};
+
+static const UniformBlockName sharedBlocks[] = {
+    { "Frame", FRAME_BLOCK_BINDING },
+};
+
+GLint GetUniformBlockBinding(const char* name) {
+    for (const UniformBlockName& block : sharedBlocks) {
+        if (std::strcmp(block.name, name) == 0) {
+            return static_cast<GLint>(block.binding);
+        }
+    }
+
+    return -1;
+}
+
+UniformBuffer::UniformBuffer(GLuint binding, GLsizeiptr size) : m_UBO(0), m_Binding(binding), m_Size(size) {
+    GL_CHECK(glGenBuffers(1, &m_UBO));
+    glState.BindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+    GL_CHECK(glBufferData(GL_UNIFORM_BUFFER, m_Size, nullptr, GL_DYNAMIC_DRAW));
+    glState.BindBufferBase(GL_UNIFORM_BUFFER, m_Binding, m_UBO);
+    glState.BindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+UniformBuffer::~UniformBuffer() {
+    glState.DeleteBuffer(m_UBO);
+}
+
+void UniformBuffer::Upload(const void* data, GLsizeiptr size) const {
+    if (size > m_Size) {
+        std::cerr << "Error: Uniform buffer upload of " << size << " bytes exceeds its size of " << m_Size << " bytes!\n";
+        return;
+    }
+
+    // Orphan the previous storage so the driver does not have to wait for
+    // draws from the last frame that still read it.
+    glState.BindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+    GL_CHECK(glBufferData(GL_UNIFORM_BUFFER, m_Size, nullptr, GL_DYNAMIC_DRAW));
+    GL_CHECK(glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data));
+    glState.BindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+GLuint UniformBuffer::GetBinding() const {
+    return m_Binding;
+}
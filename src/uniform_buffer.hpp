@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "utility.hpp"
+
+// Binding points shared by every shader program. Shader binds any uniform block
+// whose name is listed in uniform_buffer.cpp to its point right after linking,
+// so a shader only has to declare the block to pick up the buffer.
+enum UniformBlockBinding : GLuint {
+    FRAME_BLOCK_BINDING = 0,
+};
+
+// Mirror of the std140 "Frame" block. vec3 members are padded to a vec4, so
+// the camera position is stored in xyz and w is unused.
+struct FrameUniforms {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 cameraPos;
+};
+
+static_assert(sizeof(FrameUniforms) == 144, "FrameUniforms must match the std140 layout of the Frame block");
+
+// Returns the binding point for the named uniform block, or -1 if the block is not a shared one.
+GLint GetUniformBlockBinding(const char* name);
+
+class UniformBuffer {
+public:
+    UniformBuffer(GLuint binding, GLsizeiptr size);
+    ~UniformBuffer();
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    void Upload(const void* data, GLsizeiptr size) const;
+
+    template <typename T>
+    void Upload(const T& data) const {
+        Upload(&data, static_cast<GLsizeiptr>(sizeof(T)));
+    }
+
+    GLuint GetBinding() const;
+
+private:
+    GLuint m_UBO;
+    GLuint m_Binding;
+    GLsizeiptr m_Size;
+};
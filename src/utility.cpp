@@ -1,5 +1,7 @@
 #include "utility.hpp"
 
+bool glErrorChecks = true;
+
 void checkOpenGLError(const char* function, const char* file, int line) {
     GLenum error;
     while ((error = glGetError()) != GL_NO_ERROR) {
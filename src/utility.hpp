@@ -4,6 +4,28 @@
 
 #include <iostream>
 
-#define GL_CHECK(x) do { x; checkOpenGLError(#x, __FILE__, __LINE__); } while (0)
+// How much GL error checking is compiled in:
+//   0 - none, GL_CHECK is just the call.
+//   1 - debug output through KHR_debug, or one glGetError poll per frame
+//       without it. GL_CHECK is still just the call.
+//   2 - as 1, but with synchronous debug output, and GL_CHECK falls back to
+//       glGetError after every call on contexts without KHR_debug.
+// Defaults to 2 for debug builds and 0 when NDEBUG is set.
+#ifndef GL_DEBUG_LEVEL
+#ifdef NDEBUG
+#define GL_DEBUG_LEVEL 0
+#else
+#define GL_DEBUG_LEVEL 2
+#endif
+#endif
+
+#if GL_DEBUG_LEVEL >= 2
+#define GL_CHECK(x) do { x; if (glErrorChecks) checkOpenGLError(#x, __FILE__, __LINE__); } while (0)
+#else
+#define GL_CHECK(x) do { x; } while (0)
+#endif
+
+// Cleared by GLDebug once debug output has taken over error reporting.
+extern bool glErrorChecks;
 
 void checkOpenGLError(const char* function, const char* file, int line);
\ No newline at end of file
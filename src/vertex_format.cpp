@@ -0,0 +1,171 @@
+#include "vertex_format.hpp"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+glm::vec2 EncodeOctahedral(const glm::vec3& normal) {
+    float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    glm::vec2 projected(normal.x / sum, normal.y / sum);
+
+    // Fold the lower hemisphere over the diagonals.
+    if (normal.z < 0.0f) {
+        float x = (1.0f - std::abs(projected.y)) * (projected.x >= 0.0f ? 1.0f : -1.0f);
+        float y = (1.0f - std::abs(projected.x)) * (projected.y >= 0.0f ? 1.0f : -1.0f);
+        projected = glm::vec2(x, y);
+    }
+
+    return projected;
+}
+
+glm::vec3 DecodeOctahedral(const glm::vec2& encoded) {
+    glm::vec3 normal(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+    float t = std::max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -t : t;
+    normal.y += normal.y >= 0.0f ? -t : t;
+
+    return glm::normalize(normal);
+}
+
+static void writeBytes(unsigned char* destination, const void* source, size_t size) {
+    std::memcpy(destination, source, size);
+}
+
+std::vector<unsigned char> PackVertices(const VertexFormat& format, const float* positions, const float* normals, const float* colors, const float* texCoords, size_t vertexCount, VertexLayout& layout) {
+    layout = VertexLayout();
+    uint32_t location = 0;
+
+    // Every attribute is padded to a multiple of four bytes, which is what most hardware fetches at.
+    uint32_t positionOffset = layout.stride;
+    switch (format.position) {
+    case POSITION_FLOAT32:
+        layout.Add(location++, 3, GL_FLOAT, false, 3 * sizeof(float));
+        break;
+    case POSITION_HALF:
+        layout.Add(location++, 3, GL_HALF_FLOAT, false, 4 * sizeof(uint16_t));
+        break;
+    case POSITION_SNORM16:
+        layout.Add(location++, 3, GL_SHORT, true, 4 * sizeof(int16_t));
+        break;
+    }
+
+    uint32_t normalOffset = layout.stride;
+    if (normals) {
+        switch (format.normal) {
+        case NORMAL_FLOAT32:
+            layout.Add(location++, 3, GL_FLOAT, false, 3 * sizeof(float));
+            break;
+        case NORMAL_INT_2_10_10_10:
+            layout.Add(location++, 4, GL_INT_2_10_10_10_REV, true, sizeof(uint32_t));
+            break;
+        case NORMAL_OCTAHEDRAL:
+            layout.Add(location++, 2, GL_SHORT, true, 2 * sizeof(int16_t));
+            layout.flags |= VERTEX_LAYOUT_OCTAHEDRAL_NORMALS;
+            break;
+        }
+    }
+
+    uint32_t colorOffset = layout.stride;
+    if (colors) {
+        switch (format.color) {
+        case COLOR_FLOAT32:
+            layout.Add(location++, 3, GL_FLOAT, false, 3 * sizeof(float));
+            break;
+        case COLOR_UNORM8:
+            layout.Add(location++, 4, GL_UNSIGNED_BYTE, true, 4 * sizeof(uint8_t));
+            break;
+        }
+    }
+
+    uint32_t texCoordOffset = layout.stride;
+    if (texCoords) {
+        layout.Add(location++, 2, GL_FLOAT, false, 2 * sizeof(float));
+    }
+
+    // SNORM16 positions are quantized inside the bounding box of the mesh.
+    if (format.position == POSITION_SNORM16 && vertexCount > 0) {
+        glm::vec3 minimum(positions[0], positions[1], positions[2]);
+        glm::vec3 maximum = minimum;
+        for (size_t i = 1; i < vertexCount; i++) {
+            glm::vec3 position(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]);
+            minimum = glm::min(minimum, position);
+            maximum = glm::max(maximum, position);
+        }
+
+        glm::vec3 center = (minimum + maximum) * 0.5f;
+        glm::vec3 extent = (maximum - minimum) * 0.5f;
+        for (int axis = 0; axis < 3; axis++) {
+            layout.positionOffset[axis] = center[axis];
+            layout.positionScale[axis] = extent[axis] > 0.0f ? extent[axis] : 1.0f;
+        }
+    }
+
+    std::vector<unsigned char> data(vertexCount * layout.stride, 0);
+
+    for (size_t i = 0; i < vertexCount; i++) {
+        unsigned char* vertex = &data[i * layout.stride];
+        const float* position = &positions[i * 3];
+
+        switch (format.position) {
+        case POSITION_FLOAT32:
+            writeBytes(vertex + positionOffset, position, 3 * sizeof(float));
+            break;
+        case POSITION_HALF: {
+            uint16_t packed[3] = { glm::packHalf1x16(position[0]), glm::packHalf1x16(position[1]), glm::packHalf1x16(position[2]) };
+            writeBytes(vertex + positionOffset, packed, sizeof(packed));
+            break;
+        }
+        case POSITION_SNORM16: {
+            uint16_t packed[3];
+            for (int axis = 0; axis < 3; axis++) {
+                packed[axis] = glm::packSnorm1x16((position[axis] - layout.positionOffset[axis]) / layout.positionScale[axis]);
+            }
+
+            writeBytes(vertex + positionOffset, packed, sizeof(packed));
+            break;
+        }
+        }
+
+        if (normals) {
+            glm::vec3 normal(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]);
+
+            switch (format.normal) {
+            case NORMAL_FLOAT32:
+                writeBytes(vertex + normalOffset, &normals[i * 3], 3 * sizeof(float));
+                break;
+            case NORMAL_INT_2_10_10_10: {
+                uint32_t packed = glm::packSnorm3x10_1x2(glm::vec4(normal, 0.0f));
+                writeBytes(vertex + normalOffset, &packed, sizeof(packed));
+                break;
+            }
+            case NORMAL_OCTAHEDRAL: {
+                glm::vec2 encoded = EncodeOctahedral(normal);
+                uint16_t packed[2] = { glm::packSnorm1x16(encoded.x), glm::packSnorm1x16(encoded.y) };
+                writeBytes(vertex + normalOffset, packed, sizeof(packed));
+                break;
+            }
+            }
+        }
+
+        if (colors) {
+            switch (format.color) {
+            case COLOR_FLOAT32:
+                writeBytes(vertex + colorOffset, &colors[i * 3], 3 * sizeof(float));
+                break;
+            case COLOR_UNORM8: {
+                uint32_t packed = glm::packUnorm4x8(glm::vec4(colors[i * 3], colors[i * 3 + 1], colors[i * 3 + 2], 1.0f));
+                writeBytes(vertex + colorOffset, &packed, sizeof(packed));
+                break;
+            }
+            }
+        }
+
+        if (texCoords) {
+            writeBytes(vertex + texCoordOffset, &texCoords[i * 2], 2 * sizeof(float));
+        }
+    }
+
+    return data;
+}
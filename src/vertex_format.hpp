@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "vertex_layout.hpp"
+
+enum PositionFormat {
+    POSITION_FLOAT32,
+    POSITION_HALF,      // 3 x 16-bit float, 8 bytes
+    POSITION_SNORM16,   // 3 x normalized int16 in the mesh bounds, 8 bytes
+};
+
+enum NormalFormat {
+    NORMAL_FLOAT32,
+    NORMAL_INT_2_10_10_10,  // GL_INT_2_10_10_10_REV, 4 bytes
+    NORMAL_OCTAHEDRAL,      // 2 x normalized int16 octahedral encoding, 4 bytes
+};
+
+enum ColorFormat {
+    COLOR_FLOAT32,
+    COLOR_UNORM8,       // 4 x normalized uint8, 4 bytes
+};
+
+// Storage formats for the attributes of a vertex. Everything defaults to 32-bit
+// floats; the packed formats trade a little precision for vertex fetch bandwidth.
+struct VertexFormat {
+    PositionFormat position = POSITION_FLOAT32;
+    NormalFormat normal = NORMAL_FLOAT32;
+    ColorFormat color = COLOR_FLOAT32;
+};
+
+// Interleaves separate attribute streams into vertices of the given format and
+// describes the result in layout. normals, colors and texCoords may be null.
+// Attributes get consecutive locations starting at 0 in the order position,
+// normal, color, texture coordinate.
+std::vector<unsigned char> PackVertices(const VertexFormat& format, const float* positions, const float* normals, const float* colors, const float* texCoords, size_t vertexCount, VertexLayout& layout);
+
+// Octahedral normal encoding, mapping a unit vector onto the [-1, 1] square.
+glm::vec2 EncodeOctahedral(const glm::vec3& normal);
+glm::vec3 DecodeOctahedral(const glm::vec2& encoded);
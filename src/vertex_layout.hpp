@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+constexpr uint32_t MAX_VERTEX_ATTRIBUTES = 8;
+
+// Set in VertexLayout::flags when the normal attribute holds two octahedral
+// components that the vertex shader has to decode.
+constexpr uint32_t VERTEX_LAYOUT_OCTAHEDRAL_NORMALS = 1u << 0;
+
+// Describes one attribute of an interleaved vertex. Fields map directly onto the
+// arguments of glVertexAttribPointer and are fixed-size so a layout can be stored
+// in a file as is.
+struct VertexAttribute {
+    uint32_t location;
+    uint32_t components;
+    uint32_t type;
+    uint32_t normalized;
+    uint32_t offset;
+};
+
+struct VertexLayout {
+    uint32_t stride;
+    uint32_t attributeCount;
+    VertexAttribute attributes[MAX_VERTEX_ATTRIBUTES];
+    uint32_t flags;
+
+    // Quantized positions are stored in [-1, 1] and mapped back to object space
+    // with position * positionScale + positionOffset.
+    float positionScale[3];
+    float positionOffset[3];
+
+    VertexLayout() : stride(0), attributeCount(0), attributes(), flags(0), positionScale{ 1.0f, 1.0f, 1.0f }, positionOffset{ 0.0f, 0.0f, 0.0f } {}
+
+    // Appends an attribute of the given size in bytes after the ones already added.
+    bool Add(uint32_t location, uint32_t components, uint32_t type, bool normalized, uint32_t size) {
+        if (attributeCount >= MAX_VERTEX_ATTRIBUTES) {
+            return false;
+        }
+
+        attributes[attributeCount++] = { location, components, type, normalized ? 1u : 0u, stride };
+        stride += size;
+        return true;
+    }
+};
@@ -0,0 +1,207 @@
+// Converts a Wavefront OBJ file into the binary mesh format read by Model.
+//
+//     obj2mesh <input.obj> <output.mesh> [options]
+//
+//     --no-normals                          drop vertex normals
+//     --no-texcoords                        drop texture coordinates
+//     --positions=float|half|snorm16        position storage format
+//     --normals=float|int2101010|octahedral normal storage format
+//
+// Faces are triangulated as fans, identical vertices are welded and the
+// triangles are reordered for the vertex cache, so the output can be uploaded
+// without any further processing.
+
+#include <glad/glad.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mesh_file.hpp"
+#include "mesh_optimizer.hpp"
+#include "vertex_format.hpp"
+
+struct ObjIndex {
+    long position;
+    long texCoord;
+    long normal;
+};
+
+// Resolves a 1-based (or negative, relative) OBJ index into a 0-based one, or -1 when absent.
+static long resolveIndex(const std::string& token, size_t count) {
+    if (token.empty()) {
+        return -1;
+    }
+
+    long index = std::strtol(token.c_str(), nullptr, 10);
+    if (index < 0) {
+        return static_cast<long>(count) + index;
+    }
+
+    return index - 1;
+}
+
+static ObjIndex parseFaceVertex(const std::string& token, size_t positions, size_t texCoords, size_t normals) {
+    std::string parts[3];
+    size_t part = 0;
+    for (char c : token) {
+        if (c == '/') {
+            if (++part > 2) {
+                break;
+            }
+        } else {
+            parts[part] += c;
+        }
+    }
+
+    return { resolveIndex(parts[0], positions), resolveIndex(parts[1], texCoords), resolveIndex(parts[2], normals) };
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: obj2mesh <input.obj> <output.mesh> [--no-normals] [--no-texcoords] [--positions=float|half|snorm16] [--normals=float|int2101010|octahedral]\n";
+        return EXIT_FAILURE;
+    }
+
+    bool keepNormals = true;
+    bool keepTexCoords = true;
+    VertexFormat format;
+
+    for (int i = 3; i < argc; i++) {
+        std::string option = argv[i];
+
+        if (option == "--no-normals") {
+            keepNormals = false;
+        } else if (option == "--no-texcoords") {
+            keepTexCoords = false;
+        } else if (option == "--positions=float") {
+            format.position = POSITION_FLOAT32;
+        } else if (option == "--positions=half") {
+            format.position = POSITION_HALF;
+        } else if (option == "--positions=snorm16") {
+            format.position = POSITION_SNORM16;
+        } else if (option == "--normals=float") {
+            format.normal = NORMAL_FLOAT32;
+        } else if (option == "--normals=int2101010") {
+            format.normal = NORMAL_INT_2_10_10_10;
+        } else if (option == "--normals=octahedral") {
+            format.normal = NORMAL_OCTAHEDRAL;
+        } else {
+            std::cerr << "Unknown option \"" << argv[i] << "\"\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::ifstream input(argv[1]);
+    if (!input) {
+        std::cerr << "ERROR: Failed to open \"" << argv[1] << "\"\n";
+        return EXIT_FAILURE;
+    }
+
+    std::vector<float> positions, normals, texCoords;
+    std::vector<ObjIndex> corners;
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(input, line)) {
+        lineNumber++;
+
+        std::istringstream stream(line);
+        std::string keyword;
+        stream >> keyword;
+
+        if (keyword == "v") {
+            float x = 0.0f, y = 0.0f, z = 0.0f;
+            stream >> x >> y >> z;
+            positions.insert(positions.end(), { x, y, z });
+        } else if (keyword == "vn") {
+            float x = 0.0f, y = 0.0f, z = 0.0f;
+            stream >> x >> y >> z;
+            normals.insert(normals.end(), { x, y, z });
+        } else if (keyword == "vt") {
+            float u = 0.0f, v = 0.0f;
+            stream >> u >> v;
+            texCoords.insert(texCoords.end(), { u, v });
+        } else if (keyword == "f") {
+            std::vector<ObjIndex> face;
+            std::string token;
+            while (stream >> token) {
+                face.push_back(parseFaceVertex(token, positions.size() / 3, texCoords.size() / 2, normals.size() / 3));
+            }
+
+            if (face.size() < 3) {
+                std::cerr << "Warning: Skipping degenerate face on line " << lineNumber << "\n";
+                continue;
+            }
+
+            for (size_t i = 1; i + 1 < face.size(); i++) {
+                corners.push_back(face[0]);
+                corners.push_back(face[i]);
+                corners.push_back(face[i + 1]);
+            }
+        }
+    }
+
+    bool hasNormals = keepNormals && !normals.empty();
+    bool hasTexCoords = keepTexCoords && !texCoords.empty();
+
+    // Expand the corners into separate streams that are then packed by
+    // PackVertices, as Model does for in-memory geometry. The attributes that
+    // are kept get consecutive locations and offsets in the order position,
+    // normal, texture coordinate, so without normals the texture coordinates
+    // move to location 1 and the shader has to expect them there.
+    std::vector<float> cornerPositions, cornerNormals, cornerTexCoords;
+    cornerPositions.reserve(corners.size() * 3);
+
+    for (const ObjIndex& corner : corners) {
+        if (corner.position < 0 || static_cast<size_t>(corner.position) >= positions.size() / 3) {
+            std::cerr << "ERROR: Face references a missing position\n";
+            return EXIT_FAILURE;
+        }
+
+        cornerPositions.insert(cornerPositions.end(), &positions[corner.position * 3], &positions[corner.position * 3] + 3);
+
+        if (hasNormals) {
+            if (corner.normal >= 0 && static_cast<size_t>(corner.normal) < normals.size() / 3) {
+                cornerNormals.insert(cornerNormals.end(), &normals[corner.normal * 3], &normals[corner.normal * 3] + 3);
+            } else {
+                cornerNormals.insert(cornerNormals.end(), { 0.0f, 0.0f, 1.0f });
+            }
+        }
+
+        if (hasTexCoords) {
+            if (corner.texCoord >= 0 && static_cast<size_t>(corner.texCoord) < texCoords.size() / 2) {
+                cornerTexCoords.insert(cornerTexCoords.end(), &texCoords[corner.texCoord * 2], &texCoords[corner.texCoord * 2] + 2);
+            } else {
+                cornerTexCoords.insert(cornerTexCoords.end(), { 0.0f, 0.0f });
+            }
+        }
+    }
+
+    VertexLayout layout;
+    std::vector<unsigned char> vertices = PackVertices(format, cornerPositions.data(), hasNormals ? cornerNormals.data() : nullptr, nullptr, hasTexCoords ? cornerTexCoords.data() : nullptr, corners.size(), layout);
+
+    std::vector<uint32_t> indices = WeldVertices(vertices, layout.stride);
+    size_t vertexCount = vertices.size() / layout.stride;
+
+    OptimizeVertexCache(indices, vertexCount);
+    OptimizeVertexFetch(vertices, layout.stride, indices);
+
+    bool written;
+    if (vertexCount <= UINT16_MAX) {
+        std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+        written = WriteMeshFile(argv[2], layout, vertices.data(), static_cast<uint32_t>(vertexCount), shortIndices.data(), static_cast<uint32_t>(shortIndices.size()), GL_UNSIGNED_SHORT);
+    } else {
+        written = WriteMeshFile(argv[2], layout, vertices.data(), static_cast<uint32_t>(vertexCount), indices.data(), static_cast<uint32_t>(indices.size()), GL_UNSIGNED_INT);
+    }
+
+    if (!written) {
+        return EXIT_FAILURE;
+    }
+
+    std::cout << argv[2] << ": " << vertexCount << " vertices of " << layout.stride << " bytes, " << indices.size() / 3 << " triangles\n";
+    return EXIT_SUCCESS;
+}